@@ -1,170 +1,523 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <sys/mman.h>
+#include <algorithm>
+#include <chrono>
+
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
 static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances,
+                                     ReplacerType replacer_type, size_t lru_k, bool huge_pages)
     : pool_size_(pool_size), disk_manager_(disk_manager) {
-    pages_ = new Page[pool_size_];
-    replacer_ = new LRUReplacer(pool_size_);
+    ASSERT(num_instances > 0, "Buffer pool needs at least one instance.");
+    if (num_instances > pool_size_) {
+        num_instances = pool_size_ > 0 ? pool_size_ : 1;
+    }
+    // anonymous mappings are page aligned and zero filled, huge pages additionally need 2 MB alignment
+    slab_size_ = max<size_t>(pool_size_, 1) * PAGE_SIZE;
+    size_t alignment = huge_pages ? HUGE_PAGE_SIZE : PAGE_SIZE;
+    slab_mapping_size_ = slab_size_ + alignment - PAGE_SIZE;
+    slab_mapping_ = mmap(nullptr, slab_mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT(slab_mapping_ != MAP_FAILED, "Cannot allocate buffer pool frames.");
+    auto address = reinterpret_cast<uintptr_t>(slab_mapping_);
+    slab_ = reinterpret_cast<char *>((address + alignment - 1) / alignment * alignment);
+    if (huge_pages && madvise(slab_, slab_size_, MADV_HUGEPAGE) != 0) {
+        LOG(WARNING) << "Transparent huge pages are not available for the buffer pool.";
+    }
+    pages_ = static_cast<Page *>(operator new[](pool_size_ * sizeof(Page)));
     for (size_t i = 0; i < pool_size_; i++) {
-        free_list_.emplace_back(i);
+        new (&pages_[i]) Page(slab_ + i * PAGE_SIZE);
     }
+    // split the frames evenly, the first `pool_size_ % num_instances` instances get one extra frame
+    size_t offset = 0;
+    for (size_t i = 0; i < num_instances; i++) {
+        auto instance = new BufferPoolInstance();
+        instance->pages_ = pages_ + offset;
+        instance->pool_size_ = pool_size_ / num_instances + (i < pool_size_ % num_instances ? 1 : 0);
+        switch (replacer_type) {
+            case ReplacerType::CLOCK:
+                instance->replacer_ = new CLOCKReplacer(instance->pool_size_);
+                break;
+            case ReplacerType::LRU_K:
+                instance->replacer_ = new LRUKReplacer(instance->pool_size_, lru_k);
+                break;
+            default:
+                instance->replacer_ = new LRUReplacer(instance->pool_size_);
+                break;
+        }
+        for (size_t j = 0; j < instance->pool_size_; j++) {
+            instance->free_list_.emplace_back(j);
+        }
+        offset += instance->pool_size_;
+        instances_.push_back(instance);
+    }
+    writer_thread_ = thread(&BufferPoolManager::BackgroundWriter, this);
 }
 
 BufferPoolManager::~BufferPoolManager() {
-    for (auto page : page_table_) {
-        FlushPage(page.first);
+    {
+        std::scoped_lock<std::mutex> lock(background_latch_);
+        shutdown_ = true;
+        prefetch_queue_.clear();
+    }
+    prefetch_cv_.notify_all();
+    writer_cv_.notify_all();
+    for (auto &thread : prefetch_threads_) {
+        thread.join();
     }
-    delete[] pages_;
-    delete replacer_;
+    writer_thread_.join();
+    FlushAllPages();
+    for (auto instance : instances_) {
+        delete instance->replacer_;
+        delete instance;
+    }
+    for (size_t i = 0; i < pool_size_; i++) {
+        pages_[i].~Page();
+    }
+    operator delete[](pages_);
+    munmap(slab_mapping_, slab_mapping_size_);
 }
 
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-    latch_.lock();
+Page *BufferPoolManager::FetchPage(page_id_t page_id) { return FetchPage(page_id, nullptr); }
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferRing *ring) {
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::unique_lock<std::recursive_mutex> lock(instance.latch_);
     // 1.     Search the page table for the requested page (P).
     // 1.1    If P exists, pin it and return it immediately.
-    if (page_table_.find(page_id) != page_table_.end()) {
-        frame_id_t frame_id = page_table_[page_id];
-        replacer_->Pin(frame_id);
-        pages_[frame_id].pin_count_++;
-        latch_.unlock();
-        return &pages_[frame_id];
+    auto it = FindPage(instance, page_id, lock);
+    if (it != instance.page_table_.end()) {
+        frame_id_t frame_id = it->second;
+        instance.replacer_->Pin(frame_id);
+        instance.pages_[frame_id].pin_count_++;
+        instance.stats_.hits_++;
+        if (ring != nullptr) {
+            instance.stats_.ring_hits_++;
+        }
+        return &instance.pages_[frame_id];
     }
     // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
     //        Note that pages are always found from the free list first.
     // 2.     If R is dirty, write it back to the disk.
     // 3.     Delete R from the page table and insert P.
     // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-    frame_id_t frame_id = TryToFindFreePage();
-    if (frame_id == INVALID_PAGE_ID) {
-        latch_.unlock();
+    instance.stats_.misses_++;
+    frame_id_t frame_id;
+    if (ring != nullptr) {
+        InitRing(*ring);
+        instance.stats_.ring_misses_++;
+        frame_id = TryToFindRingFrame(instance, *ring, page_id);
+    } else {
+        frame_id = TryToFindFreePage(instance);
+    }
+    if (frame_id == INVALID_FRAME_ID) {
         return nullptr;
     }
-    page_table_[page_id] = frame_id;
-    disk_manager_->ReadPage(page_id, pages_[frame_id].data_);
-    pages_[frame_id].page_id_ = page_id;
-    pages_[frame_id].pin_count_ = 1;
-    pages_[frame_id].is_dirty_ = false;
-    replacer_->Pin(frame_id);
-    latch_.unlock();
-    return &pages_[frame_id];
+    Page &page = instance.pages_[frame_id];
+    instance.page_table_[page_id] = frame_id;
+    disk_manager_->ReadPage(page_id, page.data_);
+    page.page_id_ = page_id;
+    page.pin_count_ = 1;
+    page.is_dirty_ = false;
+    instance.replacer_->Pin(frame_id);
+    return &page;
 }
 
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-    latch_.lock();
+Page *BufferPoolManager::NewPage(page_id_t &page_id, page_id_t hint) {
     // 0.   Make sure you call AllocatePage!
-    // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-    if (free_list_.size() == 0 && replacer_->Size() == 0) {
-        latch_.unlock();
-        return nullptr;
+    //      The page id decides which instance the page belongs to, so allocate it first and give it back if the
+    //      instance has no frame left.
+    //      A stale copy of a freed page may still be cached and pinned (e.g. being read ahead by a scan). Its id is
+    //      skipped, a second frame under the same id would get the unpins meant for the stale one. The skipped ids
+    //      stay allocated until another id is found, so the disk manager does not hand them out again.
+    vector<page_id_t> skipped_page_ids;
+    Page *page = nullptr;
+    while (page == nullptr) {
+        page_id_t new_page_id = AllocatePage(hint);
+        if (new_page_id == INVALID_PAGE_ID) {
+            break;
+        }
+        BufferPoolInstance &instance = GetInstance(new_page_id);
+        std::unique_lock<std::recursive_mutex> lock(instance.latch_);
+        // 1.   If all the pages in the buffer pool are pinned, return nullptr.
+        // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
+        //      An unpinned stale copy of the freed page reuses its frame.
+        frame_id_t frame_id;
+        auto it = FindPage(instance, new_page_id, lock);
+        if (it != instance.page_table_.end()) {
+            if (instance.pages_[it->second].pin_count_ != 0 || instance.pages_[it->second].writeback_) {
+                skipped_page_ids.push_back(new_page_id);
+                continue;
+            }
+            frame_id = it->second;
+            instance.page_table_.erase(it);
+        } else {
+            frame_id = TryToFindFreePage(instance);
+        }
+        if (frame_id == INVALID_FRAME_ID) {
+            DeallocatePage(new_page_id);
+            break;
+        }
+        // 3.   Update P's metadata, zero out memory and add P to the page table.
+        // 4.   Set the page ID output parameter. Return a pointer to P.
+        page_id = new_page_id;
+        page = &instance.pages_[frame_id];
+        instance.page_table_[page_id] = frame_id;
+        page->page_id_ = page_id;
+        page->pin_count_ = 1;
+        page->is_dirty_ = false;
+        page->ResetMemory();
+        instance.replacer_->Pin(frame_id);
     }
-    // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-    // 3.   Update P's metadata, zero out memory and add P to the page table.
-    // 4.   Set the page ID output parameter. Return a pointer to P.
-    frame_id_t frame_id = TryToFindFreePage();
-    if (frame_id == INVALID_PAGE_ID) {
-        latch_.unlock();
-        return nullptr;
+    for (auto skipped_page_id : skipped_page_ids) {
+        DeallocatePage(skipped_page_id);
     }
-    page_id = AllocatePage();
-    page_table_[page_id] = frame_id;
-    pages_[frame_id].page_id_ = page_id;
-    pages_[frame_id].pin_count_ = 1;
-    pages_[frame_id].is_dirty_ = false;
-    pages_[frame_id].ResetMemory();
-    replacer_->Pin(frame_id);
-    latch_.unlock();
-    return &pages_[frame_id];
+    return page;
 }
 
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-    latch_.lock();
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::unique_lock<std::recursive_mutex> lock(instance.latch_);
     // 0.   Make sure you call DeallocatePage!
     // 1.   Search the page table for the requested page (P).
-    // 1.   If P does not exist, return true.
-    if (page_table_.find(page_id) == page_table_.end()) {
-        latch_.unlock();
+    // 1.   If P does not exist, free it on disk and return true.
+    auto it = FindPage(instance, page_id, lock);
+    // the frame of a page being written back cannot be recycled before the write is done
+    while (it != instance.page_table_.end() && instance.pages_[it->second].writeback_) {
+        WaitForWriteBack(instance, it->second, lock);
+        it = FindPage(instance, page_id, lock);
+    }
+    if (it == instance.page_table_.end()) {
+        DeallocatePage(page_id);
         return true;
     }
     // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-    frame_id_t frame_id = page_table_[page_id];
-    if (pages_[frame_id].pin_count_ != 0) {
-        latch_.unlock();
+    frame_id_t frame_id = it->second;
+    Page &page = instance.pages_[frame_id];
+    if (page.pin_count_ != 0) {
         return false;
     }
     // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free
-    // list.
+    // list. The frame must leave the replacer, otherwise it could be handed out twice.
     DeallocatePage(page_id);
-    page_table_.erase(page_id);
-    pages_[frame_id].page_id_ = INVALID_PAGE_ID;
-    pages_[frame_id].pin_count_ = 0;
-    pages_[frame_id].is_dirty_ = false;
-    pages_[frame_id].ResetMemory();
-    replacer_->Unpin(frame_id);
-    free_list_.push_back(frame_id);
-    latch_.unlock();
+    instance.page_table_.erase(it);
+    page.page_id_ = INVALID_PAGE_ID;
+    page.pin_count_ = 0;
+    page.is_dirty_ = false;
+    page.ResetMemory();
+    instance.replacer_->Remove(frame_id);
+    instance.free_list_.push_back(frame_id);
     return true;
 }
 
+void BufferPoolManager::PrefetchPages(const vector<page_id_t> &page_ids, const shared_ptr<BufferRing> &ring) {
+    if (page_ids.empty()) {
+        return;
+    }
+    if (ring != nullptr) {
+        InitRing(*ring);
+    }
+    {
+        std::scoped_lock<std::mutex> lock(background_latch_);
+        if (prefetch_threads_.empty()) {
+            for (int i = 0; i < DEFAULT_PREFETCH_THREADS; i++) {
+                prefetch_threads_.emplace_back(&BufferPoolManager::PrefetchWorker, this);
+            }
+        }
+        for (auto page_id : page_ids) {
+            if (page_id != INVALID_PAGE_ID) {
+                prefetch_queue_.push_back({page_id, ring});
+            }
+        }
+    }
+    prefetch_cv_.notify_all();
+}
+
+bool BufferPoolManager::IsPageCached(page_id_t page_id) {
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::scoped_lock<std::recursive_mutex> lock(instance.latch_);
+    return instance.page_table_.find(page_id) != instance.page_table_.end();
+}
+
+bool BufferPoolManager::IsPagePinned(page_id_t page_id) {
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::scoped_lock<std::recursive_mutex> lock(instance.latch_);
+    auto it = instance.page_table_.find(page_id);
+    return it != instance.page_table_.end() && instance.pages_[it->second].pin_count_ != 0;
+}
+
+bool BufferPoolManager::PeekPage(page_id_t page_id, size_t offset, size_t size, void *data) {
+    ASSERT(offset + size <= PAGE_SIZE, "Peek past the end of the page.");
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::scoped_lock<std::recursive_mutex> lock(instance.latch_);
+    auto it = instance.page_table_.find(page_id);
+    if (it == instance.page_table_.end()) {
+        return false;
+    }
+    // the page latch must never be waited for under the instance latch, a writer holding it may be fetching a page
+    Page &page = instance.pages_[it->second];
+    if (page.io_pending_ || !page.TryRLatch()) {
+        return false;
+    }
+    memcpy(data, page.data_ + offset, size);
+    page.RUnlatch();
+    return true;
+}
+
+unordered_map<page_id_t, frame_id_t>::iterator BufferPoolManager::FindPage(BufferPoolInstance &instance,
+                                                                           page_id_t page_id,
+                                                                           unique_lock<recursive_mutex> &lock) {
+    auto it = instance.page_table_.find(page_id);
+    while (it != instance.page_table_.end() && instance.pages_[it->second].io_pending_) {
+        instance.io_cv_.wait(lock);
+        // the read may have failed and the frame given back
+        it = instance.page_table_.find(page_id);
+    }
+    return it;
+}
+
+void BufferPoolManager::PrefetchWorker() {
+    for (;;) {
+        vector<PrefetchRequest> requests;
+        {
+            std::unique_lock<std::mutex> lock(background_latch_);
+            prefetch_cv_.wait(lock, [this] { return shutdown_ || !prefetch_queue_.empty(); });
+            if (shutdown_) {
+                return;
+            }
+            while (!prefetch_queue_.empty() && requests.size() < PREFETCH_BATCH_SIZE) {
+                requests.push_back(std::move(prefetch_queue_.front()));
+                prefetch_queue_.pop_front();
+            }
+        }
+        // submit the reads of each instance as one batch
+        vector<vector<PrefetchRequest>> batches(instances_.size());
+        for (auto &request : requests) {
+            batches[GetInstanceIndex(request.page_id_)].push_back(std::move(request));
+        }
+        for (size_t i = 0; i < batches.size(); i++) {
+            if (!batches[i].empty()) {
+                LoadPages(*instances_[i], batches[i]);
+            }
+        }
+    }
+}
+
+void BufferPoolManager::LoadPages(BufferPoolInstance &instance, const vector<PrefetchRequest> &requests) {
+    std::unique_lock<std::recursive_mutex> lock(instance.latch_);
+    vector<frame_id_t> frames;
+    for (auto &request : requests) {
+        page_id_t page_id = request.page_id_;
+        if (instance.page_table_.find(page_id) != instance.page_table_.end()) {
+            continue;
+        }
+        frame_id_t frame_id = request.ring_ != nullptr ? TryToFindRingFrame(instance, *request.ring_, page_id)
+                                                       : TryToFindFreePage(instance);
+        if (frame_id == INVALID_FRAME_ID) {
+            break;
+        }
+        Page &page = instance.pages_[frame_id];
+        instance.page_table_[page_id] = frame_id;
+        page.page_id_ = page_id;
+        // keep the frame pinned while the read is in flight, so nobody recycles it, and make FetchPage wait for it
+        page.pin_count_ = 1;
+        page.is_dirty_ = false;
+        page.io_pending_ = true;
+        frames.push_back(frame_id);
+    }
+    if (frames.empty()) {
+        return;
+    }
+    // the frames are reserved, do the I/O without blocking the rest of the instance
+    lock.unlock();
+    vector<IOHandle> reads;
+    reads.reserve(frames.size());
+    for (auto frame_id : frames) {
+        Page &page = instance.pages_[frame_id];
+        reads.push_back(disk_manager_->ReadPageAsync(page.page_id_, page.data_));
+    }
+    disk_manager_->SubmitAsync();
+    vector<bool> done;
+    done.reserve(reads.size());
+    for (auto &read : reads) {
+        done.push_back(read.Wait());
+    }
+    lock.lock();
+    for (size_t i = 0; i < frames.size(); i++) {
+        frame_id_t frame_id = frames[i];
+        Page &page = instance.pages_[frame_id];
+        page.pin_count_ = 0;
+        page.io_pending_ = false;
+        if (!done[i]) {
+            LOG(ERROR) << "Read ahead of page " << page.page_id_ << " failed.";
+            instance.page_table_.erase(page.page_id_);
+            page.page_id_ = INVALID_PAGE_ID;
+            instance.free_list_.push_back(frame_id);
+            continue;
+        }
+        // count the read as one access, then hand the frame to the replacer
+        instance.replacer_->Pin(frame_id);
+        instance.replacer_->Unpin(frame_id);
+        instance.stats_.prefetches_++;
+    }
+    lock.unlock();
+    instance.io_cv_.notify_all();
+}
+
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-    latch_.lock();
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::scoped_lock<std::recursive_mutex> lock(instance.latch_);
     // if page_id is not in page table, return false
-    if (page_table_.find(page_id) == page_table_.end()) {
-        latch_.unlock();
+    auto it = instance.page_table_.find(page_id);
+    if (it == instance.page_table_.end()) {
         return false;
     }
 
     // if pin_count <= 0, return false
-    frame_id_t frame_id = page_table_[page_id];
-    if (pages_[frame_id].pin_count_ <= 0) {
-        latch_.unlock();
+    frame_id_t frame_id = it->second;
+    Page &page = instance.pages_[frame_id];
+    if (page.pin_count_ <= 0) {
         return false;
     }
 
-    pages_[frame_id].pin_count_--;
-    // if pin_count == 1, add it to replacer
-    if (pages_[frame_id].pin_count_ == 0) {
-        replacer_->Unpin(frame_id);
+    page.pin_count_--;
+    // if pin_count == 0, add it to replacer
+    if (page.pin_count_ == 0) {
+        instance.replacer_->Unpin(frame_id);
     }
     // if is_dirty is true, set the page dirty
-    pages_[frame_id].is_dirty_ |= is_dirty;
-    latch_.unlock();
+    page.is_dirty_ |= is_dirty;
     return true;
 }
 
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
-    latch_.lock();
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::unique_lock<std::recursive_mutex> lock(instance.latch_);
     // if page_id is not in page table, return false
-    if (page_table_.find(page_id) == page_table_.end()) {
-        latch_.unlock();
+    auto it = instance.page_table_.find(page_id);
+    if (it == instance.page_table_.end()) {
         return false;
     }
+    // a write back in flight could land after this write with older data
+    if (instance.pages_[it->second].writeback_) {
+        WaitForWriteBack(instance, it->second, lock);
+        it = instance.page_table_.find(page_id);
+        if (it == instance.page_table_.end()) {
+            return false;
+        }
+    }
 
-    frame_id_t frame_id = page_table_[page_id];
-    // 发现要求是`FlushPage操作应该将页面内容转储到磁盘中，无论其是否被固定`，注释此段代码
-    // // if pin_count > 0, return false
-    // if (pages_[frame_id].pin_count_ > 0) {
-    //   latch_.unlock();
-    //   return false;
-    // }
-
+    // FlushPage操作应该将页面内容转储到磁盘中，无论其是否被固定
+    Page &page = instance.pages_[it->second];
     // if page is not dirty, return true
-    if (!pages_[frame_id].is_dirty_) {
-        latch_.unlock();
+    if (!page.is_dirty_) {
         return true;
     }
     // write page to disk
-    disk_manager_->WritePage(page_id, pages_[frame_id].data_);
-    pages_[frame_id].is_dirty_ = false;
-    latch_.unlock();
+    disk_manager_->WritePage(page_id, page.data_);
+    page.is_dirty_ = false;
     return true;
 }
 
-page_id_t BufferPoolManager::AllocatePage() {
-    int next_page_id = disk_manager_->AllocatePage();
+void BufferPoolManager::FlushAllPages() {
+    for (auto instance : instances_) {
+        std::unique_lock<std::recursive_mutex> lock(instance->latch_);
+        // a page the background writer is writing may be dirty again, its next write must not overtake the first one
+        instance->io_cv_.wait(lock, [instance] { return instance->writebacks_ == 0; });
+        vector<pair<page_id_t, frame_id_t>> dirty_pages;
+        for (auto &entry : instance->page_table_) {
+            if (instance->pages_[entry.second].is_dirty_) {
+                dirty_pages.emplace_back(entry);
+            }
+        }
+        // logical page ids map to physical pages in the same order
+        sort(dirty_pages.begin(), dirty_pages.end());
+        WritePages(*instance, dirty_pages, lock);
+    }
+    // the allocation state is cached by the disk manager, write it back with the pages
+    disk_manager_->FlushMetadata();
+}
+
+void BufferPoolManager::WritePages(BufferPoolInstance &instance, const vector<pair<page_id_t, frame_id_t>> &pages,
+                                   unique_lock<recursive_mutex> &lock) {
+    if (pages.empty()) {
+        return;
+    }
+    // the dirty flag is cleared before the writes, an unpin that dirties the page meanwhile sets it again
+    for (auto &entry : pages) {
+        Page &page = instance.pages_[entry.second];
+        page.is_dirty_ = false;
+        page.writeback_ = true;
+    }
+    instance.writebacks_ += pages.size();
+    // the frames cannot be recycled, do the I/O without blocking the rest of the instance
+    lock.unlock();
+    vector<IOHandle> writes;
+    writes.reserve(pages.size());
+    for (auto &entry : pages) {
+        writes.push_back(disk_manager_->WritePageAsync(entry.first, instance.pages_[entry.second].data_));
+    }
+    disk_manager_->SubmitAsync();
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (!writes[i].Wait()) {
+            // retry synchronously, pwrite reports the error if it persists
+            disk_manager_->WritePage(pages[i].first, instance.pages_[pages[i].second].data_);
+        }
+    }
+    lock.lock();
+    for (auto &entry : pages) {
+        instance.pages_[entry.second].writeback_ = false;
+    }
+    instance.writebacks_ -= pages.size();
+    instance.io_cv_.notify_all();
+}
+
+void BufferPoolManager::WaitForWriteBack(BufferPoolInstance &instance, frame_id_t frame_id,
+                                         unique_lock<recursive_mutex> &lock) {
+    instance.io_cv_.wait(lock, [&instance, frame_id] { return !instance.pages_[frame_id].writeback_; });
+}
+
+void BufferPoolManager::BackgroundWriter() {
+    std::unique_lock<std::mutex> lock(background_latch_);
+    while (!shutdown_) {
+        writer_cv_.wait_for(lock, std::chrono::milliseconds(BG_WRITER_INTERVAL_MS));
+        if (shutdown_) {
+            break;
+        }
+        lock.unlock();
+        RunBackgroundWriter();
+        lock.lock();
+    }
+}
+
+void BufferPoolManager::RunBackgroundWriter() {
+    for (auto instance : instances_) {
+        CleanVictims(*instance);
+    }
+}
+
+void BufferPoolManager::CleanVictims(BufferPoolInstance &instance) {
+    std::unique_lock<std::recursive_mutex> lock(instance.latch_);
+    vector<frame_id_t> candidates;
+    instance.replacer_->PeekVictims(BG_WRITER_LOOKAHEAD, candidates);
+    vector<pair<page_id_t, frame_id_t>> dirty_pages;
+    for (auto frame_id : candidates) {
+        Page &page = instance.pages_[frame_id];
+        if (page.page_id_ != INVALID_PAGE_ID && page.pin_count_ == 0 && page.is_dirty_ && !page.writeback_) {
+            dirty_pages.emplace_back(page.page_id_, frame_id);
+        }
+    }
+    sort(dirty_pages.begin(), dirty_pages.end());
+    WritePages(instance, dirty_pages, lock);
+    instance.stats_.background_writes_ += dirty_pages.size();
+}
+
+page_id_t BufferPoolManager::AllocatePage(page_id_t hint) {
+    int next_page_id = disk_manager_->AllocatePage(hint);
     return next_page_id;
 }
 
@@ -172,6 +525,29 @@ void BufferPoolManager::DeallocatePage(__attribute__((unused)) page_id_t page_id
     disk_manager_->DeAllocatePage(page_id);
 }
 
+BufferPoolStats BufferPoolManager::GetStats() {
+    BufferPoolStats stats;
+    for (auto instance : instances_) {
+        std::scoped_lock<std::recursive_mutex> lock(instance->latch_);
+        stats.hits_ += instance->stats_.hits_;
+        stats.misses_ += instance->stats_.misses_;
+        stats.evictions_ += instance->stats_.evictions_;
+        stats.ring_hits_ += instance->stats_.ring_hits_;
+        stats.ring_misses_ += instance->stats_.ring_misses_;
+        stats.prefetches_ += instance->stats_.prefetches_;
+        stats.victim_writes_ += instance->stats_.victim_writes_;
+        stats.background_writes_ += instance->stats_.background_writes_;
+    }
+    return stats;
+}
+
+void BufferPoolManager::ResetStats() {
+    for (auto instance : instances_) {
+        std::scoped_lock<std::recursive_mutex> lock(instance->latch_);
+        instance->stats_ = BufferPoolStats();
+    }
+}
+
 bool BufferPoolManager::IsPageFree(page_id_t page_id) { return disk_manager_->IsPageFree(page_id); }
 
 // Only used for debug
@@ -186,19 +562,81 @@ bool BufferPoolManager::CheckAllUnpinned() {
     return res;
 }
 
-frame_id_t BufferPoolManager::TryToFindFreePage() {
+frame_id_t BufferPoolManager::TryToFindFreePage(BufferPoolInstance &instance) {
     frame_id_t frame_id;
-    if (free_list_.size() > 0) {  // there exists free pages
-        frame_id = free_list_.front();
-        free_list_.pop_front();
-    } else if (replacer_->Victim(&frame_id)) {  // no free pages, need to victimize a page
-        page_id_t victim_page_id = pages_[frame_id].page_id_;
-        if (pages_[frame_id].is_dirty_) {
-            disk_manager_->WritePage(victim_page_id, pages_[frame_id].data_);
-        }
-        page_table_.erase(victim_page_id);
+    if (!instance.free_list_.empty()) {  // there exists free pages
+        frame_id = instance.free_list_.front();
+        instance.free_list_.pop_front();
+    } else if (PickVictim(instance, &frame_id)) {  // no free pages, need to victimize a page
+        Page &victim = instance.pages_[frame_id];
+        if (victim.is_dirty_) {
+            disk_manager_->WritePage(victim.page_id_, victim.data_);
+            victim.is_dirty_ = false;
+            instance.stats_.victim_writes_++;
+        }
+        instance.page_table_.erase(victim.page_id_);
+        instance.stats_.evictions_++;
     } else {  // no free pages and no victim page
-        frame_id = INVALID_PAGE_ID;
+        frame_id = INVALID_FRAME_ID;
     }
     return frame_id;
-}
\ No newline at end of file
+}
+
+bool BufferPoolManager::PickVictim(BufferPoolInstance &instance, frame_id_t *frame_id) {
+    // a frame being written back is clean but not on disk yet, it goes back to the replacer
+    vector<frame_id_t> busy_frames;
+    bool found = false;
+    while (instance.replacer_->Victim(frame_id)) {
+        if (!instance.pages_[*frame_id].writeback_) {
+            found = true;
+            break;
+        }
+        busy_frames.push_back(*frame_id);
+    }
+    for (auto busy_frame_id : busy_frames) {
+        instance.replacer_->Unpin(busy_frame_id);
+    }
+    return found;
+}
+
+void BufferPoolManager::InitRing(BufferRing &ring) {
+    if (ring.slots_.size() != instances_.size()) {
+        ring.slots_.assign(instances_.size(), {});
+        ring.next_.assign(instances_.size(), 0);
+    }
+}
+
+frame_id_t BufferPoolManager::TryToFindRingFrame(BufferPoolInstance &instance, BufferRing &ring, page_id_t page_id) {
+    size_t index = GetInstanceIndex(page_id);
+    auto &slots = ring.slots_[index];
+    size_t capacity = max<size_t>(1, min(ring.ring_size_ / instances_.size(), instance.pool_size_ / 4));
+    if (slots.size() < capacity) {
+        frame_id_t frame_id = TryToFindFreePage(instance);
+        if (frame_id != INVALID_FRAME_ID) {
+            slots.push_back({frame_id, page_id});
+        }
+        return frame_id;
+    }
+    BufferRing::Slot &slot = slots[ring.next_[index]];
+    ring.next_[index] = (ring.next_[index] + 1) % slots.size();
+    Page &page = instance.pages_[slot.frame_id_];
+    frame_id_t frame_id;
+    if (page.page_id_ == slot.page_id_ && page.pin_count_ == 0 && !page.writeback_) {
+        // the frame still holds the page the ring loaded, reuse it without touching the main pool
+        frame_id = slot.frame_id_;
+        instance.replacer_->Remove(frame_id);
+        if (page.is_dirty_) {
+            disk_manager_->WritePage(page.page_id_, page.data_);
+            page.is_dirty_ = false;
+        }
+        instance.page_table_.erase(page.page_id_);
+    } else {
+        // the frame was evicted or is in use by someone else, replace it
+        frame_id = TryToFindFreePage(instance);
+        if (frame_id == INVALID_FRAME_ID) {
+            return INVALID_FRAME_ID;
+        }
+    }
+    slot = {frame_id, page_id};
+    return frame_id;
+}
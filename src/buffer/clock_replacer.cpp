@@ -47,4 +47,18 @@ void CLOCKReplacer::Unpin(frame_id_t frame_id) {
     }
 }
 
-size_t CLOCKReplacer::Size() { return clock_list.size(); }
\ No newline at end of file
+size_t CLOCKReplacer::Size() { return clock_list.size(); }
+
+void CLOCKReplacer::PeekVictims(size_t count, vector<frame_id_t> &frames) {
+    // frames without reference bit go first, then the hand comes back to the others
+    for (auto frame_id : clock_list) {
+        if (frames.size() < count && clock_status[frame_id] == 0) {
+            frames.push_back(frame_id);
+        }
+    }
+    for (auto frame_id : clock_list) {
+        if (frames.size() < count && clock_status[frame_id] != 0) {
+            frames.push_back(frame_id);
+        }
+    }
+}
\ No newline at end of file
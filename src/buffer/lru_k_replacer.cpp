@@ -0,0 +1,74 @@
+#include "buffer/lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+    : k_(k > 0 ? k : 1),
+      max_size_(num_pages),
+      history_(num_pages * k_),
+      access_count_(num_pages, 0),
+      evictable_(num_pages, false) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+    if (evictable_set_.empty()) {
+        return false;
+    }
+    *frame_id = get<2>(*evictable_set_.begin());
+    evictable_set_.erase(evictable_set_.begin());
+    evictable_[*frame_id] = false;
+    // the frame will hold another page, its history is meaningless now
+    access_count_[*frame_id] = 0;
+    return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+    if (!IsValidFrame(frame_id)) {
+        return;
+    }
+    if (evictable_[frame_id]) {
+        evictable_set_.erase(GetEvictKey(frame_id));
+        evictable_[frame_id] = false;
+    }
+    history_[frame_id * k_ + access_count_[frame_id] % k_] = current_timestamp_++;
+    access_count_[frame_id]++;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+    if (!IsValidFrame(frame_id)) {
+        LOG(ERROR) << "LRUKReplacer::Unpin: frame " << frame_id << " out of range";
+        return;
+    }
+    if (!evictable_[frame_id]) {
+        evictable_set_.insert(GetEvictKey(frame_id));
+        evictable_[frame_id] = true;
+    }
+}
+
+size_t LRUKReplacer::Size() { return evictable_set_.size(); }
+
+void LRUKReplacer::PeekVictims(size_t count, vector<frame_id_t> &frames) {
+    for (auto it = evictable_set_.begin(); it != evictable_set_.end() && frames.size() < count; ++it) {
+        frames.push_back(get<2>(*it));
+    }
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+    if (!IsValidFrame(frame_id)) {
+        return;
+    }
+    if (evictable_[frame_id]) {
+        evictable_set_.erase(GetEvictKey(frame_id));
+        evictable_[frame_id] = false;
+    }
+    access_count_[frame_id] = 0;
+}
+
+LRUKReplacer::EvictKey LRUKReplacer::GetEvictKey(frame_id_t frame_id) const {
+    size_t count = access_count_[frame_id];
+    if (count < k_) {
+        // infinite backward distance, fall back to the first access (0 if never accessed)
+        return {false, count == 0 ? 0 : history_[frame_id * k_], frame_id};
+    }
+    // the oldest slot of the ring buffer is the K-th most recent access
+    return {true, history_[frame_id * k_ + count % k_], frame_id};
+}
@@ -1,43 +1,63 @@
 #include "buffer/lru_replacer.h"
 
-LRUReplacer::LRUReplacer(size_t num_pages) {
-    lru_list_.clear();
-    lru_set_.clear();
-    max_size_ = num_pages;
+LRUReplacer::LRUReplacer(size_t num_pages) : nodes_(num_pages + 1), max_size_(num_pages) {
+    nodes_[max_size_].prev_ = nodes_[max_size_].next_ = static_cast<frame_id_t>(max_size_);
 }
 
 LRUReplacer::~LRUReplacer() = default;
 
 bool LRUReplacer::Victim(frame_id_t *frame_id) {
-    if (lru_list_.empty()) {
+    if (size_ == 0) {
         return false;
     }
-    *frame_id = lru_list_.front();
-    lru_list_.pop_front();
-    lru_set_.erase(*frame_id);
+    *frame_id = nodes_[max_size_].next_;
+    Unlink(*frame_id);
     return true;
 }
 
 void LRUReplacer::Pin(frame_id_t frame_id) {
-    if (lru_set_.find(frame_id) != lru_set_.end()) {
-        lru_list_.remove(frame_id);
-        lru_set_.erase(frame_id);
+    if (frame_id >= 0 && static_cast<size_t>(frame_id) < max_size_ && nodes_[frame_id].in_list_) {
+        Unlink(frame_id);
     }
 }
 
 void LRUReplacer::Unpin(frame_id_t frame_id) {
-    if (lru_set_.find(frame_id) == lru_set_.end()) {
-        if (lru_list_.size() >= max_size_) {
-            frame_id_t victim;
-            Victim(&victim);
-        }
-        if (lru_list_.size() >= max_size_) {
-            LOG(ERROR) << "LRUReplacer::Unpin: still no victim";
-        } else {
-            lru_list_.push_back(frame_id);
-            lru_set_.insert(frame_id);
-        }
+    if (frame_id < 0 || static_cast<size_t>(frame_id) >= max_size_) {
+        LOG(ERROR) << "LRUReplacer::Unpin: frame " << frame_id << " out of range";
+        return;
     }
+    if (!nodes_[frame_id].in_list_) {
+        Link(frame_id);
+    }
+}
+
+size_t LRUReplacer::Size() { return size_; }
+
+void LRUReplacer::PeekVictims(size_t count, vector<frame_id_t> &frames) {
+    auto head = static_cast<frame_id_t>(max_size_);
+    for (frame_id_t frame_id = nodes_[head].next_; frame_id != head && frames.size() < count;
+         frame_id = nodes_[frame_id].next_) {
+        frames.push_back(frame_id);
+    }
+}
+
+void LRUReplacer::Link(frame_id_t frame_id) {
+    // append to the most recently used end
+    auto head = static_cast<frame_id_t>(max_size_);
+    Node &node = nodes_[frame_id];
+    node.prev_ = nodes_[head].prev_;
+    node.next_ = head;
+    node.in_list_ = true;
+    nodes_[node.prev_].next_ = frame_id;
+    nodes_[head].prev_ = frame_id;
+    size_++;
 }
 
-size_t LRUReplacer::Size() { return lru_list_.size(); }
\ No newline at end of file
+void LRUReplacer::Unlink(frame_id_t frame_id) {
+    Node &node = nodes_[frame_id];
+    nodes_[node.prev_].next_ = node.next_;
+    nodes_[node.next_].prev_ = node.prev_;
+    node.prev_ = node.next_ = INVALID_FRAME_ID;
+    node.in_list_ = false;
+    size_--;
+}
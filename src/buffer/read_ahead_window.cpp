@@ -0,0 +1,69 @@
+#include "buffer/read_ahead_window.h"
+
+#include <algorithm>
+
+ReadAheadWindow::ReadAheadWindow(BufferPoolManager *buffer_pool_manager, size_t size, size_t next_page_offset,
+                                 shared_ptr<BufferRing> ring)
+    : buffer_pool_manager_(buffer_pool_manager),
+      size_(size),
+      next_page_offset_(next_page_offset),
+      ring_(std::move(ring)) {}
+
+void ReadAheadWindow::Advance(page_id_t page_id, page_id_t next_page_id) {
+    if (size_ == 0) {
+        return;
+    }
+    // forget the pages the scan went past, it got to `page_id` through real links
+    auto it = find(pages_.begin(), pages_.end(), page_id);
+    if (it != pages_.end()) {
+        size_t passed = it - pages_.begin() + 1;
+        pages_.erase(pages_.begin(), it + 1);
+        known_ = known_ > passed ? known_ - passed : 0;
+    }
+    vector<page_id_t> batch;
+    if (pages_.empty() || pages_.front() != next_page_id) {
+        // the window was a wrong guess or the chain changed, start over
+        pages_.clear();
+        if (next_page_id == INVALID_PAGE_ID) {
+            known_ = 0;
+            return;
+        }
+        pages_.push_back(next_page_id);
+        batch.push_back(next_page_id);
+    } else if (pages_.size() > size_ / 2) {
+        // refill once half of the window is used up, so the pages are queued and read in batches
+        return;
+    }
+    known_ = max<size_t>(known_, 1);
+    // follow the links out of the pages already in the pool, checking the guesses on the way
+    bool chain_end = false;
+    while (known_ < size_) {
+        page_id_t following;
+        if (!buffer_pool_manager_->PeekPage(pages_[known_ - 1], next_page_offset_, sizeof(page_id_t), &following)) {
+            break;
+        }
+        if (known_ < pages_.size() && pages_[known_] != following) {
+            pages_.resize(known_);
+        }
+        if (following == INVALID_PAGE_ID) {
+            chain_end = true;
+            break;
+        }
+        if (known_ == pages_.size()) {
+            pages_.push_back(following);
+            batch.push_back(following);
+        }
+        known_++;
+    }
+    // guess past the last known page while the chain is sequential, within the reservation of that page only: the
+    // pages after it belong to another owner or to no one
+    page_id_t before = known_ >= 2 ? pages_[known_ - 2] : page_id;
+    if (!chain_end && pages_[known_ - 1] == before + 1) {
+        page_id_t reservation_end = (pages_[known_ - 1] / PAGE_RESERVATION_SIZE + 1) * PAGE_RESERVATION_SIZE;
+        while (pages_.size() < size_ && pages_.back() + 1 < reservation_end) {
+            pages_.push_back(pages_.back() + 1);
+            batch.push_back(pages_.back());
+        }
+    }
+    buffer_pool_manager_->PrefetchPages(batch, ring_);
+}
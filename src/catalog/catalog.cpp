@@ -1,5 +1,7 @@
 #include "catalog/catalog.h"
 
+#include "page/index_roots_page.h"
+
 void CatalogMeta::SerializeTo(char *buf) const {
     ASSERT(GetSerializedSize() <= PAGE_SIZE, "Failed to serialize catalog metadata to disk.");
     MACH_WRITE_UINT32(buf, CATALOG_METADATA_MAGIC_NUM);
@@ -120,7 +122,8 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
   // create table meta
   TableSchema *table_schema = TableSchema::DeepCopySchema(schema);  // 注意这里需要深拷贝，否则会有double free的问题
   auto table_heap = TableHeap::Create(buffer_pool_manager_, table_schema, nullptr, log_manager_, lock_manager_);
-  auto *table_meta = TableMetadata::Create(table_id, table_name, table_heap->GetFirstPageId(), table_schema);
+  auto *table_meta = TableMetadata::Create(table_id, table_name, table_heap->GetFirstPageId(), table_schema,
+                                          table_heap->GetFreeSpaceMapPageId());
   table_meta->SerializeTo(table_meta_page->GetData());
   table_info = TableInfo::Create();
   table_info->Init(table_meta, table_heap);
@@ -289,6 +292,9 @@ dberr_t CatalogManager::DropTable(const string &table_name) {
   catalog_meta_->table_meta_pages_.erase(table_info->GetTableId());
   table_names_.erase(table_name);
   tables_.erase(table_info->GetTableId());
+  // closing a table heap keeps its pages, release them explicitly
+  table_info->GetTableHeap()->DeleteTable();
+  delete table_info;
   return DB_SUCCESS;
 }
 
@@ -353,8 +359,15 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
   assert(page != nullptr);
   TableMetadata *table_meta = nullptr;
   TableMetadata::DeserializeFrom(page->GetData(), table_meta);
-  buffer_pool_manager_->UnpinPage(page_id, false);
-  TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, table_meta->GetSchema(), nullptr, log_manager_, lock_manager_);
+  // open the existing heap, a table without a free space map gets one now and its metadata is rewritten
+  TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, table_meta->GetFirstPageId(), table_meta->GetSchema(),
+                                            log_manager_, lock_manager_, table_meta->GetFreeSpaceMapPageId());
+  bool meta_dirty = table_meta->GetFreeSpaceMapPageId() != table_heap->GetFreeSpaceMapPageId();
+  if (meta_dirty) {
+    table_meta->SetFreeSpaceMapPageId(table_heap->GetFreeSpaceMapPageId());
+    table_meta->SerializeTo(page->GetData());
+  }
+  buffer_pool_manager_->UnpinPage(page_id, meta_dirty);
   TableInfo *table_info = TableInfo::Create();
   table_info->Init(table_meta, table_heap);
   table_names_.emplace(table_meta->GetTableName(), table_meta->GetTableId());
@@ -368,26 +381,35 @@ dberr_t CatalogManager::LoadIndex(const index_id_t index_id, const page_id_t pag
   IndexMetadata *index_meta = nullptr;
   IndexMetadata::DeserializeFrom(index_page->GetData(), index_meta);
   buffer_pool_manager_->UnpinPage(page_id, false);
-  // find table
-  auto table_iter = catalog_meta_->table_meta_pages_.find(index_meta->GetTableId());
-  assert(table_iter != catalog_meta_->table_meta_pages_.end());
-  auto table_page = buffer_pool_manager_->FetchPage(table_iter->second);
-  assert(table_page != nullptr);
-  TableMetadata *table_meta = nullptr;
-  TableMetadata::DeserializeFrom(table_page->GetData(), table_meta);
-  buffer_pool_manager_->UnpinPage(table_iter->second, false);
+  // find table, tables are loaded before indexes
+  auto table_iter = tables_.find(index_meta->GetTableId());
+  assert(table_iter != tables_.end());
+  TableInfo *table_info = table_iter->second;
+  // a tree written before keys were memcomparable is ordered differently, build it again from the table
+  bool legacy_keys = index_meta->HasLegacyKeys();
+  if (legacy_keys) {
+    DropLegacyIndexTree(index_meta, table_info);
+  }
   // create index info
-  TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, table_meta->GetSchema(), nullptr, log_manager_, lock_manager_);
-  TableInfo *table_info = TableInfo::Create();
-  table_info->Init(table_meta, table_heap);
   IndexInfo *index_info = IndexInfo::Create();
   index_info->Init(index_meta, table_info, buffer_pool_manager_);
+  if (legacy_keys) {
+    if (FillIndex(index_info, table_info) != DB_SUCCESS) {
+      LOG(ERROR) << "Failed to rebuild index " << index_info->GetIndexName() << "." << std::endl;
+      delete index_info;
+      return DB_FAILED;
+    }
+    index_page = buffer_pool_manager_->FetchPage(page_id);
+    assert(index_page != nullptr);
+    index_meta->SerializeTo(index_page->GetData());
+    buffer_pool_manager_->UnpinPage(page_id, true);
+  }
   std::string index_name = index_info->GetIndexName();
-  auto index_name_iter = index_names_.find(table_meta->GetTableName());
+  auto index_name_iter = index_names_.find(table_info->GetTableName());
   if (index_name_iter == index_names_.end()) {
     std::unordered_map<std::string, index_id_t> index_name_map;
     index_name_map.emplace(index_name, index_meta->GetIndexId());
-    index_names_.emplace(table_meta->GetTableName(), index_name_map);
+    index_names_.emplace(table_info->GetTableName(), index_name_map);
   } else {  // table name exists
     index_name_iter->second.emplace(index_name, index_meta->GetIndexId());
   }
@@ -395,6 +417,41 @@ dberr_t CatalogManager::LoadIndex(const index_id_t index_id, const page_id_t pag
   return DB_SUCCESS;
 }
 
+void CatalogManager::DropLegacyIndexTree(IndexMetadata *index_meta, TableInfo *table_info) {
+  // every page of the tree records its key width, so a tree sized at run time can walk the old one
+  IndexSchema *key_schema = Schema::ShallowCopySchema(table_info->GetSchema(), index_meta->GetKeyMapping());
+  KeyManager key_manager(key_schema, KeyManager::GetEncodedSize(key_schema));
+  {
+    BPlusTree<> tree(index_meta->GetIndexId(), buffer_pool_manager_, key_manager);
+    tree.Destroy(tree.GetRootPageId());
+  }
+  delete key_schema;
+  // an empty tree keeps its record in the index roots page
+  Page *page = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
+  assert(page != nullptr);
+  page->WLatch();
+  reinterpret_cast<IndexRootsPage *>(page->GetData())->Update(index_meta->GetIndexId(), INVALID_PAGE_ID);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
+}
+
+dberr_t CatalogManager::FillIndex(IndexInfo *index_info, TableInfo *table_info) {
+  TableHeap *table_heap = table_info->GetTableHeap();
+  auto end = table_heap->End();
+  auto tuple = table_heap->Begin(nullptr, DEFAULT_BUFFER_RING_SIZE, DEFAULT_READ_AHEAD_PAGES);
+  return index_info->GetIndex()->BulkLoad(
+      [&](Row &key, RowId &row_id) {
+        if (tuple == end) {
+          return false;
+        }
+        tuple->GetKeyFromRow(table_info->GetSchema(), index_info->GetIndexKeySchema(), key);
+        row_id = tuple->GetRowId();
+        tuple++;
+        return true;
+      },
+      nullptr);
+}
+
 dberr_t CatalogManager::GetTable(const table_id_t table_id, TableInfo *&table_info) {
   auto table_iter = tables_.find(table_id);
   if (table_iter == tables_.end()) {
@@ -14,7 +14,7 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
     uint32_t ofs = GetSerializedSize();
     ASSERT(ofs <= PAGE_SIZE, "Failed to serialize index info.");
     // magic num
-    MACH_WRITE_UINT32(buf, INDEX_METADATA_MAGIC_NUM);
+    MACH_WRITE_UINT32(buf, INDEX_METADATA_MEMCMP_MAGIC_NUM);
     buf += 4;
     // index id
     MACH_WRITE_TO(index_id_t, buf, index_id_);
@@ -59,7 +59,8 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
     // magic num
     uint32_t magic_num = MACH_READ_UINT32(buf);
     buf += 4;
-    ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM, "Failed to deserialize index info.");
+    ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM || magic_num == INDEX_METADATA_MEMCMP_MAGIC_NUM,
+           "Failed to deserialize index info.");
     // index id
     index_id_t index_id = MACH_READ_FROM(index_id_t, buf);
     buf += 4;
@@ -83,25 +84,23 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
     }
     // allocate space for index meta data
     index_meta = new IndexMetadata(index_id, index_name, table_id, key_map);
+    index_meta->legacy_keys_ = magic_num == INDEX_METADATA_MAGIC_NUM;
     return buf - p;
 }
 
 Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const string &index_type) {
-  size_t max_size = 0;
-  for (auto col : key_schema_->GetColumns()) {
-    max_size += col->GetLength();
-  }
+  size_t max_size = KeyManager::GetEncodedSize(key_schema_);
 
   if (index_type == "bptree") {
-    if (max_size <= 8)
+    if (max_size <= 16)
       max_size = 16;
-    else if (max_size <= 24)
+    else if (max_size <= 32)
       max_size = 32;
-    else if (max_size <= 56)
+    else if (max_size <= 64)
       max_size = 64;
-    else if (max_size <= 120)
+    else if (max_size <= 128)
       max_size = 128;
-    else if (max_size <= 248)
+    else if (max_size <= 256)
       max_size = 256;
     else {
       LOG(ERROR) << "GenericKey size is too large";
@@ -110,5 +109,5 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
   } else {
     return nullptr;
   }
-  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager);
+  return BPlusTreeIndex::Create(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager);
 }
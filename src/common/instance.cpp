@@ -3,7 +3,9 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size,
+                                 uint32_t buffer_pool_instances, ReplacerType replacer_type, uint32_t lru_k,
+                                 bool direct_io)
     : db_file_name_(std::move(db_name)), init_(init) {
   // Init database file if needed
   db_file_name_ = "./databases/"+db_file_name_;
@@ -11,8 +13,8 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
     remove(db_file_name_.c_str());
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, DEFAULT_USE_IO_URING, direct_io);
+  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_, buffer_pool_instances, replacer_type, lru_k);
 
   // Allocate static page for db storage engine
   if (init) {
@@ -86,7 +86,7 @@ dberr_t ExecuteEngine::ExecutePlan(const AbstractPlanNodeRef &plan, std::vector<
     Row row{};
     while (executor->Next(&row, &rid)) {
       if (result_set != nullptr) {
-        result_set->push_back(row);
+        result_set->push_back(std::move(row));
       }
     }
   } catch (const exception &ex) {
@@ -99,6 +99,69 @@ dberr_t ExecuteEngine::ExecutePlan(const AbstractPlanNodeRef &plan, std::vector<
   return DB_SUCCESS;
 }
 
+dberr_t ExecuteEngine::BulkLoad(const std::string &table_name, std::vector<Row> &rows, ExecuteContext *context) {
+  if (context == nullptr) {
+    return DB_FAILED;
+  }
+  TableInfo *table_info = nullptr;
+  if (context->GetCatalog()->GetTable(table_name, table_info) != DB_SUCCESS) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  std::vector<IndexInfo *> indexes;
+  context->GetCatalog()->GetTableIndexes(table_name, indexes);
+  std::vector<Row> batch;
+  batch.reserve(INSERT_BATCH_SIZE);
+  for (size_t begin = 0; begin < rows.size(); begin += INSERT_BATCH_SIZE) {
+    size_t end = std::min(rows.size(), begin + INSERT_BATCH_SIZE);
+    batch.assign(rows.begin() + begin, rows.begin() + end);
+    if (!table_info->GetTableHeap()->InsertTuples(batch, context->GetTransaction())) {
+      return DB_FAILED;
+    }
+    for (size_t i = begin; i < end; i++) {
+      rows[i].SetRowId(batch[i - begin].GetRowId());
+      for (auto index : indexes) {
+        Row key;
+        rows[i].GetKeyFromRow(table_info->GetSchema(), index->GetIndexKeySchema(), key);
+        index->GetIndex()->InsertEntry(key, rows[i].GetRowId(), context->GetTransaction());
+      }
+    }
+  }
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::Vacuum(const std::string &table_name, ExecuteContext *context, VacuumStats *stats) {
+  if (context == nullptr) {
+    return DB_FAILED;
+  }
+  TableInfo *table_info = nullptr;
+  if (context->GetCatalog()->GetTable(table_name, table_info) != DB_SUCCESS) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  std::vector<IndexInfo *> indexes;
+  context->GetCatalog()->GetTableIndexes(table_name, indexes);
+  std::vector<std::pair<RowId, RowId>> moved;
+  *stats = table_info->GetTableHeap()->Vacuum(&moved, context->GetTransaction());
+  if (indexes.empty()) {
+    return DB_SUCCESS;
+  }
+  // the rows have moved already, an entry that cannot be remapped leaves the index stale
+  for (auto &[old_rid, new_rid] : moved) {
+    Row row(new_rid);
+    if (!table_info->GetTableHeap()->GetTuple(&row, context->GetTransaction())) {
+      return DB_FAILED;
+    }
+    for (auto index : indexes) {
+      Row key;
+      row.GetKeyFromRow(table_info->GetSchema(), index->GetIndexKeySchema(), key);
+      if (index->GetIndex()->RemoveEntry(key, old_rid, context->GetTransaction()) != DB_SUCCESS ||
+          index->GetIndex()->InsertEntry(key, new_rid, context->GetTransaction()) != DB_SUCCESS) {
+        return DB_FAILED;
+      }
+    }
+  }
+  return DB_SUCCESS;
+}
+
 dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
   if (ast == nullptr) {
     return DB_FAILED;
@@ -138,6 +201,10 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
       return ExecuteExecfile(ast, context.get());
     case kNodeQuit:
       return ExecuteQuit(ast, context.get());
+    case kNodeVacuum:
+      return ExecuteVacuum(ast, context.get());
+    case kNodeAnalyze:
+      return ExecuteAnalyze(ast, context.get());
     default:
       break;
   }
@@ -635,23 +702,41 @@ dberr_t ExecuteEngine::ExecuteCreateIndex(pSyntaxNode ast, ExecuteContext *conte
     return res;
   }
 
-  // insert the tuples into the index
+  // build the index from the keys of all the tuples
   TableInfo *table_info;
   res = db->catalog_mgr_->GetTable(table_name, table_info);
   if (res != DB_SUCCESS) {
     return res;
   }
-  TableHeap *table_heap = table_info->GetTableHeap();
-  for (auto tuple = table_heap->Begin(context->GetTransaction()); tuple != table_heap->End(); tuple++) {
-    std::vector<Field> fields;
-    for (int i = 0; i < keys.size(); i++) {
-      uint32_t column_index;
-      if (table_info->GetSchema()->GetColumnIndex(keys[i], column_index) != DB_SUCCESS) {
-        return DB_FAILED;
-      }
-      fields.emplace_back(*(tuple->GetField(column_index)));
+  std::vector<uint32_t> column_indexes;
+  for (auto &key : keys) {
+    uint32_t column_index;
+    if (table_info->GetSchema()->GetColumnIndex(key, column_index) != DB_SUCCESS) {
+      return DB_FAILED;
     }
-    index_info->GetIndex()->InsertEntry(Row(fields), tuple->GetRowId(), context->GetTransaction());
+    column_indexes.push_back(column_index);
+  }
+  TableHeap *table_heap = table_info->GetTableHeap();
+  auto end = table_heap->End();
+  auto tuple = table_heap->Begin(context->GetTransaction(), DEFAULT_BUFFER_RING_SIZE, DEFAULT_READ_AHEAD_PAGES);
+  std::vector<Field> fields;
+  res = index_info->GetIndex()->BulkLoad(
+      [&](Row &key, RowId &row_id) {
+        if (tuple == end) {
+          return false;
+        }
+        fields.clear();
+        for (uint32_t column_index : column_indexes) {
+          fields.emplace_back(*(tuple->GetField(column_index)));
+        }
+        key = Row(fields);
+        row_id = tuple->GetRowId();
+        tuple++;
+        return true;
+      },
+      context->GetTransaction());
+  if (res != DB_SUCCESS) {
+    return res;
   }
   printf("Create index %s on table %s success.\n", index_name.c_str(), table_name.c_str());
   return DB_SUCCESS;
@@ -817,3 +902,40 @@ dberr_t ExecuteEngine::ExecuteQuit(pSyntaxNode ast, ExecuteContext *context) {
 #endif
   return DB_QUIT;
 }
+
+dberr_t ExecuteEngine::ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteVacuum" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    printf("No database selected.\n");
+    return DB_FAILED;
+  }
+  std::string table_name = ast->child_->val_;
+  VacuumStats stats;
+  dberr_t res = Vacuum(table_name, context, &stats);
+  if (res != DB_SUCCESS) {
+    return res;
+  }
+  printf("Table %s vacuumed: %u pages reclaimed (%u -> %u), %u rows moved.\n", table_name.c_str(),
+         stats.PagesReclaimed(), stats.pages_before_, stats.pages_after_, stats.rows_moved_);
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteAnalyze(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteAnalyze" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    printf("No database selected.\n");
+    return DB_FAILED;
+  }
+  std::string table_name = ast->child_->val_;
+  TableInfo *table_info = nullptr;
+  if (context->GetCatalog()->GetTable(table_name, table_info) != DB_SUCCESS) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  uint32_t page_count = table_info->GetTableHeap()->RebuildZoneMap();
+  printf("Table %s analyzed: zone map of %u pages rebuilt.\n", table_name.c_str(), page_count);
+  return DB_SUCCESS;
+}
@@ -56,7 +56,7 @@ bool IndexScanExecutor::Next(Row *row, RowId *rid) {
   for (; cur_row_id_ < row_ids_.size();) {
     *rid = row_ids_[cur_row_id_];
     row->SetRowId(*rid);
-    if (!table_heap_->GetTuple(row, exec_ctx_->GetTransaction())) {
+    if (!table_heap_->GetTuple(row, exec_ctx_->GetTransaction(), exec_ctx_->GetArena())) {
       return false;
     }
     cur_row_id_++;
@@ -22,48 +22,65 @@ void InsertExecutor::Init() {
 }
 
 bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
-  Row child_row{};
-  RowId child_rid{};
-  if (child_executor_->Next(&child_row, &child_rid)) {
-    // check unique
-    for(auto unique_column : unique_columns_){
-      IndexInfo *index_info = nullptr;
+  if (emitted_ == batch_.size()) {
+    // pull the next batch of rows from the child and insert it at once
+    batch_.clear();
+    emitted_ = 0;
+    Row child_row{};
+    RowId child_rid{};
+    while (batch_.size() < INSERT_BATCH_SIZE && child_executor_->Next(&child_row, &child_rid)) {
+      batch_.push_back(child_row);
+    }
+    if (batch_.empty()) {
+      return false;
+    }
+    if (!CheckUnique()) {
+      batch_.clear();
+      return false;
+    }
+    if (!table_heap_->InsertTuples(batch_, exec_ctx_->GetTransaction())) {
+      printf("insert tuple failed\n");
+      batch_.clear();
+      return false;
+    }
+    // insert into index
+    for (auto &inserted_row : batch_) {
       for (auto index : indexes_) {
-        if (index->GetIndexKeySchema()->GetColumnCount() == 1 &&
-            index->GetIndexKeySchema()->GetColumn(0)->GetName() == unique_column.second->GetName()) {
-          index_info = index;
-        }
+        Row key;
+        inserted_row.GetKeyFromRow(table_info_->GetSchema(), index->GetIndexKeySchema(), key);
+        index->GetIndex()->InsertEntry(key, inserted_row.GetRowId(), exec_ctx_->GetTransaction());
+      }
+    }
+  }
+  *rid = batch_[emitted_++].GetRowId();
+  return true;
+}
+
+bool InsertExecutor::CheckUnique() {
+  for (auto unique_column : unique_columns_) {
+    IndexInfo *index_info = nullptr;
+    for (auto index : indexes_) {
+      if (index->GetIndexKeySchema()->GetColumnCount() == 1 &&
+          index->GetIndexKeySchema()->GetColumn(0)->GetName() == unique_column.second->GetName()) {
+        index_info = index;
       }
-      assert(index_info != nullptr);
+    }
+    assert(index_info != nullptr);
+    // rows of the batch are not in the index yet, compare them with each other by their serialized value
+    std::unordered_set<std::string> batch_keys;
+    for (auto &batch_row : batch_) {
+      Field *field = batch_row.GetField(unique_column.first);
       std::vector<RowId> scan_result;
       std::vector<Field> key;
-      key.emplace_back(*(child_row.GetField(unique_column.first)));
-      if (index_info->GetIndex()->ScanKey(Row(key), scan_result, exec_ctx_->GetTransaction()) == DB_SUCCESS) {
+      key.emplace_back(*field);
+      std::string serialized(field->GetSerializedSize(), '\0');
+      field->SerializeTo(serialized.data());
+      if (index_info->GetIndex()->ScanKey(Row(key), scan_result, exec_ctx_->GetTransaction()) == DB_SUCCESS ||
+          !batch_keys.insert(serialized).second) {
         printf("constraint unique failed, column: %s\n", unique_column.second->GetName().c_str());
         return false;
       }
     }
-    if (table_heap_->InsertTuple(child_row, exec_ctx_->GetTransaction())) {
-      child_rid = child_row.GetRowId();
-      rid = &child_rid;
-      // insert into index
-      for (auto index : indexes_) {
-        std::vector<Field> key;
-        for (int i = 0; i < index->GetIndexKeySchema()->GetColumnCount(); i++) {
-          uint32_t column_index;
-          if (table_info_->GetSchema()->GetColumnIndex(index->GetIndexKeySchema()->GetColumn(i)->GetName(), column_index) != DB_SUCCESS) {
-            printf("insert index failed, column: %s\n", index->GetIndexKeySchema()->GetColumn(i)->GetName().c_str());
-            return false;
-          }
-          key.emplace_back(*(child_row.GetField(column_index)));
-        }
-        index->GetIndex()->InsertEntry(Row(key), child_rid, exec_ctx_->GetTransaction());
-      }
-      return true;
-    }
-    printf("insert tuple failed\n");
-    return false;
-  } else {
-    return false;
   }
-}
\ No newline at end of file
+  return true;
+}
@@ -3,6 +3,11 @@
 //
 #include "executor/executors/seq_scan_executor.h"
 
+#include "planner/expressions/column_value_expression.h"
+#include "planner/expressions/comparison_expression.h"
+#include "planner/expressions/constant_value_expression.h"
+#include "planner/expressions/logic_expression.h"
+
 SeqScanExecutor::SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan)
     : AbstractExecutor(exec_ctx),
       plan_(plan){}
@@ -10,36 +15,65 @@ SeqScanExecutor::SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode
 void SeqScanExecutor::Init() {
   TableInfo *table_info;
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info);
-  table_iter_ = new TableIterator(table_info->GetTableHeap()->Begin(exec_ctx_->GetTransaction()));
+  // pages whose zones rule out the predicate are skipped without reading their rows
+  PageFilter page_filter = nullptr;
+  if (plan_->GetPredicate() != nullptr) {
+    zone_map_ = table_info->GetTableHeap()->GetZoneMap();
+    page_filter = [this](page_id_t page_id) { return PageMayMatch(page_id, plan_->GetPredicate()); };
+  }
+  table_iter_ = new TableIterator(table_info->GetTableHeap()->Begin(
+      exec_ctx_->GetTransaction(), DEFAULT_BUFFER_RING_SIZE, DEFAULT_READ_AHEAD_PAGES, page_filter));
   end_iter_ = new TableIterator(table_info->GetTableHeap()->End());
   schema_ = table_info->GetSchema();
   key_schema_ = plan_->OutputSchema();
+  columns_.clear();
+  for (auto column : key_schema_->GetColumns()) {
+    uint32_t idx;
+    schema_->GetColumnIndex(column->GetName(), idx);
+    columns_.push_back(idx);
+  }
 }
 
 bool SeqScanExecutor::Next(Row *row, RowId *rid) {
-  if (*table_iter_ == *end_iter_) {
-    return false;
-  }
-  if (plan_->GetPredicate() == nullptr) { // no predicate
-    Row row_src = **table_iter_;
-    Row row_dst;
-    row_src.GetKeyFromRow(schema_, key_schema_, row_dst);
-    *row = row_dst;
-    *rid = (*table_iter_)->GetRowId();
-    (*table_iter_)++;
-    return true;
-  }
-  for (; *table_iter_ != *end_iter_; (*table_iter_)++) {
-    *row = **table_iter_;
-    *rid = (*table_iter_)->GetRowId();
-    if (plan_->GetPredicate()->Evaluate(row).CompareEquals(Field(kTypeInt, 1))) {
-      (*table_iter_)++;
-      Row row_src = *row;
-      Row row_dst;
-      row_src.GetKeyFromRow(schema_, key_schema_, row_dst);
-      *row = row_dst;
+  // the predicate is evaluated on the tuple in its page, only the rows that are emitted get deserialized
+  // the view keeps the page read latched, it is released before the iterator moves and latches the page again
+  for (; *table_iter_ != *end_iter_; ++*table_iter_) {
+    LatchedRowView view = table_iter_->GetView();
+    if (!view->IsValid()) {
+      continue;  // deleted since the iterator reached it
+    }
+    if (plan_->GetPredicate() == nullptr ||
+        plan_->GetPredicate()->EvaluateView(*view).CompareEquals(Field(kTypeInt, 1)) == CmpBool::kTrue) {
+      view->Materialize(columns_, row, exec_ctx_->GetArena());
+      view.Release();
+      *rid = table_iter_->GetRowId();
+      row->SetRowId(*rid);
+      ++*table_iter_;
       return true;
     }
   }
   return false;
 }
+
+bool SeqScanExecutor::PageMayMatch(page_id_t page_id, const AbstractExpressionRef &predicate) const {
+  if (predicate->GetType() == ExpressionType::LogicExpression) {
+    auto logic = std::dynamic_pointer_cast<LogicExpression>(predicate);
+    bool left = PageMayMatch(page_id, logic->GetChildAt(0));
+    if (logic->logic_type_ == LogicType::And) {
+      return left && PageMayMatch(page_id, logic->GetChildAt(1));
+    }
+    return left || PageMayMatch(page_id, logic->GetChildAt(1));
+  }
+  if (predicate->GetType() != ExpressionType::ComparisonExpression) {
+    return true;
+  }
+  // the planner puts the column on the left and the constant on the right
+  auto left = predicate->GetChildAt(0);
+  auto right = predicate->GetChildAt(1);
+  if (left->GetType() != ExpressionType::ColumnExpression || right->GetType() != ExpressionType::ConstantExpression) {
+    return true;
+  }
+  return zone_map_->MayMatch(page_id, std::dynamic_pointer_cast<ColumnValueExpression>(left)->GetColIdx(),
+                             std::dynamic_pointer_cast<ComparisonExpression>(predicate)->GetComparisonType(),
+                             std::dynamic_pointer_cast<ConstantValueExpression>(right)->val_);
+}
@@ -16,7 +16,7 @@ bool ValuesExecutor::Next(Row *row, RowId *rid) {
     std::vector<Field> values;
     auto exprs = plan_->GetValues().at(cursor_);
     for (auto expr : exprs) {
-      values.emplace_back(expr->Evaluate(nullptr));
+      values.emplace_back(expr->Evaluate(nullptr).DeepCopy());
     }
     *row = Row{values};
     cursor_++;
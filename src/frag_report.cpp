@@ -0,0 +1,40 @@
+#include <iostream>
+
+#include "common/instance.h"
+#include "glog/logging.h"
+#include "index/b_plus_tree_index.h"
+#include "storage/fragmentation_report.h"
+
+/**
+ * Print how fragmented the table heaps and indexes of a database are on disk.
+ * Usage: frag_report <database name>, the database is looked up in ./databases like the shell does.
+ */
+int main(int argc, char **argv) {
+  FLAGS_logtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <database name>" << std::endl;
+    return 1;
+  }
+  DBStorageEngine engine(argv[1], false);
+  BufferPoolManager *bpm = engine.bpm_;
+  std::vector<TableInfo *> tables;
+  engine.catalog_mgr_->GetTables(tables);
+  for (auto table_info : tables) {
+    auto page_ids = FragmentationReport::TableHeapPageIds(bpm, table_info->GetTableHeap()->GetFirstPageId());
+    std::cout << "table " << table_info->GetTableName() << ": " << FragmentationReport::FromPageIds(page_ids)
+              << std::endl;
+    std::vector<IndexInfo *> indexes;
+    engine.catalog_mgr_->GetTableIndexes(table_info->GetTableName(), indexes);
+    for (auto index_info : indexes) {
+      auto index = dynamic_cast<BPlusTreeIndex *>(index_info->GetIndex());
+      if (index == nullptr) {
+        continue;
+      }
+      page_ids = FragmentationReport::LeafPageIds(bpm, index->GetRootPageId());
+      std::cout << "  index " << index_info->GetIndexName() << " leaves: " << FragmentationReport::FromPageIds(page_ids)
+                << std::endl;
+    }
+  }
+  return 0;
+}
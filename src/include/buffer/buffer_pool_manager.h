@@ -1,10 +1,18 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
+#include <condition_variable>
+#include <deque>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_ring.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
@@ -12,19 +20,88 @@
 
 using namespace std;
 
+/**
+ * Counters of the buffer pool, summed over all instances.
+ */
+struct BufferPoolStats {
+  uint64_t hits_{0};       // FetchPage found the page in the pool
+  uint64_t misses_{0};     // FetchPage had to read the page from disk
+  uint64_t evictions_{0};  // a page was replaced to make room for another one
+  uint64_t ring_hits_{0};    // FetchPage through a buffer ring found the page in the pool
+  uint64_t ring_misses_{0};  // FetchPage through a buffer ring had to read the page from disk
+  uint64_t prefetches_{0};   // pages read by the read-ahead threads
+  uint64_t victim_writes_{0};      // dirty victims written back by a foreground FetchPage/NewPage
+  uint64_t background_writes_{0};  // dirty pages cleaned by the background writer
+
+  inline double HitRate() const { return hits_ + misses_ == 0 ? 0 : static_cast<double>(hits_) / (hits_ + misses_); }
+};
+
+/**
+ * BufferPoolManager caches disk pages in memory frames.
+ *
+ * The pool is split into `num_instances` independent instances. A page always lives in the instance selected by
+ * `page_id % num_instances`, and each instance owns its own frames, page table, free list, replacer and latch, so
+ * requests for pages in different instances never wait for each other (not even for each other's disk I/O).
+ *
+ * The frames of all instances are carved out of one PAGE_SIZE aligned slab, as required by direct I/O. The slab is an
+ * anonymous mapping, so frames only take memory once used, and it can be backed by transparent huge pages.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
+                             size_t num_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                             ReplacerType replacer_type = ReplacerType::LRU, size_t lru_k = DEFAULT_LRU_K,
+                             bool huge_pages = DEFAULT_HUGE_PAGES);
 
   ~BufferPoolManager();
 
   Page *FetchPage(page_id_t page_id);
 
+  /**
+   * Fetch a page using a buffer ring, on a miss the page is loaded into one of the ring's frames.
+   * @param ring buffer ring of the scan, nullptr to use the main pool
+   */
+  Page *FetchPage(page_id_t page_id, BufferRing *ring);
+
+  /**
+   * Ask the background I/O threads to load the pages into the pool, unpinned. Returns immediately, pages already in
+   * the pool are skipped.
+   * @param ring buffer ring the pages are loaded into, nullptr to use the main pool
+   */
+  void PrefetchPages(const vector<page_id_t> &page_ids, const shared_ptr<BufferRing> &ring = nullptr);
+
+  /**
+   * @return whether the page is currently in the pool, the answer may be stale as soon as it is returned
+   */
+  bool IsPageCached(page_id_t page_id);
+
+  /**
+   * @return whether the page is in the pool with a non-zero pin count, the answer may be stale as soon as it is returned
+   */
+  bool IsPagePinned(page_id_t page_id);
+
+  /**
+   * Copy `size` bytes at `offset` of a page in the pool without pinning it, so the read does not count as an access in
+   * the replacer. Used by scans to follow a chain of pages ahead of themselves.
+   * @return false if the page is not in the pool, is still being read, or is write latched
+   */
+  bool PeekPage(page_id_t page_id, size_t offset, size_t size, void *data);
+
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
   bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  /**
+   * Write back every dirty page. The pages of each instance are submitted as one batch of asynchronous writes, in
+   * ascending page id order so the writes are sequential on disk. The disk manager's bitmaps and meta page follow.
+   */
+  void FlushAllPages();
+
+  /**
+   * Allocate a page and pin it in a zeroed frame.
+   * @param hint a page of the same table heap or index, the new page is placed next to it on disk when possible
+   */
+  Page *NewPage(page_id_t &page_id, page_id_t hint = INVALID_PAGE_ID);
 
   bool DeletePage(page_id_t page_id);
 
@@ -32,27 +109,149 @@ class BufferPoolManager {
 
   bool CheckAllUnpinned();
 
+  /** @return total number of frames in the pool */
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  /** @return bytes of frame memory reserved by the pool */
+  inline size_t GetFrameMemorySize() const { return slab_size_; }
+
+  /** @return number of independent buffer pool instances */
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+  /** @return hit/miss counters accumulated since construction or the last ResetStats */
+  BufferPoolStats GetStats();
+
+  void ResetStats();
+
+  /**
+   * Run one round of the background writer in the calling thread, so tests do not depend on its timer.
+   */
+  void RunBackgroundWriter();
+
  private:
+  /**
+   * One independent slice of the buffer pool, protected by its own latch. Frame ids are local to the instance.
+   */
+  struct BufferPoolInstance {
+    Page *pages_;                                      // frames owned by this instance
+    size_t pool_size_;                                 // number of frames owned by this instance
+    unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
+    Replacer *replacer_;                               // to find an unpinned page for replacement
+    list<frame_id_t> free_list_;                       // to find a free page for replacement
+    recursive_mutex latch_;                            // to protect shared data structure
+    condition_variable_any io_cv_;                     // signalled when read-ahead frames or write backs finish
+    size_t writebacks_{0};                             // frames whose write back is in flight
+    BufferPoolStats stats_;                            // counters of this instance
+  };
+
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(page_id_t hint);
 
   /**
    * Deallocate page (operations like drop index/table) Need bitmap in header page for tracking pages
    */
   void DeallocatePage(page_id_t page_id);
 
-  frame_id_t TryToFindFreePage();
+  /**
+   * @return the instance responsible for the page
+   */
+  inline BufferPoolInstance &GetInstance(page_id_t page_id) { return *instances_[GetInstanceIndex(page_id)]; }
+
+  inline size_t GetInstanceIndex(page_id_t page_id) const { return page_id % instances_.size(); }
+
+  /**
+   * Find a frame in the instance from its free list or replacer, writing back the victim if it is dirty.
+   * Note: the caller must hold the instance latch
+   */
+  frame_id_t TryToFindFreePage(BufferPoolInstance &instance);
+
+  /**
+   * Take a victim from the replacer, skipping frames whose write back is in flight.
+   * Note: the caller must hold the instance latch
+   */
+  bool PickVictim(BufferPoolInstance &instance, frame_id_t *frame_id);
+
+  /**
+   * Find a frame for a page loaded through a buffer ring: recycle the oldest frame of the ring if it is still unused,
+   * otherwise take one from the instance and add it to the ring.
+   * Note: the caller must hold the instance latch
+   */
+  frame_id_t TryToFindRingFrame(BufferPoolInstance &instance, BufferRing &ring, page_id_t page_id);
+
+  /**
+   * Give the ring one slot list per instance. Only called by the thread owning the ring, before any I/O thread sees it.
+   */
+  void InitRing(BufferRing &ring);
+
+  /** A page waiting to be read by the read-ahead threads */
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    shared_ptr<BufferRing> ring_;  // keeps the ring alive until the page is loaded
+  };
+
+  /**
+   * Look up a page, waiting for a read-ahead thread to publish its frame if the page is still being read.
+   * Note: the caller must hold the instance latch through `lock`
+   */
+  unordered_map<page_id_t, frame_id_t>::iterator FindPage(BufferPoolInstance &instance, page_id_t page_id,
+                                                          unique_lock<recursive_mutex> &lock);
+
+  /**
+   * Read pages of the instance into the pool without pinning them, used by the read-ahead threads. The frames are
+   * mapped and marked as pending under the instance latch, the reads are submitted together and waited for without
+   * the latch, then the frames are published.
+   */
+  void LoadPages(BufferPoolInstance &instance, const vector<PrefetchRequest> &requests);
+
+  /**
+   * Write back the given (page id, frame id) pairs as one batch of asynchronous writes and clear their dirty flag. The
+   * latch is released during the writes, a page modified meanwhile is dirty again once it is unpinned.
+   * Note: the caller must hold the instance latch through `lock`
+   */
+  void WritePages(BufferPoolInstance &instance, const vector<pair<page_id_t, frame_id_t>> &pages,
+                  unique_lock<recursive_mutex> &lock);
+
+  /**
+   * Wait until the write back of the frame is done.
+   * Note: the caller must hold the instance latch through `lock`
+   */
+  void WaitForWriteBack(BufferPoolInstance &instance, frame_id_t frame_id, unique_lock<recursive_mutex> &lock);
+
+  /**
+   * Main loop of a read-ahead thread.
+   */
+  void PrefetchWorker();
+
+  /**
+   * Main loop of the background writer: periodically write back dirty unpinned frames that are close to being
+   * victimized, so FetchPage and NewPage rarely have to write a victim themselves.
+   */
+  void BackgroundWriter();
+
+  /**
+   * Write back dirty frames among the next victims of the instance as one batch.
+   */
+  void CleanVictims(BufferPoolInstance &instance);
 
  private:
-  size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
-  DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
-  list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  size_t pool_size_;                         // number of pages in buffer pool
+  Page *pages_;                              // array of pages
+  char *slab_;                               // frame memory of all pages, PAGE_SIZE aligned
+  void *slab_mapping_;                       // the mapping holding the slab, may start before it
+  size_t slab_size_;                         // bytes of the slab
+  size_t slab_mapping_size_;                 // bytes of the mapping
+  DiskManager *disk_manager_;                // pointer to the disk manager.
+  vector<BufferPoolInstance *> instances_;   // independent slices of the pool
+
+  mutex background_latch_;                    // protects the read-ahead queue and the shutdown flag
+  condition_variable prefetch_cv_;
+  condition_variable writer_cv_;
+  deque<PrefetchRequest> prefetch_queue_;
+  vector<thread> prefetch_threads_;           // started on the first PrefetchPages call
+  thread writer_thread_;
+  bool shutdown_{false};
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
@@ -0,0 +1,38 @@
+#ifndef MINISQL_BUFFER_RING_H
+#define MINISQL_BUFFER_RING_H
+
+#include <vector>
+
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * BufferRing is a buffer access strategy for large sequential reads.
+ *
+ * Pages fetched through a ring that miss the pool recycle the frames the ring loaded before, instead of evicting
+ * pages of the main pool, so a full table scan only ever occupies about `ring_size` frames. A ring belongs to a single
+ * scan and must not be shared between threads.
+ */
+class BufferRing {
+  friend class BufferPoolManager;
+
+ public:
+  explicit BufferRing(size_t ring_size = DEFAULT_BUFFER_RING_SIZE) : ring_size_(ring_size > 0 ? ring_size : 1) {}
+
+  /** @return number of frames the ring may occupy */
+  inline size_t GetRingSize() const { return ring_size_; }
+
+ private:
+  /** A frame loaded through the ring and the page it was loaded with */
+  struct Slot {
+    frame_id_t frame_id_;
+    page_id_t page_id_;
+  };
+
+  size_t ring_size_;
+  vector<vector<Slot>> slots_;  // slots of every buffer pool instance, sized on first use
+  vector<size_t> next_;         // next slot to recycle in every instance
+};
+
+#endif  // MINISQL_BUFFER_RING_H
@@ -39,6 +39,8 @@ class CLOCKReplacer : public Replacer {
 
   size_t Size() override;
 
+  void PeekVictims(size_t count, vector<frame_id_t> &frames) override;
+
  private:
   size_t capacity;
   list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
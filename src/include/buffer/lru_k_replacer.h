@@ -0,0 +1,71 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "glog/logging.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * Every frame remembers the timestamps of its last K accesses. The victim is the evictable frame whose K-th most
+ * recent access is the oldest (largest backward K-distance). Frames with fewer than K accesses have an infinite
+ * distance and are evicted first, in order of their first access. A page touched once by a scan therefore leaves
+ * the pool before a page that is looked up repeatedly.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of accesses remembered per frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = DEFAULT_LRU_K);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  /**
+   * Pin a frame and record an access to it. The buffer pool pins a frame on every fetch.
+   */
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  void PeekVictims(size_t count, vector<frame_id_t> &frames) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+ private:
+  /** (has K accesses, K-th most recent access or first access, frame id), smallest is evicted first */
+  using EvictKey = tuple<bool, uint64_t, frame_id_t>;
+
+  EvictKey GetEvictKey(frame_id_t frame_id) const;
+
+  inline bool IsValidFrame(frame_id_t frame_id) const {
+    return frame_id >= 0 && static_cast<size_t>(frame_id) < max_size_;
+  }
+
+ private:
+  size_t k_;
+  size_t max_size_;
+  uint64_t current_timestamp_{0};
+  vector<uint64_t> history_;       // ring buffer of the last k_ access timestamps of every frame
+  vector<size_t> access_count_;    // number of accesses recorded since the frame got its page
+  vector<bool> evictable_;
+  set<EvictKey> evictable_set_;
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
@@ -3,7 +3,6 @@
 
 #include <list>
 #include <mutex>
-#include <unordered_set>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -14,6 +13,9 @@ using namespace std;
 
 /**
  * LRUReplacer implements the Least Recently Used replacement policy.
+ *
+ * Frames are linked into an intrusive doubly linked list stored in an array indexed by frame id, so Victim, Pin and
+ * Unpin are all O(1) and never allocate.
  */
 class LRUReplacer : public Replacer {
  public:
@@ -36,10 +38,23 @@ class LRUReplacer : public Replacer {
 
   size_t Size() override;
 
-private:
-  // add your own private member variables here
-  list<frame_id_t> lru_list_;
-  unordered_set<frame_id_t> lru_set_;
+  void PeekVictims(size_t count, vector<frame_id_t> &frames) override;
+
+ private:
+  /** Link of one frame in the lru list, the last node is the list head */
+  struct Node {
+    frame_id_t prev_{INVALID_FRAME_ID};
+    frame_id_t next_{INVALID_FRAME_ID};
+    bool in_list_{false};
+  };
+
+  inline void Link(frame_id_t frame_id);
+
+  inline void Unlink(frame_id_t frame_id);
+
+ private:
+  vector<Node> nodes_;  // nodes_[max_size_] is the sentinel, its next_ is the least recently used frame
+  size_t size_{0};
   size_t max_size_;
 };
 
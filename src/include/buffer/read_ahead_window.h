@@ -0,0 +1,49 @@
+#ifndef MINISQL_READ_AHEAD_WINDOW_H
+#define MINISQL_READ_AHEAD_WINDOW_H
+
+#include <deque>
+#include <memory>
+
+#include "buffer/buffer_pool_manager.h"
+
+/**
+ * Read-ahead state of a scan following a chain of pages, the pages of a table heap or the leaves of a B+ tree.
+ *
+ * The window holds the pages after the current one that were already handed to the read-ahead threads, in chain
+ * order, so entering a page only extends it at its end. Links are read with BufferPoolManager::PeekPage, which neither
+ * pins the page nor counts as an access in the replacer. The window is only refilled once half of it is used up, and
+ * the new pages are queued as one PrefetchPages batch, so the read-ahead threads wake up once per batch, not per page.
+ *
+ * The link out of a page is only known once the page is in the pool. The pages of a chain are allocated next to each
+ * other in the owner's reservation of PAGE_RESERVATION_SIZE pages, see DiskManager::AllocatePage, so as long as the
+ * chain was sequential the window guesses the ids after its last known page up to the end of that reservation instead
+ * of waiting for it, a wrong guess is dropped as soon as the real link is read.
+ */
+class ReadAheadWindow {
+ public:
+  ReadAheadWindow() = default;
+
+  /**
+   * @param size number of pages kept in flight ahead of the scan, 0 disables read-ahead
+   * @param next_page_offset byte offset of the next page id in the pages of the chain
+   * @param ring buffer ring the pages are loaded into, nullptr to use the main pool
+   */
+  ReadAheadWindow(BufferPoolManager *buffer_pool_manager, size_t size, size_t next_page_offset,
+                  shared_ptr<BufferRing> ring = nullptr);
+
+  /**
+   * Move the window past `page_id`, the page the scan just entered, and fill it up again.
+   * @param next_page_id the page after `page_id` in the chain
+   */
+  void Advance(page_id_t page_id, page_id_t next_page_id);
+
+ private:
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  size_t size_{0};
+  size_t next_page_offset_{0};
+  shared_ptr<BufferRing> ring_;
+  deque<page_id_t> pages_;  // pages after the current one already queued, in chain order
+  size_t known_{0};         // leading pages of the window reached through real links, the others are guesses
+};
+
+#endif  // MINISQL_READ_AHEAD_WINDOW_H
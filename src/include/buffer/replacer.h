@@ -2,6 +2,7 @@
 #define MINISQL_REPLACER_H
 
 #include <cstdio>
+#include <vector>
 
 #include "common/config.h"
 
@@ -35,6 +36,24 @@ class Replacer {
 
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * Forget a frame whose page has been deleted, the frame goes back to the free list.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Look at the frames that would be victimized next, without removing them.
+   * @param count maximum number of frames to return
+   * @param[out] frames the candidates, the next victim first
+   */
+  virtual void PeekVictims(size_t /* count */, std::vector<frame_id_t> &/* frames */) {}
 };
 
+/**
+ * Replacement policies supported by the buffer pool.
+ */
+enum class ReplacerType { LRU, CLOCK, LRU_K };
+
 #endif  // MINISQL_REPLACER_H
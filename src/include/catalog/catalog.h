@@ -107,6 +107,16 @@ class CatalogManager {
 
   dberr_t LoadIndex(const index_id_t index_id, const page_id_t page_id);
 
+  /**
+   * Free the tree of an index whose keys are in the Row layout, and leave the index empty.
+   */
+  void DropLegacyIndexTree(IndexMetadata *index_meta, TableInfo *table_info);
+
+  /**
+   * Insert the keys of every tuple of the table into an empty index.
+   */
+  dberr_t FillIndex(IndexInfo *index_info, TableInfo *table_info);
+
   dberr_t GetTable(const table_id_t table_id, TableInfo *&table_info);
 
  private:
@@ -33,6 +33,9 @@ class IndexMetadata {
 
   inline index_id_t GetIndexId() const { return index_id_; }
 
+  /** @return whether the tree of the index was written with keys in the Row layout, before memcomparable keys */
+  inline bool HasLegacyKeys() const { return legacy_keys_; }
+
  private:
   IndexMetadata() = delete;
 
@@ -41,10 +44,12 @@ class IndexMetadata {
 
  private:
   static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344528;
+  static constexpr uint32_t INDEX_METADATA_MEMCMP_MAGIC_NUM = 344530;  // the tree holds memcomparable keys
   index_id_t index_id_;
   std::string index_name_;
   table_id_t table_id_;
   std::vector<uint32_t> key_map_; /** The mapping of index key to tuple key */
+  bool legacy_keys_{false};
 };
 
 /**
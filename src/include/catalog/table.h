@@ -23,7 +23,7 @@ class TableMetadata {
    * will create new table schema and owned by mem heap
    */
   static TableMetadata *Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                               TableSchema *schema);
+                               TableSchema *schema, page_id_t free_space_map_page_id = INVALID_PAGE_ID);
 
   inline table_id_t GetTableId() const { return table_id_; }
 
@@ -33,17 +33,24 @@ class TableMetadata {
 
   inline Schema *GetSchema() const { return schema_; }
 
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_page_id_; }
+
+  inline void SetFreeSpaceMapPageId(page_id_t page_id) { free_space_map_page_id_ = page_id; }
+
  private:
   TableMetadata() = delete;
 
-  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema);
+  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                page_id_t free_space_map_page_id = INVALID_PAGE_ID);
 
  private:
   static constexpr uint32_t TABLE_METADATA_MAGIC_NUM = 344528;
+  static constexpr uint32_t TABLE_METADATA_FSM_MAGIC_NUM = 344529;  // followed by the free space map page id
   table_id_t table_id_;
   std::string table_name_;
   page_id_t root_page_id_;
   Schema *schema_;
+  page_id_t free_space_map_page_id_;
 };
 
 /**
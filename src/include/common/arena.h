@@ -0,0 +1,79 @@
+#ifndef MINISQL_ARENA_H
+#define MINISQL_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/config.h"
+
+/**
+ * Bump allocator for memory that lives as long as a statement, e.g. the CHAR data of the rows a query produces.
+ *
+ * Allocating moves a pointer through the current block, nothing is freed on its own; Reset or the destructor
+ * release everything at once. Requests larger than a quarter of a block get a block of their own so they do not
+ * waste the rest of the current one.
+ */
+class Arena {
+ public:
+  explicit Arena(size_t block_size = ARENA_BLOCK_SIZE) : block_size_(block_size) {}
+
+  ~Arena() = default;
+
+  Arena(const Arena &) = delete;
+
+  Arena &operator=(const Arena &) = delete;
+
+  /**
+   * @return `size` bytes aligned to `align`, valid until the arena is reset or destroyed
+   */
+  char *Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    size_t padding = (align - reinterpret_cast<uintptr_t>(cursor_) % align) % align;
+    if (cursor_ != nullptr && padding + size <= remaining_) {
+      char *ptr = cursor_ + padding;
+      cursor_ = ptr + size;
+      remaining_ -= padding + size;
+      return ptr;
+    }
+    if (size > block_size_ / 4) {
+      char *block = NewBlock(size + align - 1);
+      return block + (align - reinterpret_cast<uintptr_t>(block) % align) % align;
+    }
+    char *block = NewBlock(block_size_);
+    padding = (align - reinterpret_cast<uintptr_t>(block) % align) % align;
+    cursor_ = block + padding + size;
+    remaining_ = block_size_ - padding - size;
+    return block + padding;
+  }
+
+  /**
+   * Release all the memory handed out.
+   */
+  void Reset() {
+    blocks_.clear();
+    cursor_ = nullptr;
+    remaining_ = 0;
+    allocated_bytes_ = 0;
+  }
+
+  /** @return bytes of all the blocks the arena holds */
+  inline size_t GetAllocatedBytes() const { return allocated_bytes_; }
+
+  inline size_t GetBlockCount() const { return blocks_.size(); }
+
+ private:
+  char *NewBlock(size_t size) {
+    blocks_.emplace_back(new char[size]);
+    allocated_bytes_ += size;
+    return blocks_.back().get();
+  }
+
+  size_t block_size_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char *cursor_{nullptr};  // next free byte of the current block
+  size_t remaining_{0};    // free bytes after cursor_
+  size_t allocated_bytes_{0};
+};
+
+#endif  // MINISQL_ARENA_H
@@ -15,9 +15,28 @@ static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index
 
 static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
 static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 1;  // default number of buffer pool instances
+static constexpr int DEFAULT_LRU_K = 2;                  // default K of the LRU-K replacer
+static constexpr int DEFAULT_BUFFER_RING_SIZE = 32;      // default number of frames of a scan buffer ring
+static constexpr int DEFAULT_PREFETCH_THREADS = 2;       // number of background read-ahead threads
+static constexpr int DEFAULT_READ_AHEAD_PAGES = 8;       // default look-ahead window of scans in pages
+static constexpr int BG_WRITER_INTERVAL_MS = 50;         // how often the background writer wakes up
+static constexpr int BG_WRITER_LOOKAHEAD = 64;           // frames near the eviction end cleaned per instance and round
+static constexpr bool DEFAULT_USE_IO_URING = false;      // submit page I/O through io_uring when the kernel supports it
+static constexpr int IO_URING_QUEUE_DEPTH = 64;          // submission queue entries of the io_uring backend
+static constexpr int PREFETCH_BATCH_SIZE = 16;           // read-ahead requests submitted together by one I/O thread
+static constexpr int INSERT_BATCH_SIZE = 1024;           // rows InsertExecutor and bulk loads hand to TableHeap at once
+static constexpr bool DEFAULT_DIRECT_IO = false;         // open the db file with O_DIRECT, bypassing the OS page cache
+static constexpr bool DEFAULT_HUGE_PAGES = false;        // ask for transparent huge pages for the buffer pool frames
+static constexpr int PAGE_RESERVATION_SIZE = 64;         // contiguous pages reserved at a time for a table heap or index
+static constexpr size_t SORT_MEMORY_SIZE = 16 << 20;     // memory an index build sorts keys in before spilling runs
+static constexpr double DEFAULT_FILL_FACTOR = 0.9;       // how full a bulk load packs the nodes of a B+ tree
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
+static constexpr uint32_t FIELD_INLINE_LEN = 16;            // CHAR values up to this length are kept inside the Field
+static constexpr size_t ROW_INLINE_FIELDS = 12;             // fields a Row holds without allocating
+static constexpr size_t ARENA_BLOCK_SIZE = 64 * 1024;       // block size of the per-statement arena
 
 // static std::string DB_META_FILE = "minisql.meta.db";
 
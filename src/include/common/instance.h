@@ -14,7 +14,10 @@
 
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           uint32_t buffer_pool_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                           ReplacerType replacer_type = ReplacerType::LRU, uint32_t lru_k = DEFAULT_LRU_K,
+                           bool direct_io = DEFAULT_DIRECT_IO);
 
   ~DBStorageEngine();
 
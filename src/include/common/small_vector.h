@@ -0,0 +1,141 @@
+#ifndef MINISQL_SMALL_VECTOR_H
+#define MINISQL_SMALL_VECTOR_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+/**
+ * A vector that keeps its first N elements inside the object, it only allocates once it grows beyond them.
+ * Elements are constructed in place with emplace_back, a moved vector steals the heap buffer or moves the elements.
+ */
+template <typename T, size_t N>
+class SmallVector {
+ public:
+  SmallVector() = default;
+
+  SmallVector(const SmallVector &other) {
+    reserve(other.size_);
+    for (const auto &element : other) {
+      emplace_back(element);
+    }
+  }
+
+  SmallVector(SmallVector &&other) noexcept { MoveFrom(other); }
+
+  ~SmallVector() {
+    clear();
+    FreeHeap();
+  }
+
+  SmallVector &operator=(const SmallVector &other) {
+    if (this != &other) {
+      clear();
+      reserve(other.size_);
+      for (const auto &element : other) {
+        emplace_back(element);
+      }
+    }
+    return *this;
+  }
+
+  SmallVector &operator=(SmallVector &&other) noexcept {
+    if (this != &other) {
+      clear();
+      FreeHeap();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  template <typename... Args>
+  T &emplace_back(Args &&...args) {
+    if (size_ == capacity_) {
+      reserve(capacity_ * 2);
+    }
+    T *element = new (data_ + size_) T(std::forward<Args>(args)...);
+    size_++;
+    return *element;
+  }
+
+  void push_back(T &&element) { emplace_back(std::move(element)); }
+
+  /** Destroy the elements, the capacity is kept */
+  void clear() {
+    for (size_t i = 0; i < size_; i++) {
+      data_[i].~T();
+    }
+    size_ = 0;
+  }
+
+  void reserve(size_t capacity) {
+    if (capacity <= capacity_) {
+      return;
+    }
+    T *data = static_cast<T *>(::operator new(capacity * sizeof(T)));
+    for (size_t i = 0; i < size_; i++) {
+      new (data + i) T(std::move(data_[i]));
+      data_[i].~T();
+    }
+    FreeHeap();
+    data_ = data;
+    capacity_ = capacity;
+  }
+
+  inline size_t size() const { return size_; }
+
+  inline bool empty() const { return size_ == 0; }
+
+  /** @return whether the elements are still in the inline buffer, false once they spilled to the heap */
+  inline bool IsInline() const { return data_ == InlineData(); }
+
+  inline T &operator[](size_t i) { return data_[i]; }
+
+  inline const T &operator[](size_t i) const { return data_[i]; }
+
+  inline T *begin() { return data_; }
+
+  inline T *end() { return data_ + size_; }
+
+  inline const T *begin() const { return data_; }
+
+  inline const T *end() const { return data_ + size_; }
+
+ private:
+  inline T *InlineData() { return reinterpret_cast<T *>(inline_); }
+
+  inline const T *InlineData() const { return reinterpret_cast<const T *>(inline_); }
+
+  void FreeHeap() {
+    if (!IsInline()) {
+      ::operator delete(data_);
+      data_ = InlineData();
+      capacity_ = N;
+    }
+  }
+
+  /** Take the elements of `other` and leave it empty, this vector must be empty and inline */
+  void MoveFrom(SmallVector &other) {
+    if (other.IsInline()) {
+      for (size_t i = 0; i < other.size_; i++) {
+        new (data_ + i) T(std::move(other.data_[i]));
+      }
+      size_ = other.size_;
+      other.clear();
+      return;
+    }
+    data_ = other.data_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    other.data_ = other.InlineData();
+    other.size_ = 0;
+    other.capacity_ = N;
+  }
+
+  alignas(T) char inline_[N * sizeof(T)];
+  T *data_{InlineData()};
+  size_t size_{0};
+  size_t capacity_{N};
+};
+
+#endif  // MINISQL_SMALL_VECTOR_H
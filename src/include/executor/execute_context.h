@@ -7,6 +7,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
+#include "common/arena.h"
 #include "common/macros.h"
 #include "transaction/transaction.h"
 
@@ -34,6 +35,9 @@ class ExecuteContext {
   /** @return the buffer pool manager */
   BufferPoolManager *GetBufferPoolManager() { return bpm_; }
 
+  /** @return memory of the statement, released with the context, for the rows and values the executors produce */
+  Arena *GetArena() { return &arena_; }
+
  private:
   /** The transaction context associated with this executor context */
   Transaction *transaction_;
@@ -41,6 +45,8 @@ class ExecuteContext {
   CatalogManager *catalog_;
   /** The buffer pool manager associated with this executor context */
   BufferPoolManager *bpm_;
+  /** Statement lifetime memory */
+  Arena arena_;
 };
 
 #endif  // MINISQL_EXECUTE_CONTEXT_H
@@ -45,6 +45,17 @@ class ExecuteEngine {
 
   void ExecuteInformation(dberr_t result);
 
+  /**
+   * Append rows to a table in batches of INSERT_BATCH_SIZE, without going through the planner and without unique
+   * checks. The row ids of the inserted rows are set in `rows`.
+   */
+  dberr_t BulkLoad(const std::string &table_name, std::vector<Row> &rows, ExecuteContext *context);
+
+  /**
+   * Compact the table heap of a table, see TableHeap::Vacuum, and point its indexes at the moved rows.
+   */
+  dberr_t Vacuum(const std::string &table_name, ExecuteContext *context, VacuumStats *stats);
+
  private:
   static std::unique_ptr<AbstractExecutor> CreateExecutor(ExecuteContext *exec_ctx, const AbstractPlanNodeRef &plan);
 
@@ -78,6 +89,10 @@ class ExecuteEngine {
 
   dberr_t ExecuteQuit(pSyntaxNode ast, ExecuteContext *context);
 
+  dberr_t ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteAnalyze(pSyntaxNode ast, ExecuteContext *context);
+
  private:
   std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
   std::string current_db_;                                 /** current database */
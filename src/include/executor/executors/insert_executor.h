@@ -5,6 +5,9 @@
 #ifndef MINISQL_INSERT_EXECUTOR_H
 #define MINISQL_INSERT_EXECUTOR_H
 
+#include <string>
+#include <unordered_set>
+
 #include "executor/execute_context.h"
 #include "executor/executors/abstract_executor.h"
 #include "executor/plans/insert_plan.h"
@@ -12,7 +15,8 @@
 /**
  * InsertExecutor executes an insert on a table.
  *
- * Inserted values are always pulled from a child executor.
+ * Inserted values are always pulled from a child executor, in batches of INSERT_BATCH_SIZE rows that are written with
+ * TableHeap::InsertTuples.
  */
 class InsertExecutor : public AbstractExecutor {
  public:
@@ -42,6 +46,11 @@ class InsertExecutor : public AbstractExecutor {
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
  private:
+  /**
+   * Check the unique columns of the batch against their index and against each other.
+   */
+  bool CheckUnique();
+
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_executor_;
@@ -49,6 +58,8 @@ class InsertExecutor : public AbstractExecutor {
   TableHeap *table_heap_;
   std::vector<IndexInfo *> indexes_;
   std::vector<std::pair<uint32_t, Column *>> unique_columns_;
+  std::vector<Row> batch_;  // rows of the last inserted batch
+  size_t emitted_{0};       // rows of the batch already returned by Next
 };
 
 #endif  // MINISQL_INSERT_EXECUTOR_H
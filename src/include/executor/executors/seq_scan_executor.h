@@ -45,12 +45,19 @@ class SeqScanExecutor : public AbstractExecutor {
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
  private:
+  /**
+   * @return false if the zone map shows that no row of the page can satisfy `predicate`
+   */
+  bool PageMayMatch(page_id_t page_id, const AbstractExpressionRef &predicate) const;
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   TableIterator *table_iter_;
   TableIterator *end_iter_;
   const Schema *schema_;
   const Schema *key_schema_;
+  std::vector<uint32_t> columns_;  // column of schema_ behind each output column
+  ZoneMap *zone_map_{nullptr};
 };
 
 #endif  // MINISQL_SEQ_SCAN_EXECUTOR_H
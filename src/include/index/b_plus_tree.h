@@ -1,10 +1,17 @@
 #ifndef MINISQL_B_PLUS_TREE_H
 #define MINISQL_B_PLUS_TREE_H
 
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <mutex>
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "common/rwlatch.h"
+#include "index/comparator.h"
 #include "index/index_iterator.h"
 #include "page/b_plus_tree_internal_page.h"
 #include "page/b_plus_tree_leaf_page.h"
@@ -20,18 +27,35 @@
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * The tree is instantiated per key width and comparator so the page layout is computed at compile time, KeySize 0
+ * reads the width of the keys from the KeyManager instead.
+ *
+ * Sessions share the tree through latch crabbing: lookups read latch a node before releasing its parent, inserts and
+ * removes write latch their way down and release the nodes above as soon as the current one cannot split or merge.
+ * root_latch_ guards changes of root_page_id_ and is held like a latch on the parent of the root.
+ *
+ * With optimistic lock coupling, the default, operations first go down to the leaf without latching the pages above
+ * it. A page is read at the version it had before and validated afterwards, the search restarts if a writer latched
+ * it meanwhile. Lookups fall back to crabbing after a few restarts, inserts and removes as soon as the leaf may split
+ * or merge, since only crabbing latches the pages above it.
  */
+template <int KeySize = 0, typename KeyComparator = GenericComparator<KeySize>>
 class BPlusTree {
-  using InternalPage = BPlusTreeInternalPage;
-  using LeafPage = BPlusTreeLeafPage;
+  using InternalPage = BPlusTreeInternalPage<KeySize, KeyComparator>;
+  using LeafPage = BPlusTreeLeafPage<KeySize, KeyComparator>;
 
  public:
   explicit BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &comparator,
                      int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE);
 
+  ~BPlusTree();
+
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
+  inline page_id_t GetRootPageId() const { return root_page_id_; }
+
   // Insert a key-value pair into this B+ tree.
   bool Insert(GenericKey *key, const RowId &value, Transaction *transaction = nullptr);
 
@@ -41,13 +65,36 @@ class BPlusTree {
   // return the value associated with a given key
   bool GetValue(const GenericKey *key, std::vector<RowId> &result, Transaction *transaction = nullptr);
 
+  /**
+   * Build the empty tree bottom-up from the pairs `next` produces in ascending key order until it returns false.
+   * Leaves are packed left to right up to `fill_factor` of their max size, then each level of internal pages is built
+   * on top of the one below, the last nodes of a level are balanced so that none is less than half full. A pair with
+   * the key of the one before is skipped, as Insert would reject it.
+   * @return false if the tree is not empty
+   */
+  bool BulkLoad(const std::function<bool(GenericKey *&key, RowId &value)> &next,
+                double fill_factor = DEFAULT_FILL_FACTOR);
+
   IndexIterator Begin();
 
   IndexIterator Begin(const GenericKey *key);
 
   IndexIterator End();
 
-  // expose for test purpose
+  /**
+   * Set the number of leaf pages range scans read asynchronously ahead of the iterator, 0 disables read-ahead.
+   */
+  inline void SetReadAhead(size_t read_ahead) { read_ahead_ = read_ahead; }
+
+  /**
+   * Choose whether operations go down to the leaf optimistically before falling back to latch crabbing.
+   */
+  inline void SetOptimisticLockCoupling(bool enable) { optimistic_lock_coupling_ = enable; }
+
+  /**
+   * Find the leaf page holding `key`, or the left most leaf, starting from `page_id` or from the root.
+   * @return the leaf, pinned and read latched, or nullptr if the tree is empty
+   */
   Page *FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
 
   // used to check whether all pages are unpinned
@@ -62,15 +109,94 @@ class BPlusTree {
     }
     out << "digraph G {" << std::endl;
     Page *root_page = buffer_pool_manager_->FetchPage(root_page_id_);
-    auto *node = reinterpret_cast<BPlusTreePage *>(root_page);
+    auto *node = reinterpret_cast<BPlusTreePage *>(root_page->GetData());
     ToGraph(node, buffer_pool_manager_, out);
     out << "}" << std::endl;
   }
 
  private:
+  /** Write operations, they decide when a node is safe */
+  enum class Operation { INSERT, REMOVE };
+
+  /** Optimistic searches a lookup restarts before it latches its way down */
+  static constexpr int MAX_OPTIMISTIC_RESTARTS = 4;
+
+  /**
+   * Latches an insert or remove holds: the root id latch while the root may change and the write latched, pinned
+   * pages from the highest node that may change down to the leaf. Pages merged away are deleted after the release.
+   */
+  struct LatchedPath {
+    bool root_latched_{false};
+    std::vector<Page *> pages_;
+    std::vector<page_id_t> deleted_pages_;
+  };
+
+  /**
+   * Counts an optimistic search in the epoch it started in for as long as it lives. Pages unlinked during that epoch
+   * are not deleted before the search is over, since it may have read their ids.
+   */
+  struct EpochGuard {
+    explicit EpochGuard(BPlusTree *tree) {
+      // the epoch may advance before the search is counted, it then counts itself in the new one
+      for (;;) {
+        uint64_t epoch = tree->epoch_.load();
+        readers_ = &tree->epoch_readers_[epoch & 1];
+        readers_->fetch_add(1);
+        if (tree->epoch_.load() == epoch) {
+          break;
+        }
+        readers_->fetch_sub(1);
+      }
+    }
+
+    ~EpochGuard() { readers_->fetch_sub(1); }
+
+    std::atomic<int> *readers_;
+  };
+
+  /**
+   * Go down to the leaf holding `key`, or the left most leaf, without latching the pages above it. A page is trusted
+   * once its version is validated, a child is trusted while its parent is unchanged since it was read.
+   * @return false if a writer got in the way, otherwise true with `leaf_page` pinned and latched for write if
+   * `exclusive` or for read, `leaf_page` is nullptr if the tree is empty
+   */
+  bool FindLeafPageOptimistic(const GenericKey *key, bool leftMost, bool exclusive, Page **leaf_page);
+
+  /**
+   * @return whether a page read without a latch is still the node `page_id` of this tree and its size is in bounds,
+   * so it can be searched until its version is validated
+   */
+  bool IsPlausibleNode(const BPlusTreePage *node, page_id_t page_id) const;
+
+  /**
+   * Write latch the path down to the leaf holding `key`, the latches above a safe node are released on the way.
+   * With optimistic lock coupling a leaf found to be safe is latched alone.
+   * @return the leaf, also the last page of `path`, or nullptr if the tree is empty, the root latch is then held
+   */
+  Page *FindLeafPageForWrite(const GenericKey *key, Operation op, LatchedPath *path);
+
+  /** @return whether `op` cannot split or merge `node`, so its ancestors will not change */
+  bool IsSafe(const BPlusTreePage *node, Operation op) const;
+
+  /** Release every latch and pin of `path`, then delete the pages merged away */
+  void ReleasePath(LatchedPath *path, bool is_dirty);
+
+  /**
+   * Delete the pages merged away that are not deleted yet. While an iterator still pins one of them, none is deleted:
+   * the pinned page may link to the others. A page also waits until the optimistic searches that started before it was
+   * unlinked are over. The pages left pending are retried on the next call.
+   */
+  void DeletePendingPages(std::vector<page_id_t> *deleted_pages);
+
   void StartNewTree(GenericKey *key, const RowId &value);
 
-  bool InsertIntoLeaf(GenericKey *key, const RowId &value, Transaction *transaction = nullptr);
+  /**
+   * Build the level of internal pages above the nodes whose first keys and page ids are given, both are replaced by
+   * the ones of the new level.
+   */
+  void BulkLoadLevel(std::vector<char> *keys, std::vector<page_id_t> *page_ids, double fill_factor);
+
+  bool InsertIntoLeaf(Page *leaf_page, GenericKey *key, const RowId &value, Transaction *transaction = nullptr);
 
   void InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node,
                         Transaction *transaction = nullptr);
@@ -80,17 +206,16 @@ class BPlusTree {
   InternalPage *Split(InternalPage *node, Transaction *transaction);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *&node, Transaction *transaction = nullptr);
+  bool CoalesceOrRedistribute(N *&node, LatchedPath *path);
 
   bool Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
-                Transaction *transaction = nullptr);
+                LatchedPath *path);
 
-  bool Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
-                Transaction *transaction = nullptr);
+  bool Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index, LatchedPath *path);
 
-  void Redistribute(LeafPage *neighbor_node, LeafPage *node, int index);
+  void Redistribute(LeafPage *neighbor_node, LeafPage *node, InternalPage *parent, int index);
 
-  void Redistribute(InternalPage *neighbor_node, InternalPage *node, int index);
+  void Redistribute(InternalPage *neighbor_node, InternalPage *node, InternalPage *parent, int index);
 
   bool AdjustRoot(BPlusTreePage *node);
 
@@ -103,11 +228,21 @@ class BPlusTree {
 
   // member variable
   index_id_t index_id_;
-  page_id_t root_page_id_{INVALID_PAGE_ID};
+  std::atomic<page_id_t> root_page_id_{INVALID_PAGE_ID};
+  ReaderWriterLatch root_latch_;
   BufferPoolManager *buffer_pool_manager_;
   KeyManager processor_;
+  KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  size_t read_ahead_{DEFAULT_READ_AHEAD_PAGES};
+  bool optimistic_lock_coupling_{true};
+  std::mutex pending_latch_;  // protects pending_pages_ and the advance of epoch_
+  // pages merged away that could not be deleted yet, with the epoch they were unlinked in
+  std::vector<std::pair<page_id_t, uint64_t>> pending_pages_;
+  std::atomic<bool> has_pending_pages_{false};  // lets releases skip pending_latch_ while nothing is pending
+  std::atomic<uint64_t> epoch_{0};              // advanced once no optimistic search of the epoch before is left
+  std::atomic<int> epoch_readers_[2]{};         // optimistic searches in progress, by parity of their epoch
 };
 
 #endif  // MINISQL_B_PLUS_TREE_H
@@ -2,12 +2,39 @@
 #define MINISQL_B_PLUS_TREE_INDEX_H
 
 #include "index/b_plus_tree.h"
+#include "index/comparator.h"
 #include "index/generic_key.h"
 #include "index/index.h"
 
+/**
+ * Index backed by a B+ tree, Create picks the tree instantiation that fits the key schema and key size.
+ */
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager);
+  /**
+   * @return an index whose tree is specialized for `key_size`, keys of a single INT column get Int32Comparator and
+   * other sizes fall back to a tree sized at run time
+   */
+  static BPlusTreeIndex *Create(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
+                                BufferPoolManager *buffer_pool_manager);
+
+  virtual IndexIterator GetBeginIterator() = 0;
+
+  virtual IndexIterator GetBeginIterator(GenericKey *key) = 0;
+
+  virtual IndexIterator GetEndIterator() = 0;
+
+  virtual page_id_t GetRootPageId() const = 0;
+
+ protected:
+  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema) : Index(index_id, key_schema) {}
+};
+
+template <int KeySize = 0, typename KeyComparator = GenericComparator<KeySize>>
+class GenericBPlusTreeIndex : public BPlusTreeIndex {
+ public:
+  GenericBPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
+                        BufferPoolManager *buffer_pool_manager);
 
   dberr_t InsertEntry(const Row &key, RowId row_id, Transaction *txn) override;
 
@@ -17,17 +44,26 @@ class BPlusTreeIndex : public Index {
 
   dberr_t Destroy() override;
 
-  IndexIterator GetBeginIterator();
+  /**
+   * Sort the keys, spilling to temporary pages if they do not fit in SORT_MEMORY_SIZE, and build the tree bottom-up
+   * from them if it is empty. Keys of a non empty tree are inserted in sorted order.
+   */
+  dberr_t BulkLoad(const std::function<bool(Row &key, RowId &row_id)> &next, Transaction *txn) override;
+
+  IndexIterator GetBeginIterator() override;
+
+  IndexIterator GetBeginIterator(GenericKey *key) override;
 
-  IndexIterator GetBeginIterator(GenericKey *key);
+  IndexIterator GetEndIterator() override;
 
-  IndexIterator GetEndIterator();
+  inline page_id_t GetRootPageId() const override { return container_.GetRootPageId(); }
 
  protected:
+  BufferPoolManager *buffer_pool_manager_;
   // comparator for key
   KeyManager processor_;
   // container
-  BPlusTree container_;
+  BPlusTree<KeySize, KeyComparator> container_;
 };
 
 #endif  // MINISQL_B_PLUS_TREE_INDEX_H
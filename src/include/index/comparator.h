@@ -1,17 +1,82 @@
-#ifndef MINISQL_BASIC_COMPARATOR_H
-#define MINISQL_BASIC_COMPARATOR_H
+#ifndef MINISQL_COMPARATOR_H
+#define MINISQL_COMPARATOR_H
 
-template <typename T>
-class BasicComparator {
+#include <endian.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "index/generic_key.h"
+
+/**
+ * Key comparators the B+ tree is instantiated with, all of them are built from the KeyManager of the index.
+ *
+ * Keys are memcomparable (see KeyManager), a comparator only decides how the bytes are compared. GenericComparator<N>
+ * compares keys of N bytes, with N known at compile time memcmp is inlined. GenericComparator<0> is the fallback for
+ * key sizes only known at run time.
+ */
+template <int KeySize>
+class GenericComparator {
+ public:
+  explicit GenericComparator(const KeyManager &) {}
+
+  inline int operator()(const GenericKey *lhs, const GenericKey *rhs) const { return memcmp(lhs, rhs, KeySize); }
+};
+
+template <>
+class GenericComparator<0> {
+ public:
+  explicit GenericComparator(const KeyManager &KM) : processor_(KM) {}
+
+  inline int operator()(const GenericKey *lhs, const GenericKey *rhs) const {
+    return processor_.CompareKeys(lhs, rhs);
+  }
+
+ private:
+  KeyManager processor_;
+};
+
+/**
+ * Comparator of keys made of a single INT column.
+ *
+ * The null marker and the big-endian value take the first 5 bytes of the key and the bytes after them are zero, so
+ * one 8 byte load and an integer comparison replace memcmp.
+ */
+class Int32Comparator {
  public:
-  inline int operator()(const T &l, const T &r) const {
-    if (l < r) {
-      return -1;
-    } else if (l > r) {
-      return 1;
-    }
-    return 0;
+  static constexpr int KEY_SIZE = 16;
+
+  explicit Int32Comparator(const KeyManager &) {}
+
+  inline int operator()(const GenericKey *lhs, const GenericKey *rhs) const {
+    uint64_t lhs_word = Load(lhs);
+    uint64_t rhs_word = Load(rhs);
+    return (lhs_word > rhs_word) - (lhs_word < rhs_word);
+  }
+
+  /** @return whether keys of `key_schema` can use this comparator */
+  static bool IsApplicable(const Schema *key_schema) {
+    return key_schema->GetColumnCount() == 1 && key_schema->GetColumn(0)->GetType() == TypeId::kTypeInt;
+  }
+
+ private:
+  static inline uint64_t Load(const GenericKey *key) {
+    uint64_t word;
+    memcpy(&word, key, sizeof(word));
+    return be64toh(word);
   }
 };
 
-#endif  // MINISQL_BASIC_COMPARATOR_H
+/**
+ * Explicitly instantiate a B+ tree class template for every key width and comparator it is used with.
+ */
+#define INSTANTIATE_B_PLUS_TREE(CLASS)                 \
+  template class CLASS<0, GenericComparator<0>>;       \
+  template class CLASS<16, GenericComparator<16>>;     \
+  template class CLASS<32, GenericComparator<32>>;     \
+  template class CLASS<64, GenericComparator<64>>;     \
+  template class CLASS<128, GenericComparator<128>>;   \
+  template class CLASS<256, GenericComparator<256>>;   \
+  template class CLASS<Int32Comparator::KEY_SIZE, Int32Comparator>;
+
+#endif  // MINISQL_COMPARATOR_H
@@ -11,60 +11,49 @@ class GenericKey {
   char data[0];
 };
 
+/**
+ * KeyManager encodes index keys so that they compare with a single memcmp.
+ *
+ * Every column of the key schema takes a fixed slot of one marker byte followed by the column length, so a key
+ * is the concatenation of its slots padded with zeros up to the key size:
+ *  - the marker is NULL_MARKER for a null value, whose slot is all zeros, and VALUE_MARKER otherwise, nulls sort first
+ *  - INT is stored big-endian with the sign bit flipped
+ *  - FLOAT is stored big-endian with the sign bit flipped for positive values and all bits flipped for negative ones
+ *  - CHAR is stored as is and padded with zeros up to the column length
+ */
 class KeyManager {
  public: /**/
   [[nodiscard]] inline GenericKey *InitKey() const {
     return (GenericKey *)malloc(key_size_);  // remember delete
   }
 
-  inline void SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const {
-    // initialize to 0
-    [[maybe_unused]] uint32_t size = key.GetSerializedSize(schema);
-    ASSERT(key.GetFieldCount() == schema->GetColumnCount(), "field nums not match.");
-    ASSERT(size <= (uint32_t)key_size_, "Index key size exceed max key size.");
-    memset(key_buf->data, 0, key_size_);
-    key.SerializeTo(key_buf->data, schema);
-  }
+  void SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const;
 
-  inline void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
-    [[maybe_unused]] uint32_t ofs = key.DeserializeFrom(const_cast<char *>(key_buf->data), schema);
-    ASSERT(ofs <= (uint32_t)key_size_, "Index key size exceed max key size.");
-  }
+  void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const;
 
   // compare
   [[nodiscard]] inline int CompareKeys(const GenericKey *lhs, const GenericKey *rhs) const {
-    //    ASSERT(malloc_usable_size((void *)&lhs) == malloc_usable_size((void *)&rhs), "key size not match.");
-    uint32_t column_count = key_schema_->GetColumnCount();
-    Row lhs_key(INVALID_ROWID);
-    Row rhs_key(INVALID_ROWID);
-    DeserializeToKey(lhs, lhs_key, key_schema_);
-    DeserializeToKey(rhs, rhs_key, key_schema_);
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Field *lhs_value = lhs_key.GetField(i);
-      Field *rhs_value = rhs_key.GetField(i);
-
-      if (lhs_value->CompareLessThan(*rhs_value) == CmpBool::kTrue) {
-        return -1;
-      }
-
-      if (lhs_value->CompareGreaterThan(*rhs_value) == CmpBool::kTrue) {
-        return 1;
-      }
-    }
-    // equals
-    return 0;
+    return memcmp(lhs->data, rhs->data, encoded_size_);
   }
 
   inline int GetKeySize() const { return key_size_; }
 
+  /**
+   * @return bytes taken by an encoded key of `key_schema`
+   */
+  static uint32_t GetEncodedSize(const Schema *key_schema);
+
   KeyManager(const KeyManager &other) {
     this->key_schema_ = other.key_schema_;
     this->key_size_ = other.key_size_;
+    this->encoded_size_ = other.encoded_size_;
   }
 
   // constructor
-  KeyManager(Schema *key_schema, size_t key_size) : key_size_(key_size), key_schema_(key_schema) {}
+  KeyManager(Schema *key_schema, size_t key_size)
+      : key_size_(key_size), encoded_size_(GetEncodedSize(key_schema)), key_schema_(key_schema) {
+    ASSERT(encoded_size_ <= static_cast<uint32_t>(key_size_), "Index key size exceed max key size.");
+  }
 
   // NOTE: FOR DEBUG
   std::string PrintKey(const GenericKey *key) const {
@@ -77,8 +66,12 @@ class KeyManager {
     return ret;
   }
 
+  static constexpr char NULL_MARKER = 0;
+  static constexpr char VALUE_MARKER = 1;
+
  private:
   int key_size_;
+  uint32_t encoded_size_;  // prefix of the key compared, the rest is always zeros
   Schema *key_schema_;
 };
 
@@ -1,6 +1,7 @@
 #ifndef MINISQL_INDEX_H
 #define MINISQL_INDEX_H
 
+#include <functional>
 #include <memory>
 
 #include "common/dberr.h"
@@ -22,6 +23,19 @@ class Index {
 
   virtual dberr_t Destroy() = 0;
 
+  /**
+   * Add the entries `next` produces until it returns false, used to fill a new index. The default inserts them one at
+   * a time, an index may instead build itself from all of them at once.
+   */
+  virtual dberr_t BulkLoad(const std::function<bool(Row &key, RowId &row_id)> &next, Transaction *txn) {
+    Row key;
+    RowId row_id;
+    while (next(key, row_id)) {
+      InsertEntry(key, row_id, txn);
+    }
+    return DB_SUCCESS;
+  }
+
  protected:
   index_id_t index_id_;
   IndexSchema *key_schema_;
@@ -1,20 +1,37 @@
 #ifndef MINISQL_INDEX_ITERATOR_H
 #define MINISQL_INDEX_ITERATOR_H
 
+#include <vector>
+
+#include "buffer/read_ahead_window.h"
+#include "common/macros.h"
 #include "page/b_plus_tree_leaf_page.h"
 
+/**
+ * Iterator over the leaf chain of a B+ tree.
+ *
+ * The iterator reads a copy of its current leaf taken under the leaf read latch, it holds no latch between calls so
+ * a scan never blocks writers. The next leaf stays pinned and cannot be deleted before the iterator gets there. Keys
+ * are memcomparable, keys moved into the next leaf after they were returned are skipped by comparing their bytes.
+ */
 class IndexIterator {
-  using LeafPage = BPlusTreeLeafPage;
+  using LeafPage = BPlusTreeLeafPage<>;
 
  public:
   // you may define your own constructor based on your member variables
   explicit IndexIterator();
 
-  explicit IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index = 0);
+  /**
+   * @param leaf_page leaf to start from, pinned and read latched, the iterator releases it
+   * @param index position in the leaf, the iterator moves to the next leaf if it is past the last key
+   */
+  explicit IndexIterator(Page *leaf_page, BufferPoolManager *bpm, int index = 0, size_t read_ahead = 0);
 
   ~IndexIterator();
 
-  /** Return the key/value pair this iterator is currently pointing at. */
+  DISALLOW_COPY(IndexIterator);
+
+  /** Return the key/value pair this iterator is currently pointing at, the key is valid until the iterator moves. */
   std::pair<GenericKey *, RowId> operator*();
 
   /** Move to the next key/value pair.*/
@@ -27,11 +44,20 @@ class IndexIterator {
   bool operator!=(const IndexIterator &itr) const;
 
  private:
+  inline LeafPage *GetLeaf() { return reinterpret_cast<LeafPage *>(leaf_data.data()); }
+
+  /** Copy `leaf_page`, pinned and read latched, pin the leaf after it and release `leaf_page` */
+  void LoadLeaf(Page *leaf_page);
+
+  /** Move to the first key of the following leaves greater than the keys of the current one, or to the end */
+  void NextLeaf();
+
   page_id_t current_page_id{INVALID_PAGE_ID};
-  LeafPage *page{nullptr};
+  std::vector<char> leaf_data;  // copy of the current leaf
+  Page *next_page{nullptr};     // leaf after the current one, pinned
   int item_index{0};
   BufferPoolManager *buffer_pool_manager{nullptr};
-  // add your own private member variables here
+  ReadAheadWindow read_ahead;  // leaves read ahead of a scan
 };
 
 #endif  // MINISQL_INDEX_ITERATOR_H
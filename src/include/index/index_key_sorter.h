@@ -0,0 +1,106 @@
+#ifndef MINISQL_INDEX_KEY_SORTER_H
+#define MINISQL_INDEX_KEY_SORTER_H
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rowid.h"
+#include "index/generic_key.h"
+
+/**
+ * External sort of the (key, RowId) pairs an index is built from.
+ *
+ * Pairs are buffered in memory until the buffer reaches `memory_size`, a full buffer is sorted and written out as a
+ * run, a chain of temporary pages allocated from the buffer pool. Once all the pairs are added, Next merges the runs in
+ * a single pass with one page of every run pinned, or reads the sorted buffer directly if nothing was spilled. Run
+ * pages are deleted as soon as the merge is past them.
+ *
+ * Keys are memcomparable (see KeyManager), pairs with equal keys come out in the order they were added.
+ *
+ * Run page format:
+ *  -----------------------------------------------------------------
+ * | NextPageId (4) | Size (4) | KEY(1) + RID(1) | ... | KEY(n) + RID(n)
+ *  -----------------------------------------------------------------
+ */
+class IndexKeySorter {
+ public:
+  IndexKeySorter(BufferPoolManager *buffer_pool_manager, const KeyManager &KM, size_t memory_size = SORT_MEMORY_SIZE);
+
+  ~IndexKeySorter();
+
+  /**
+   * Add a pair, the key is copied.
+   */
+  void Add(const GenericKey *key, RowId row_id);
+
+  /**
+   * Sort the pairs added so far, call once after the last Add.
+   */
+  void Sort();
+
+  /**
+   * Get the next pair in key order.
+   * @return false once every pair was returned, otherwise true with `key` valid until the next call
+   */
+  bool Next(GenericKey **key, RowId *row_id);
+
+  /** @return number of pairs added */
+  inline size_t GetSize() const { return size_; }
+
+  /** @return number of runs spilled to temporary pages */
+  inline size_t GetNumRuns() const { return runs_.size(); }
+
+ private:
+  /** Position of the merge in one run, the page is pinned */
+  struct RunCursor {
+    Page *page_{nullptr};
+    int index_{0};
+  };
+
+  static constexpr int RUN_PAGE_HEADER_SIZE = 8;
+
+  /** @return whether the pair at `lhs` sorts before the one at `rhs` */
+  inline bool Less(const char *lhs, const char *rhs) const {
+    return processor_.CompareKeys(reinterpret_cast<const GenericKey *>(lhs),
+                                  reinterpret_cast<const GenericKey *>(rhs)) < 0;
+  }
+
+  /** Sort the buffered pairs by key, keeping the order of equal keys */
+  void SortBuffer();
+
+  /** Sort the buffered pairs and write them out as a new run */
+  void SpillRun();
+
+  /** @return number of pairs in the run page */
+  inline int RunPageSize(Page *page) const { return *reinterpret_cast<int32_t *>(page->GetData() + sizeof(page_id_t)); }
+
+  /** @return the pair at `index` of the run page */
+  inline char *RunPagePair(Page *page, int index) const {
+    return page->GetData() + RUN_PAGE_HEADER_SIZE + index * pair_size_;
+  }
+
+  /**
+   * Move the cursor of `run` to its next pair, the page it leaves is deleted.
+   * @return false if the run is exhausted
+   */
+  bool Advance(size_t run);
+
+  /** @return whether the cursor of run `lhs` is behind the one of run `rhs` in the merge */
+  bool MergeGreater(size_t lhs, size_t rhs) const;
+
+  BufferPoolManager *buffer_pool_manager_;
+  KeyManager processor_;
+  int key_size_;
+  int pair_size_;
+  int pairs_per_page_;
+  size_t max_buffered_;          // pairs buffered before a run is spilled
+  std::vector<char> buffer_;     // buffered pairs, in the order they were added
+  std::vector<char *> sorted_;   // buffered pairs in key order
+  size_t size_{0};
+  std::vector<page_id_t> runs_;  // first page of every run
+  std::vector<RunCursor> cursors_;
+  std::vector<size_t> heap_;     // runs that are not exhausted, as a min heap on their current pair
+  size_t current_{SIZE_MAX};     // run or position in sorted_ of the pair last returned by Next
+};
+
+#endif  // MINISQL_INDEX_KEY_SORTER_H
@@ -5,6 +5,7 @@
 
 #include <queue>
 
+#include "index/comparator.h"
 #include "index/generic_key.h"
 #include "page/b_plus_tree_page.h"
 
@@ -23,6 +24,7 @@
  * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
  */
+template <int KeySize = 0, typename KeyComparator = GenericComparator<KeySize>>
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
   // must call initialize method after "create" a new node
@@ -43,7 +45,7 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 
   void PairCopy(void *dest, void *src, int pair_num = 1);
 
-  page_id_t Lookup(const GenericKey *key, const KeyManager &KP);
+  page_id_t Lookup(const GenericKey *key, const KeyComparator &comparator);
 
   void PopulateNewRoot(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value);
 
@@ -64,15 +66,19 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, GenericKey *middle_key,
                          BufferPoolManager *buffer_pool_manager);
 
+  // Append a child after the last one and adopt it, used by bulk loads which add the children in order
+  void CopyLastFrom(GenericKey *key, page_id_t value, BufferPoolManager *buffer_pool_manager);
+
  private:
-  void CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager);
+  /** @return width of a key, a constant unless the tree is sized at run time */
+  inline int GetKeyWidth() const { return KeySize != 0 ? KeySize : GetKeySize(); }
 
-  void CopyLastFrom(GenericKey *key, page_id_t value, BufferPoolManager *buffer_pool_manager);
+  void CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager);
 
   void CopyFirstFrom(page_id_t value, BufferPoolManager *buffer_pool_manager);
 
   char data_[PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE];
 };
 
-using InternalPage = BPlusTreeInternalPage;
+using InternalPage = BPlusTreeInternalPage<>;
 #endif  // MINISQL_B_PLUS_TREE_INTERNAL_PAGE_H
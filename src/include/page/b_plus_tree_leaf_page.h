@@ -24,12 +24,14 @@
 #include <utility>
 #include <vector>
 
+#include "index/comparator.h"
 #include "index/generic_key.h"
 #include "page/b_plus_tree_page.h"
 
 #define LEAF_PAGE_HEADER_SIZE 32
 #define LEAF_PAGE_SIZE (((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType)) - 1)
 
+template <int KeySize = 0, typename KeyComparator = GenericComparator<KeySize>>
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
@@ -50,7 +52,7 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   void SetValueAt(int index, RowId value);
 
-  int KeyIndex(const GenericKey *key, const KeyManager &comparator);
+  int KeyIndex(const GenericKey *key, const KeyComparator &comparator);
 
   void *PairPtrAt(int index);
 
@@ -59,11 +61,11 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   std::pair<GenericKey *, RowId> GetItem(int index);
 
   // insert and delete methods
-  int Insert(GenericKey *key, const RowId &value, const KeyManager &comparator);
+  int Insert(GenericKey *key, const RowId &value, const KeyComparator &comparator);
 
-  bool Lookup(const GenericKey *key, RowId &value, const KeyManager &comparator);
+  bool Lookup(const GenericKey *key, RowId &value, const KeyComparator &comparator);
 
-  int RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &comparator);
+  int RemoveAndDeleteRecord(const GenericKey *key, const KeyComparator &comparator);
 
   // Split and Merge utility methods
   void MoveHalfTo(BPlusTreeLeafPage *recipient);
@@ -74,10 +76,17 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
+  // Append a pair after the last one, used by bulk loads which add the keys in order
+  void CopyLastFrom(GenericKey *key, const RowId value);
+
+  // Byte offset of NextPageId, read by scans following the leaf chain without a pin
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = sizeof(BPlusTreePage);
+
  private:
-  void CopyNFrom(void *src, int size);
+  /** @return width of a key, a constant unless the tree is sized at run time */
+  inline int GetKeyWidth() const { return KeySize != 0 ? KeySize : GetKeySize(); }
 
-  void CopyLastFrom(GenericKey *key, const RowId value);
+  void CopyNFrom(void *src, int size);
 
   void CopyFirstFrom(GenericKey *key, const RowId value);
 
@@ -86,5 +95,5 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   char data_[PAGE_SIZE - LEAF_PAGE_HEADER_SIZE];
 };
 
-using LeafPage = BPlusTreeLeafPage;
+using LeafPage = BPlusTreeLeafPage<>;
 #endif  // MINISQL_B_PLUS_TREE_LEAF_PAGE_H
@@ -12,6 +12,12 @@
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
 
 #define UNDEFINED_SIZE 64
+
+/**
+ * Template arguments of the leaf page, internal page and tree classes: the width of a key in bytes, 0 if it is only
+ * known at run time, and the comparator of the keys (see index/comparator.h).
+ */
+#define INDEX_TEMPLATE_ARGUMENTS template <int KeySize, typename KeyComparator>
 /**
  * Both internal and leaf page are inherited from this page.
  *
@@ -29,6 +35,8 @@ class BPlusTreePage {
  public:
   bool IsLeafPage() const;
 
+  bool IsInternalPage() const;
+
   bool IsRootPage() const;
 
   void SetPageType(IndexPageType page_type);
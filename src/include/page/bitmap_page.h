@@ -25,16 +25,38 @@ class BitmapPage {
      */
     bool AllocatePage(uint32_t &page_offset);
 
+    /**
+     * Allocate the first free page in [begin, end).
+     * @return true if a page of the range was free
+     */
+    bool AllocatePageInRange(uint32_t begin, uint32_t end, uint32_t &page_offset);
+
     /**
      * @return true if successfully de-allocate a page.
      */
     bool DeAllocatePage(uint32_t page_offset);
 
+    /**
+     * @return a lower bound of the free pages, every page before it is allocated
+     */
+    inline uint32_t GetNextFreePage() const { return next_free_page_; }
+
     /**
      * @return whether a page in the extent is free
      */
     bool IsPageFree(uint32_t page_offset) const;
 
+    /**
+     * @return whether every page in [begin, end) is free
+     */
+    bool IsRangeFree(uint32_t begin, uint32_t end) const;
+
+    /**
+     * @param page_offset Index in extent of the last allocated page.
+     * @return false if no page of the extent is allocated.
+     */
+    bool GetLastAllocatedPage(uint32_t &page_offset) const;
+
    private:
     /**
      * check a bit(byte_index, bit_index) in bytes is free(value 0).
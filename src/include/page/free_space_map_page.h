@@ -0,0 +1,63 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+#include <utility>
+
+#include "common/config.h"
+
+/**
+ * One page of a table heap's free space map, the pages of a map are chained through NextPageId.
+ * LastHeapPageId is only used in the first page of the map, it caches the tail of the heap's page chain.
+ *
+ * Format (size in byte):
+ *  ---------------------------------------------------------------------------------------------------------
+ * | NextPageId (4) | LastHeapPageId (4) | Count (4) | HeapPageId_1 (4) | FreeSpace_1 (4) | ... |
+ *  ---------------------------------------------------------------------------------------------------------
+ */
+class FreeSpaceMapPage {
+ public:
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    last_heap_page_id_ = INVALID_PAGE_ID;
+    count_ = 0;
+  }
+
+  inline page_id_t GetNextPageId() const { return next_page_id_; }
+
+  inline void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  inline page_id_t GetLastHeapPageId() const { return last_heap_page_id_; }
+
+  inline void SetLastHeapPageId(page_id_t last_heap_page_id) { last_heap_page_id_ = last_heap_page_id; }
+
+  inline uint32_t GetCount() const { return count_; }
+
+  inline bool IsFull() const { return count_ >= MAX_ENTRY_COUNT; }
+
+  /**
+   * Add an entry for a heap page.
+   * @return slot of the entry
+   */
+  inline uint32_t Append(page_id_t heap_page_id, uint32_t free_space) {
+    entries_[count_] = {heap_page_id, free_space};
+    return count_++;
+  }
+
+  inline page_id_t GetHeapPageId(uint32_t slot) const { return entries_[slot].first; }
+
+  inline void SetHeapPageId(uint32_t slot, page_id_t heap_page_id) { entries_[slot].first = heap_page_id; }
+
+  inline uint32_t GetFreeSpace(uint32_t slot) const { return entries_[slot].second; }
+
+  inline void SetFreeSpace(uint32_t slot, uint32_t free_space) { entries_[slot].second = free_space; }
+
+  static constexpr uint32_t MAX_ENTRY_COUNT = (PAGE_SIZE - 12) / 8;
+
+ private:
+  page_id_t next_page_id_;
+  page_id_t last_heap_page_id_;
+  uint32_t count_;
+  std::pair<page_id_t, uint32_t> entries_[0];
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
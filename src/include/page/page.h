@@ -1,8 +1,10 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <shared_mutex>
 
 #include "common/config.h"
@@ -20,8 +22,11 @@ class Page {
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a standalone page owning its memory. Zeros out the page data. */
+  Page() : owned_data_(new char[PAGE_SIZE]), data_(owned_data_.get()) { ResetMemory(); }
+
+  /** Constructor of a buffer pool frame, the zeroed memory is owned by the buffer pool. */
+  explicit Page(char *data) : data_(data) {}
 
   /** Default destructor. */
   ~Page() = default;
@@ -38,18 +43,40 @@ class Page {
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline bool IsDirty() { return is_dirty_; }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  /** Acquire the page write latch, the version is odd until it is released. */
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
+  /** Acquire the page read latch if it is free of writers, never blocks. @return whether the latch was acquired */
+  inline bool TryRLatch() { return rwlatch_.TryRLock(); }
+
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read of the page, without latching it.
+   * @return the version of the page, odd if a writer holds the write latch
+   */
+  inline uint64_t GetVersion() const { return version_.load(std::memory_order_acquire); }
+
+  /** @return whether no writer latched the page since GetVersion returned `version`, so what was read is valid */
+  inline bool ValidateVersion(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -68,16 +95,24 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** Memory of a standalone page. */
+  std::unique_ptr<char[]> owned_data_;
+  /** The actual data that is stored within a page, one PAGE_SIZE aligned frame of the buffer pool's slab. */
+  char *data_{nullptr};
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
   int pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
+  /** True while a read-ahead thread reads the page into the frame, the frame is mapped but not usable yet. */
+  bool io_pending_ = false;
+  /** True while the frame is written back without the instance latch, the frame is not recycled until it is done. */
+  bool writeback_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Number of times the write latch was acquired and released. */
+  std::atomic<uint64_t> version_{0};
 };
 
 #endif  // MINISQL_PAGE_H
@@ -23,6 +23,7 @@
 #include "common/rowid.h"
 #include "page/page.h"
 #include "record/row.h"
+#include "record/row_view.h"
 #include "transaction/lock_manager.h"
 #include "transaction/log_manager.h"
 #include "transaction/transaction.h"
@@ -56,12 +57,32 @@ class TablePage : public Page {
 
   void RollbackDelete(const RowId &rid, Transaction *txn, LogManager *log_manager);
 
-  bool GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager);
+  bool GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager, Arena *arena = nullptr);
+
+  /**
+   * Point `view` at the bytes of tuple `rid` in this page instead of deserializing it.
+   * @return false if the slot holds no live tuple
+   */
+  bool GetTupleView(const RowId &rid, const Schema *schema, RowView *view);
 
   bool GetFirstTupleRid(RowId *first_rid);
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+  /**
+   * Drop deleted tuples and pack the data of the live ones at the end of the page. Every tuple keeps its slot, so its
+   * rid stays valid; the slots of dropped tuples are left empty for inserts to reuse.
+   */
+  void Compact();
+
+  /** @return bytes left for new tuples and their slots */
+  uint32_t GetFreeSpaceRemaining() {
+    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  }
+
+  /** @return bytes taken by tuples and their slots */
+  uint32_t GetUsedSpace() { return PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - GetFreeSpaceRemaining(); }
+
  private:
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
@@ -73,10 +94,6 @@ class TablePage : public Page {
 
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  uint32_t GetFreeSpaceRemaining() {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
   }
@@ -103,15 +120,15 @@ class TablePage : public Page {
   static_assert(sizeof(page_id_t) == 4);
   static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
   static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
-  static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
-  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
   static constexpr size_t OFFSET_TUPLE_COUNT = 20;
   static constexpr size_t OFFSET_TUPLE_OFFSET = 24;
   static constexpr size_t OFFSET_TUPLE_SIZE = 28;
 
  public:
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;  // read by scans following the chain without a pin
+  static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
 };
 
@@ -1,5 +1,6 @@
 %{
   #include <stdio.h>
+  #include <string.h>
   #include "parser/parser.h"
 
   extern char *yytext;
@@ -27,7 +28,7 @@
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
 %type <syntax_node> sql_insert sql_delete sql_update update_values update_value
-%type <syntax_node> sql_quit sql_exec_file
+%type <syntax_node> sql_quit sql_exec_file sql_table_command
 
 %%
 
@@ -58,6 +59,7 @@ sql:
   | sql_trx_rollback { $$ = $1; }
   | sql_quit { $$ = $1; }
   | sql_exec_file { $$ = $1; }
+  | sql_table_command { $$ = $1; }
   ;
 
 sql_create_database:
@@ -393,6 +395,21 @@ sql_exec_file:
   }
   ;
 
+/* vacuum and analyze are not reserved words, so they are matched as identifiers */
+sql_table_command:
+  IDENTIFIER IDENTIFIER {
+    if (strcmp($1->val_, "vacuum") == 0) {
+      $$ = CreateSyntaxNode(kNodeVacuum, NULL);
+    } else if (strcmp($1->val_, "analyze") == 0) {
+      $$ = CreateSyntaxNode(kNodeAnalyze, NULL);
+    } else {
+      yyerror("syntax error");
+      YYERROR;
+    }
+    SyntaxNodeAddChildren($$, $2);
+  }
+  ;
+
 %%
 int yyerror(char* error) {
 	MinisqlParserSetError(error);
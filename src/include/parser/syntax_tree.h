@@ -43,7 +43,9 @@ typedef enum {
   kNodeIndexType,            /** type of index */
   kNodeTrxBegin,             /** begin transaction command */
   kNodeTrxCommit,            /** commit transaction command */
-  kNodeTrxRollback           /** rollback transaction command */
+  kNodeTrxRollback,          /** rollback transaction command */
+  kNodeVacuum,               /** vacuum table command */
+  kNodeAnalyze               /** analyze table command */
 } SyntaxNodeType;
 
 /**
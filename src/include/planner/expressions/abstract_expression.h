@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "record/row.h"
+#include "record/row_view.h"
 #include "record/schema.h"
 
 class AbstractExpression;
@@ -33,9 +34,15 @@ class AbstractExpression {
   /** Virtual destructor. */
   virtual ~AbstractExpression() = default;
 
-  /** @return The field obtained by evaluating the row */
+  /** @return The field obtained by evaluating the row, it may share data with the row or the expression */
   virtual Field Evaluate(const Row *row) const = 0;
 
+  /**
+   * Evaluate on a tuple in place, so rows that are filtered out are never deserialized.
+   * @return The field obtained by evaluating the tuple, it may refer to the tuple bytes
+   */
+  virtual Field EvaluateView(const RowView &view) const = 0;
+
   /**
    * Returns the field obtained by evaluating a JOIN.
    * @param left_row The left row
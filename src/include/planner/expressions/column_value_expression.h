@@ -25,10 +25,12 @@ class ColumnValueExpression : public AbstractExpression {
   ColumnValueExpression(uint32_t row_idx, uint32_t col_idx, TypeId ret_type)
       : AbstractExpression({}, ret_type, ExpressionType::ColumnExpression), row_idx_{row_idx}, col_idx_{col_idx} {}
 
-  Field Evaluate(const Row *row) const override { return Field(*row->GetField(col_idx_)); }
+  Field Evaluate(const Row *row) const override { return row->GetField(col_idx_)->Borrow(); }
+
+  Field EvaluateView(const RowView &view) const override { return view.GetField(col_idx_); }
 
   Field EvaluateJoin(const Row *left_row, const Row *right_row) const override {
-    return row_idx_ == 0 ? Field(*left_row->GetField(col_idx_)) : Field(*right_row->GetField(col_idx_));
+    return row_idx_ == 0 ? left_row->GetField(col_idx_)->Borrow() : right_row->GetField(col_idx_)->Borrow();
   }
 
   uint32_t GetRowIdx() const { return row_idx_; }
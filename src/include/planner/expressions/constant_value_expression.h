@@ -16,9 +16,11 @@ class ConstantValueExpression : public AbstractExpression {
   explicit ConstantValueExpression(const Field &val)
       : AbstractExpression({}, val.GetTypeId(), ExpressionType::ConstantExpression), val_(val) {}
 
-  Field Evaluate(const Row *row) const override { return Field(val_); }
+  Field Evaluate(const Row *row) const override { return val_.Borrow(); }
 
-  Field EvaluateJoin(const Row *left_row, const Row *right_row) const override { return Field(val_); }
+  Field EvaluateView([[maybe_unused]] const RowView &view) const override { return val_.Borrow(); }
+
+  Field EvaluateJoin(const Row *left_row, const Row *right_row) const override { return val_.Borrow(); }
 
   const Field val_;
 };
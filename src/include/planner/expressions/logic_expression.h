@@ -31,6 +31,12 @@ class LogicExpression : public AbstractExpression {
     return Field(kTypeInt, PerformComputation(lhs, rhs));
   }
 
+  Field EvaluateView(const RowView &view) const override {
+    Field lhs = GetChildAt(0)->EvaluateView(view);
+    Field rhs = GetChildAt(1)->EvaluateView(view);
+    return Field(kTypeInt, PerformComputation(lhs, rhs));
+  }
+
   Field EvaluateJoin(const Row *left_row, const Row *right_row) const override {
     Field lhs = GetChildAt(0)->EvaluateJoin(left_row, right_row);
     Field rhs = GetChildAt(1)->EvaluateJoin(left_row, right_row);
@@ -9,6 +9,10 @@
 #include "record/type_id.h"
 #include "record/types.h"
 
+/**
+ * A typed value. A CHAR field either borrows its data or owns a copy, an owned copy of at most FIELD_INLINE_LEN bytes
+ * is kept inside the field instead of on the heap.
+ */
 class Field {
   friend class Type;
 
@@ -22,7 +26,7 @@ class Field {
   explicit Field(const TypeId type) : type_id_(type), len_(FIELD_NULL_LEN), is_null_(true) {}
 
   ~Field() {
-    if (type_id_ == TypeId::kTypeChar && manage_data_) {
+    if (OwnsHeapData()) {
       delete[] value_.chars_;
     }
   }
@@ -52,8 +56,12 @@ class Field {
     } else {
       if (manage_data) {
         ASSERT(len < VARCHAR_MAX_LEN, "Field length exceeds max varchar length");
-        value_.chars_ = new char[len];
-        memcpy(value_.chars_, data, len);
+        if (len <= FIELD_INLINE_LEN) {
+          memcpy(value_.inline_chars_, data, len);
+        } else {
+          value_.chars_ = new char[len];
+          memcpy(value_.chars_, data, len);
+        }
       } else {
         value_.chars_ = data;
       }
@@ -67,7 +75,7 @@ class Field {
     len_ = other.len_;
     is_null_ = other.is_null_;
     manage_data_ = other.manage_data_;
-    if (type_id_ == TypeId::kTypeChar && !is_null_ && manage_data_) {
+    if (other.OwnsHeapData()) {
       value_.chars_ = new char[len_];
       memcpy(value_.chars_, other.value_.chars_, len_);
     } else {
@@ -75,12 +83,48 @@ class Field {
     }
   }
 
-  // copy
-  Field &operator=(Field &other) {
+  // move constructor, the moved field becomes null
+  Field(Field &&other) noexcept
+      : value_(other.value_),
+        type_id_(other.type_id_),
+        len_(other.len_),
+        is_null_(other.is_null_),
+        manage_data_(other.manage_data_) {
+    other.len_ = FIELD_NULL_LEN;
+    other.is_null_ = true;
+    other.manage_data_ = false;
+  }
+
+  Field &operator=(const Field &other) {
+    Field copy(other);
+    Swap(*this, copy);
+    return *this;
+  }
+
+  Field &operator=(Field &&other) noexcept {
     Swap(*this, other);
     return *this;
   }
 
+  /**
+   * @return a field with the value of this one that shares its CHAR data instead of copying it, so it must not
+   * outlive this field
+   */
+  Field Borrow() const {
+    if (type_id_ == TypeId::kTypeChar && !is_null_) {
+      return Field(type_id_, const_cast<char *>(GetChars()), len_, false);
+    }
+    return Field(*this);
+  }
+
+  /** @return a copy of this field that owns its CHAR data, even if this field borrows it */
+  Field DeepCopy() const {
+    if (type_id_ == TypeId::kTypeChar && !is_null_) {
+      return Field(type_id_, const_cast<char *>(GetChars()), len_, true);
+    }
+    return Field(*this);
+  }
+
   inline bool IsNull() const { return is_null_; }
 
   inline uint32_t GetLength() const { return Type::GetInstance(type_id_)->GetLength(*this); }
@@ -138,17 +182,27 @@ class Field {
       return std::to_string(value_.float_);
     else {
       char temp[len_ + 1];
-      memcpy(temp, value_.chars_, len_);
+      memcpy(temp, GetChars(), len_);
       temp[len_] = '\0';
       return {temp};
     }
   }
 
  protected:
+  /** @return whether the CHAR data is owned and too long to be inline */
+  inline bool OwnsHeapData() const {
+    return type_id_ == TypeId::kTypeChar && manage_data_ && !is_null_ && len_ > FIELD_INLINE_LEN;
+  }
+
+  inline const char *GetChars() const {
+    return manage_data_ && len_ <= FIELD_INLINE_LEN ? value_.inline_chars_ : value_.chars_;
+  }
+
   union Val {
     int32_t integer_;
     float float_;
     char *chars_;
+    char inline_chars_[FIELD_INLINE_LEN];
   } value_;
   TypeId type_id_;
   uint32_t len_;
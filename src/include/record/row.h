@@ -4,46 +4,47 @@
 #include <memory>
 #include <vector>
 
+#include "common/arena.h"
 #include "common/macros.h"
+#include "common/small_vector.h"
 #include "common/rowid.h"
 #include "record/field.h"
 #include "record/schema.h"
 
 /**
  *  Row format:
- * -------------------------------------------
- * | Header | Field-1 | ... | Field-N |
- * -------------------------------------------
- *  Header format:
- * --------------------------------------------
- * | Field Nums | Null bitmap |
- * -------------------------------------------
- *
+ * -------------------------------------------------------------------------------------------------------
+ * | Field Nums | Null bitmap | Fixed-width fields | CHAR start offsets | CHAR end offset | CHAR data |
+ * -------------------------------------------------------------------------------------------------------
+ *  Field Nums carries FIXED_OFFSET_FORMAT. INT and FLOAT fields keep their slot even when null, and the start of
+ *  every CHAR field (from the start of the row) is in the offset array, so the Schema can precompute where each
+ *  field is and any of them is read in O(1). Offsets and the end offset are only present if there are CHAR fields.
  *
+ *  Rows written before the fixed offset format are still read:
+ * ------------------------------------------------------------------------------------
+ * | Field Nums | Null bitmap size | Null bitmap | Non-null fields (CHAR is | Len | Data |) |
+ * ------------------------------------------------------------------------------------
  */
 class Row {
  public:
+  /** Fields are held by value, the first ROW_INLINE_FIELDS inside the row */
+  using FieldList = SmallVector<Field, ROW_INLINE_FIELDS>;
+
   /**
    * Row used for insert
    * Field integrity should check by upper level
    */
   Row(std::vector<Field> &fields) {
-    // deep copy
+    // copies the fields, CHAR data they borrow stays shared
+    fields_.reserve(fields.size());
     for (auto &field : fields) {
-      fields_.push_back(new Field(field));
+      fields_.emplace_back(field);
     }
   }
 
-  void destroy() {
-    if (!fields_.empty()) {
-      for (auto field : fields_) {
-        delete field;
-      }
-      fields_.clear();
-    }
-  }
+  void destroy() { fields_.clear(); }
 
-  ~Row() { destroy(); };
+  ~Row() = default;
 
   /**
    * Row used for deserialize
@@ -56,26 +57,28 @@ class Row {
   Row(RowId rid) : rid_(rid) {}
 
   /**
-   * Row copy function, deep copy
+   * Row copy function, fields owning their CHAR data are copied with it, borrowed data stays shared with `other`.
+   * Use DeepCopy for a row that owns all of its data.
    */
-  Row(const Row &other) {
-    destroy();
-    rid_ = other.rid_;
-    for (auto &field : other.fields_) {
-      fields_.push_back(new Field(*field));
-    }
-  }
+  Row(const Row &other) = default;
+
+  Row(Row &&other) noexcept = default;
 
   /**
-   * Assign operator, deep copy
+   * Assign operator, copies like the copy constructor, borrowed data stays shared
    */
-  Row &operator=(const Row &other) {
-    destroy();
-    rid_ = other.rid_;
-    for (auto &field : other.fields_) {
-      fields_.push_back(new Field(*field));
+  Row &operator=(const Row &other) = default;
+
+  Row &operator=(Row &&other) noexcept = default;
+
+  /** @return a copy of this row whose fields all own their CHAR data, even the ones this row borrows */
+  Row DeepCopy() const {
+    Row copy(rid_);
+    copy.fields_.reserve(fields_.size());
+    for (auto &field : fields_) {
+      copy.fields_.emplace_back(field.DeepCopy());
     }
-    return *this;
+    return copy;
   }
 
   /**
@@ -83,7 +86,10 @@ class Row {
    */
   uint32_t SerializeTo(char *buf, Schema *schema) const;
 
-  uint32_t DeserializeFrom(char *buf, Schema *schema);
+  /**
+   * @param arena if given, CHAR values too long to be inline are copied there and the fields do not own them
+   */
+  uint32_t DeserializeFrom(char *buf, Schema *schema, Arena *arena = nullptr);
 
   /**
    * For empty row, return 0
@@ -98,18 +104,21 @@ class Row {
 
   inline void SetRowId(RowId rid) { rid_ = rid; }
 
-  inline std::vector<Field *> &GetFields() { return fields_; }
+  inline FieldList &GetFields() { return fields_; }
 
   inline Field *GetField(uint32_t idx) const {
     ASSERT(idx < fields_.size(), "Failed to access field");
-    return fields_[idx];
+    return const_cast<Field *>(&fields_[idx]);
   }
 
   inline size_t GetFieldCount() const { return fields_.size(); }
 
+  /** Flag of Field Nums telling a fixed offset row from one in the legacy format */
+  static constexpr uint32_t FIXED_OFFSET_FORMAT = 0x80000000;
+
  private:
   RowId rid_{};
-  std::vector<Field *> fields_; /** Make sure that all field ptr are destructed*/
+  FieldList fields_;
 };
 
 #endif  // MINISQL_ROW_H
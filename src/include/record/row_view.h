@@ -0,0 +1,78 @@
+#ifndef MINISQL_ROW_VIEW_H
+#define MINISQL_ROW_VIEW_H
+
+#include <vector>
+
+#include "common/macros.h"
+#include "record/field.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+/**
+ * RowView reads the fields of a serialized row (see Row for the format) in place, without deserializing the row.
+ *
+ * Fields returned by a view do not own their data, a CHAR field points straight into the tuple bytes, so looking at
+ * and comparing fields allocates nothing. Fields of a fixed offset row are found in O(1) through the layout cached in
+ * the Schema, rows in the legacy format are walked field by field.
+ *
+ * A view is only valid while the page holding the tuple stays pinned and the tuple is not moved; Materialize copies
+ * the fields out when a row has to outlive it.
+ */
+class RowView {
+ public:
+  RowView() = default;
+
+  RowView(const char *data, const Schema *schema)
+      : data_(data),
+        schema_(schema),
+        fixed_offset_(schema->GetColumnCount() > 0 && (MACH_READ_UINT32(data) & Row::FIXED_OFFSET_FORMAT)) {}
+
+  inline bool IsValid() const { return data_ != nullptr; }
+
+  inline uint32_t GetFieldCount() const { return schema_->GetColumnCount(); }
+
+  bool IsNull(uint32_t idx) const;
+
+  /**
+   * @return the field at `idx`, a CHAR field refers to the tuple bytes and must not outlive the view
+   */
+  Field GetField(uint32_t idx) const;
+
+  /** @return size of the serialized row */
+  uint32_t GetSerializedSize() const;
+
+  /**
+   * Deep copy every field of the tuple into `row`, replacing its fields, the row id is kept.
+   * CHAR values too long to be inline go to `arena` if there is one, or to the heap.
+   */
+  void Materialize(Row *row, Arena *arena = nullptr) const;
+
+  /**
+   * Deep copy the fields at `columns` into `row` in that order, used to emit projected rows.
+   */
+  void Materialize(const std::vector<uint32_t> &columns, Row *row, Arena *arena = nullptr) const;
+
+ private:
+  /**
+   * @return start of the value of the non-null field at `idx`
+   * @param[out] len length of a CHAR value
+   */
+  const char *GetFieldData(uint32_t idx, uint32_t *len) const;
+
+  /** @return start of field `idx` of a legacy row, or the end of the row if `idx` is the field count */
+  const char *GetLegacyFieldData(uint32_t idx) const;
+
+  /** Append a copy of field `idx` to `fields` */
+  void AppendField(uint32_t idx, Row::FieldList *fields, Arena *arena) const;
+
+  /** Append a copy of a CHAR value to `fields` */
+  static void AppendChars(const char *data, uint32_t len, Row::FieldList *fields, Arena *arena);
+
+  inline const char *GetNullBitmap() const { return data_ + (fixed_offset_ ? 1 : 2) * sizeof(uint32_t); }
+
+  const char *data_{nullptr};
+  const Schema *schema_{nullptr};
+  bool fixed_offset_{false};  // false for rows in the legacy format
+};
+
+#endif  // MINISQL_ROW_VIEW_H
@@ -13,7 +13,9 @@
 class Schema {
  public:
   explicit Schema(const std::vector<Column *> columns, bool is_manage_ = true)
-      : columns_(std::move(columns)), is_manage_(is_manage_) {}
+      : columns_(std::move(columns)), is_manage_(is_manage_) {
+    ComputeLayout();
+  }
 
   ~Schema() {
     if (is_manage_) {
@@ -39,6 +41,21 @@ class Schema {
 
   inline uint32_t GetColumnCount() const { return static_cast<uint32_t>(columns_.size()); }
 
+  /** @return size of the null bitmap of a row */
+  inline uint32_t GetNullBitmapSize() const { return null_bitmap_size_; }
+
+  /**
+   * @return where a column is found in a serialized row: the value of an INT or FLOAT column, the entry holding the
+   * start offset of a CHAR column's data
+   */
+  inline uint32_t GetFieldOffset(uint32_t column_index) const { return field_offsets_[column_index]; }
+
+  /** @return number of CHAR columns */
+  inline uint32_t GetVariableFieldCount() const { return variable_field_count_; }
+
+  /** @return where the data of the CHAR columns starts in a serialized row, the end of the row if there are none */
+  inline uint32_t GetVariableDataOffset() const { return variable_data_offset_; }
+
   /**
    * Shallow copy schema, only used in index
    *
@@ -81,9 +98,19 @@ class Schema {
   static uint32_t DeserializeFrom(char *buf, Schema *&schema);
 
  private:
+  /**
+   * Compute the row layout of the columns, see Row for the format.
+   */
+  void ComputeLayout();
+
   static constexpr uint32_t SCHEMA_MAGIC_NUM = 200715;
   std::vector<Column *> columns_;
   bool is_manage_ = false; /** if false, don't need to delete pointer to column */
+  // row layout, cached as the columns never change
+  uint32_t null_bitmap_size_{0};
+  std::vector<uint32_t> field_offsets_;
+  uint32_t variable_field_count_{0};
+  uint32_t variable_data_offset_{0};
 };
 
 using IndexSchema = Schema;
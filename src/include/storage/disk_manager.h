@@ -2,15 +2,18 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/io_uring.h"
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
@@ -19,10 +22,35 @@
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * Pages are read and written with positional I/O (pread/pwrite) on a raw file descriptor, so concurrent readers and
+ * writers don't share a seek cursor and need no lock. Only the meta page and the bitmaps are protected by a latch.
+ *
+ * The meta page and the free page bitmaps are cached in memory, so allocating or freeing a page is a bit operation
+ * without any I/O. Changed bitmaps and the meta page are written back by FlushMetadata, which the buffer pool calls
+ * when it flushes all pages, and on Close.
+ *
+ * FlushMetadata also gives the space of freed pages back to the file system: the file is truncated after the last
+ * allocated page, dropping the empty extents at its end, and every fully free range of PAGE_RESERVATION_SIZE pages
+ * inside the file is turned into a hole with fallocate(FALLOC_FL_PUNCH_HOLE). A hole reads back as zeros.
+ *
+ * ReadPageAsync/WritePageAsync go through io_uring when it is enabled and supported by the kernel, so a batch of
+ * page I/Os is submitted with a single system call; otherwise they fall back to a synchronous pread/pwrite and return
+ * an already completed handle.
+ *
+ * The pages of an extent are grouped into reservations of PAGE_RESERVATION_SIZE contiguous pages. An allocation with a
+ * hint (a page of the same table heap or index) is served from the hint's reservation, or else reserves a whole new
+ * range, so the pages of one owner stay contiguous in the file instead of interleaving with everybody else's. Plain
+ * allocations never take pages of a reserved range. Reservations only live in memory, after a restart an owner simply
+ * starts a new one.
+ *
+ * In direct I/O mode the file is opened with O_DIRECT, so pages are cached only once, by the buffer pool. Page buffers
+ * should then be PAGE_SIZE aligned (buffer pool frames are), unaligned buffers are copied through a bounce buffer.
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool use_io_uring = DEFAULT_USE_IO_URING,
+                       bool direct_io = DEFAULT_DIRECT_IO);
 
   ~DiskManager() {
     if (!closed) {
@@ -42,11 +70,39 @@ class DiskManager {
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Queue an asynchronous read of a page, `page_data` must stay valid until the handle completes.
+   * The read is handed to the kernel by the next SubmitAsync, or when the handle is waited on.
+   */
+  IOHandle ReadPageAsync(page_id_t logical_page_id, char *page_data);
+
+  /**
+   * Queue an asynchronous write of a page, `page_data` must stay valid and unchanged until the handle completes.
+   */
+  IOHandle WritePageAsync(page_id_t logical_page_id, const char *page_data);
+
+  /**
+   * Hand all queued asynchronous requests to the kernel.
+   */
+  void SubmitAsync();
+
+  /** @return whether asynchronous requests really go through io_uring */
+  inline bool IsAsyncIOEnabled() const { return io_uring_ != nullptr; }
+
+  /** @return whether the file is really opened with O_DIRECT */
+  inline bool IsDirectIO() const { return direct_io_; }
+
+  /**
+   * Turn page reservations on or off, without them hints are ignored and every page is the first free one.
+   */
+  void SetPageReservation(bool enable);
+
   /**
    * Get next free page from disk
+   * @param hint a page of the same owner, the new page is placed after it in the owner's reservation
    * @return logical page id of allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(page_id_t hint = INVALID_PAGE_ID);
 
   /**
    * Free this page and reset bit map
@@ -58,6 +114,11 @@ class DiskManager {
    */
   bool IsPageFree(page_id_t logical_page_id);
 
+  /**
+   * Write the changed bitmaps and the meta page back to the file.
+   */
+  void FlushMetadata();
+
   /**
    * Shut down the disk manager and close all the file resources.
    */
@@ -75,7 +136,7 @@ class DiskManager {
   /**
    * Helper function to get disk file size
    */
-  int GetFileSize(const std::string &file_name);
+  size_t GetFileSize(const std::string &file_name);
 
   /**
    * Read physical page from disk
@@ -92,14 +153,59 @@ class DiskManager {
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
+  /**
+   * Record that the file now extends at least to `end`
+   */
+  void GrowFileSize(size_t end);
+
+  /**
+   * Allocate the first free page in [begin, end) of an extent, the extent is created if it is the next one.
+   * @param skip_reserved leave out the pages of reserved ranges
+   * @return logical page id of allocated page, INVALID_PAGE_ID if the range is full
+   */
+  page_id_t AllocatePageInExtent(uint32_t extent_id, uint32_t begin, uint32_t end, bool skip_reserved);
+
+  /**
+   * Reserve a range with no allocated page, `preferred` if it is free.
+   * @return the reserved range, INVALID_PAGE_ID if the file is full
+   */
+  page_id_t ReserveRange(page_id_t preferred);
+
+  /**
+   * Truncate the file after the last allocated page and punch holes in the freed ranges inside it.
+   */
+  void ReleaseFreeSpace();
+
+  /**
+   * @return the cached bitmap of an extent, read from the file on first use
+   */
+  BitmapPage<PAGE_SIZE> *GetBitmap(uint32_t extent_id);
+
  private:
-  // stream to write db file
-  std::fstream db_io_;
+  // file descriptor of the db file
+  int db_fd_{-1};
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  // file length, cached so reads need no stat(), only shrinks in ReleaseFreeSpace
+  std::atomic<size_t> file_size_{0};
+  // with multiple buffer pool instances, need to protect the meta page and bitmaps
   std::recursive_mutex db_io_latch_;
+  // the file is opened with O_DIRECT
+  bool direct_io_{false};
+  // ranges of PAGE_RESERVATION_SIZE pages reserved by a table heap or index, protected by db_io_latch_
+  std::unordered_set<page_id_t> reserved_ranges_;
+  bool reserve_pages_{true};
+  // asynchronous I/O backend, nullptr when io_uring is disabled or not supported
+  std::unique_ptr<IOUring> io_uring_;
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  // cached free page bitmaps indexed by extent, and whether they differ from the file, protected by db_io_latch_
+  std::vector<std::unique_ptr<BitmapPage<PAGE_SIZE>>> bitmaps_;
+  std::vector<bool> bitmap_dirty_;
+  bool meta_dirty_{false};
+  // ranges of PAGE_RESERVATION_SIZE pages that became free since the last FlushMetadata, protected by db_io_latch_
+  std::unordered_set<page_id_t> free_ranges_;
+  // cleared when the file system does not support hole punching
+  bool punch_holes_{true};
+  alignas(PAGE_SIZE) char meta_data_[PAGE_SIZE];
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef MINISQL_FRAGMENTATION_REPORT_H
+#define MINISQL_FRAGMENTATION_REPORT_H
+
+#include <ostream>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+/**
+ * How scattered the pages of a table heap or index are in the db file, measured in the order a scan reads them.
+ * A run is a maximal sequence of pages that directly follow each other in the file, every new run costs the scan a
+ * seek (or at least breaks read-ahead).
+ */
+struct FragmentationReport {
+  size_t pages_{0};
+  size_t runs_{0};
+  size_t backward_jumps_{0};   // the next page lies before the current one in the file
+  uint64_t jump_distance_{0};  // total distance in pages between the end of a run and the start of the next
+
+  inline double AverageRunLength() const { return runs_ == 0 ? 0 : static_cast<double>(pages_) / runs_; }
+
+  /**
+   * Build the report of pages in scan order.
+   */
+  static FragmentationReport FromPageIds(const std::vector<page_id_t> &page_ids);
+
+  /** @return the pages of a table heap in scan order */
+  static std::vector<page_id_t> TableHeapPageIds(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id);
+
+  /** @return the leaf pages of a B+ tree in key order */
+  static std::vector<page_id_t> LeafPageIds(BufferPoolManager *buffer_pool_manager, page_id_t root_page_id);
+};
+
+std::ostream &operator<<(std::ostream &os, const FragmentationReport &report);
+
+#endif  // MINISQL_FRAGMENTATION_REPORT_H
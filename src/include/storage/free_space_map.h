@@ -0,0 +1,91 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/free_space_map_page.h"
+
+/**
+ * FreeSpaceMap tracks how many bytes are free in each page of a table heap, so an insert can go straight to a page
+ * with enough room instead of trying every page of the heap.
+ *
+ * Pages are bucketed by their free space in memory. The map is persisted in its own chain of FreeSpaceMapPages, an
+ * entry on disk is only rewritten when the page moves to another bucket, so the stored value may be slightly off;
+ * the heap corrects it on the first failed insert.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * Open the map stored at first_page_id, or create an empty one if first_page_id is INVALID_PAGE_ID.
+   */
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id = INVALID_PAGE_ID);
+
+  /** @return id of the first page of the map */
+  inline page_id_t GetFirstPageId() const { return first_page_id_; }
+
+  /**
+   * @return a heap page with at least `size` free bytes, INVALID_PAGE_ID if there is none
+   */
+  page_id_t FindPage(uint32_t size);
+
+  /**
+   * Record the free space of a heap page, adding the page to the map if it is not there yet. A new entry fills the
+   * hole of a removed one before it is appended.
+   */
+  void Update(page_id_t heap_page_id, uint32_t free_space);
+
+  /**
+   * Forget a heap page that was removed from the heap, its slot on disk is left as a hole for the next new page.
+   */
+  void Remove(page_id_t heap_page_id);
+
+  /** @return whether the heap page is in the map, a page removed from the heap is not */
+  bool Contains(page_id_t heap_page_id);
+
+  /** @return the last page of the heap's page chain */
+  page_id_t GetLastHeapPageId();
+
+  void SetLastHeapPageId(page_id_t heap_page_id);
+
+  /** @return number of heap pages in the map */
+  size_t GetPageCount();
+
+  /**
+   * Release the pages of the map.
+   */
+  void Destroy();
+
+  static constexpr uint32_t BUCKET_COUNT = 32;
+  static constexpr uint32_t BUCKET_WIDTH = PAGE_SIZE / BUCKET_COUNT;
+
+ private:
+  /** Where the entry of a heap page lives */
+  struct Entry {
+    uint32_t free_space_;
+    page_id_t map_page_id_;
+    uint32_t slot_;
+  };
+
+  /** @return the bucket holding pages with `free_space` free bytes */
+  static inline uint32_t GetBucket(uint32_t free_space) {
+    return std::min(free_space / BUCKET_WIDTH, BUCKET_COUNT - 1);
+  }
+
+  void WriteEntry(const Entry &entry);
+
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t first_page_id_;
+  page_id_t last_map_page_id_;   // new entries are appended to this page
+  page_id_t last_heap_page_id_;
+  std::unordered_map<page_id_t, Entry> entries_;
+  std::vector<std::set<page_id_t>> buckets_;  // lower page ids first, so inserts fill the front of the heap
+  std::vector<std::pair<page_id_t, uint32_t>> holes_;  // (map page, slot) of the removed entries, found again on load
+  std::mutex latch_;
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
@@ -0,0 +1,107 @@
+#ifndef MINISQL_IO_URING_H
+#define MINISQL_IO_URING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class IOUring;
+
+/**
+ * State shared between an asynchronous page I/O and its handle.
+ */
+struct IOCompletion {
+  std::mutex latch_;
+  std::condition_variable cv_;
+  bool done_{false};
+  int result_{0};  // bytes transferred, or -errno
+  char *buf_{nullptr};
+  unsigned len_{0};
+  bool is_read_{false};
+};
+
+/**
+ * Completion handle of an asynchronous page read or write.
+ * A default constructed handle is already completed and successful.
+ */
+class IOHandle {
+ public:
+  IOHandle() = default;
+
+  IOHandle(std::shared_ptr<IOCompletion> completion, IOUring *ring)
+      : completion_(std::move(completion)), ring_(ring) {}
+
+  /**
+   * Block until the I/O finished, submitting it first if it is still queued.
+   * @return true if the whole page was transferred
+   */
+  bool Wait();
+
+  /** @return whether the I/O finished */
+  bool IsDone();
+
+ private:
+  std::shared_ptr<IOCompletion> completion_;
+  IOUring *ring_{nullptr};
+};
+
+/**
+ * Minimal io_uring wrapper built directly on the io_uring_setup/io_uring_enter system calls.
+ *
+ * Requests are queued with Prepare and handed to the kernel in one system call by Submit (or when the submission
+ * queue is full, or when a handle is waited on), so a batch of page I/Os costs one syscall. A background thread reaps
+ * completions and wakes up the waiters.
+ */
+class IOUring {
+ public:
+  explicit IOUring(unsigned entries);
+
+  ~IOUring();
+
+  /** @return false if the kernel does not support io_uring, the ring must not be used then */
+  inline bool IsValid() const { return ring_fd_ >= 0; }
+
+  /**
+   * Queue a read or write of `len` bytes at `offset` of `fd`.
+   */
+  IOHandle Prepare(bool is_read, int fd, char *buf, unsigned len, uint64_t offset);
+
+  /**
+   * Hand all queued requests to the kernel.
+   */
+  void Submit();
+
+ private:
+  void SubmitLocked();
+
+  void CompletionLoop();
+
+  int ring_fd_{-1};
+  unsigned entries_{0};
+  // submission queue
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *sqes_{nullptr};
+  size_t sqes_size_{0};
+  std::atomic<unsigned> *sq_head_{nullptr};
+  std::atomic<unsigned> *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  // completion queue, shares the mapping of the submission queue
+  std::atomic<unsigned> *cq_head_{nullptr};
+  std::atomic<unsigned> *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  void *cqes_{nullptr};
+
+  std::mutex submit_latch_;           // protects the submission queue
+  std::condition_variable slot_cv_;   // signalled when an in-flight request completes
+  unsigned queued_{0};                // prepared but not yet submitted
+  unsigned in_flight_{0};             // prepared and not yet completed
+  std::atomic<bool> shutdown_{false};
+  std::thread completion_thread_;
+};
+
+#endif  // MINISQL_IO_URING_H
@@ -1,16 +1,34 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
+#include "storage/free_space_map.h"
 #include "storage/table_iterator.h"
+#include "storage/zone_map.h"
 #include "transaction/lock_manager.h"
 #include "transaction/log_manager.h"
 
 #define BEGIN_ITERATOR 0
 #define END_ITERATOR 1
 
+/**
+ * What a vacuum of a table heap did.
+ */
+struct VacuumStats {
+  uint32_t pages_before_{0};
+  uint32_t pages_after_{0};
+  uint32_t rows_moved_{0};
+
+  inline uint32_t PagesReclaimed() const { return pages_before_ - pages_after_; }
+};
+
 class TableHeap {
   friend class TableIterator;
 
@@ -20,23 +38,42 @@ class TableHeap {
     return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
   }
 
+  /**
+   * Open an existing table heap.
+   * @param free_space_map_page_id first page of the heap's free space map, if INVALID_PAGE_ID the map is rebuilt by
+   * walking the heap once and stored in new pages, see GetFreeSpaceMapPageId
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager,
+                           page_id_t free_space_map_page_id = INVALID_PAGE_ID) {
+    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager,
+                         free_space_map_page_id);
   }
 
-  ~TableHeap() {
-    DeleteTable(first_page_id_);
-  }
+  /**
+   * Closing a table heap keeps its pages, call DeleteTable to drop them.
+   */
+  ~TableHeap() = default;
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into the table. If the tuple is larger than TablePage::SIZE_MAX_ROW, return false.
+   * The free space map picks a page with enough room and new pages are linked after the cached last page, so an insert
+   * touches O(1) pages whatever the size of the heap.
    * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
    * @param[in] txn The transaction performing the insert
    * @return true iff the insert is successful
    */
   bool InsertTuple(Row &row, Transaction *txn);
 
+  /**
+   * Insert a batch of tuples. Each target page is pinned and latched once and filled until the next row does not fit;
+   * the rows left over go to a run of new pages that are linked to the heap with a single update of the last page.
+   * @param[in/out] rows Rows to insert, the rid of each inserted tuple is wrapped in its row
+   * @param[in] txn The transaction performing the insert
+   * @return true iff all rows were inserted, nothing is inserted if a row is too large
+   */
+  bool InsertTuples(std::vector<Row> &rows, Transaction *txn);
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param[in] rid Resource id of the tuple of delete
@@ -72,31 +109,43 @@ class TableHeap {
    * Read a tuple from the table.
    * @param[in/out] row Output variable for the tuple, row id of the tuple is wrapped in row
    * @param[in] txn transaction performing the read
+   * @param[in] arena if given, long CHAR values are copied there instead of to the heap
    * @return true if the read was successful (i.e. the tuple exists)
    */
-  bool GetTuple(Row *row, Transaction *txn);
-
-  void FreeTableHeap() {
-    auto next_page_id = first_page_id_;
-    while (next_page_id != INVALID_PAGE_ID) {
-      auto old_page_id = next_page_id;
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
-      assert(page != nullptr);
-      next_page_id = page->GetNextPageId();
-      buffer_pool_manager_->UnpinPage(old_page_id, false);
-      buffer_pool_manager_->DeletePage(old_page_id);
-    }
-  }
+  bool GetTuple(Row *row, Transaction *txn, Arena *arena = nullptr);
+
+  /**
+   * Reclaim the space of deleted tuples. Every page is compacted in place, then tuples from the end of the heap are
+   * moved into the free space of the front pages and the pages emptied this way are cut off the chain and deallocated.
+   * A page still pinned by a scan is deallocated by a later Vacuum or DeleteTable, it is counted in pages_after_ until
+   * then. Tuples marked deleted are dropped, so no transaction may still roll back a delete on this heap. Inserts may
+   * run concurrently, an insert never lands in a page that is being emptied.
+   * @param[out] moved (old rid, new rid) of every tuple moved to another page, the table's indexes must be updated with
+   * it; the tuples that stay in their page keep their rid
+   * @param[in] txn The transaction performing the vacuum
+   */
+  VacuumStats Vacuum(std::vector<std::pair<RowId, RowId>> *moved, Transaction *txn);
+
+  void FreeTableHeap() { DeleteTable(); }
 
   /**
-   * Free table heap and release storage in disk file
+   * Free table heap and release storage in disk file, deleting from the first page also drops the free space map
    */
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
+   * Recompute the zone of every page from the tuples it holds.
+   * @return number of pages of the heap
+   */
+  uint32_t RebuildZoneMap();
+
+  /**
+   * @param ring_size number of frames of the scan's private buffer ring, 0 to read through the main pool
+   * @param read_ahead number of pages read asynchronously ahead of the scan, 0 to disable read-ahead
+   * @param page_filter pages it rejects are skipped, see ZoneMap
    * @return the begin iterator of this table
    */
-  TableIterator Begin(Transaction *txn);
+  TableIterator Begin(Transaction *txn, size_t ring_size = 0, size_t read_ahead = 0, PageFilter page_filter = nullptr);
 
   /**
    * @return the end iterator of this table
@@ -108,6 +157,16 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return the id of the first page of the free space map, to be stored with the table metadata
+   */
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_->GetFirstPageId(); }
+
+  /**
+   * @return the per page min/max summaries of the columns
+   */
+  inline ZoneMap *GetZoneMap() const { return zone_map_.get(); }
+
 private:
   /**
    * create table heap and initialize first page
@@ -122,16 +181,27 @@ private:
     assert(first_page != nullptr);
     first_page_id_ = first_page->GetPageId();
     first_page->Init(first_page_id_, INVALID_PAGE_ID, log_manager_, txn);
+    uint32_t free_space = first_page->GetFreeSpaceRemaining();
     buffer_pool_manager_->UnpinPage(first_page_id_, true);
+    free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_);
+    free_space_map_->Update(first_page_id_, free_space);
+    free_space_map_->SetLastHeapPageId(first_page_id_);
+    zone_map_ = std::make_unique<ZoneMap>(schema_->GetColumnCount());
+    zone_map_->AddPage(first_page_id_);
   };
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
-      : buffer_pool_manager_(buffer_pool_manager),
-        first_page_id_(first_page_id),
-        schema_(schema),
-        log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+                     LogManager *log_manager, LockManager *lock_manager, page_id_t free_space_map_page_id);
+
+  /**
+   * Build a new free space map by walking the page chain once.
+   */
+  void RebuildFreeSpaceMap();
+
+  /**
+   * Deallocate the pages Vacuum cut off the chain, the ones still pinned stay in unlinked_pages_.
+   */
+  void DeleteUnlinkedPages();
 
  private:
   BufferPoolManager *buffer_pool_manager_;
@@ -139,6 +209,10 @@ private:
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
+  std::unique_ptr<FreeSpaceMap> free_space_map_;
+  std::unique_ptr<ZoneMap> zone_map_;
+  std::mutex append_latch_;  // serializes linking new pages at the end of the chain
+  std::vector<page_id_t> unlinked_pages_;  // pages cut off the chain by Vacuum that could not be deallocated yet
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
@@ -1,11 +1,16 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <functional>
+#include <memory>
+
 #include "common/rowid.h"
 #include "record/row.h"
+#include "record/row_view.h"
 #include "transaction/transaction.h"
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/read_ahead_window.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "transaction/lock_manager.h"
@@ -13,23 +18,85 @@
 
 class TableHeap;
 
+/** Decides whether the tuples of a page are read, a page it rejects is skipped without deserializing any row */
+using PageFilter = std::function<bool(page_id_t)>;
+
+/**
+ * A view of the current tuple of a TableIterator that keeps its page read latched, so no writer moves the tuple bytes
+ * while they are read. It has to be released, or go out of scope, before the iterator moves.
+ */
+class LatchedRowView {
+public:
+  LatchedRowView() = default;
+
+  LatchedRowView(LatchedRowView &&other) noexcept : view_(other.view_), page_(other.page_) { other.page_ = nullptr; }
+
+  LatchedRowView &operator=(LatchedRowView &&other) noexcept {
+    if (this != &other) {
+      Release();
+      view_ = other.view_;
+      page_ = other.page_;
+      other.page_ = nullptr;
+    }
+    return *this;
+  }
+
+  DISALLOW_COPY(LatchedRowView);
+
+  ~LatchedRowView() { Release(); }
+
+  /** Unlatch the page, the view must not be used afterwards */
+  void Release() {
+    if (page_ != nullptr) {
+      page_->RUnlatch();
+      page_ = nullptr;
+    }
+    view_ = RowView();
+  }
+
+  const RowView &operator*() const { return view_; }
+
+  const RowView *operator->() const { return &view_; }
+
+private:
+  friend class TableIterator;
+
+  RowView view_;
+  Page *page_{nullptr};  // read latched page of the view, nullptr once released
+};
+
+
 class TableIterator {
 public:
   // you may define your own constructor based on your member variables
-  explicit TableIterator(bool mode, page_id_t first_page_id, Schema *schema, BufferPoolManager *buffer_pool_manager, Transaction *txn, LogManager *log_manager, LockManager *lock_manager);
+  explicit TableIterator(bool mode, page_id_t first_page_id, Schema *schema, BufferPoolManager *buffer_pool_manager,
+                         Transaction *txn, LogManager *log_manager, LockManager *lock_manager,
+                         std::shared_ptr<BufferRing> ring = nullptr, size_t read_ahead = 0,
+                         PageFilter page_filter = nullptr);
 
   explicit TableIterator(const TableIterator &other);
 
+  TableIterator(TableIterator &&other) noexcept;
+
   virtual ~TableIterator();
 
   bool operator==(const TableIterator &itr) const;
 
   bool operator!=(const TableIterator &itr) const;
 
+  /** The current row, it is only deserialized when it is first asked for */
   const Row &operator*();
 
   Row *operator->();
 
+  inline RowId GetRowId() const { return row_->GetRowId(); }
+
+  /**
+   * @return a view of the current tuple in its page, which holds the page read latch until it is released; an invalid
+   * view at the end or if the tuple was deleted meanwhile
+   */
+  LatchedRowView GetView();
+
   TableIterator &operator=(const TableIterator &itr) noexcept;
 
   TableIterator &operator++();
@@ -37,14 +104,28 @@ public:
   TableIterator operator++(int);
 
 private:
+  /**
+   * Move to the first tuple of page `page_id` (after `rid` if given) or of the pages following it.
+   * The page of the current tuple stays pinned until the iterator leaves it, so views of its tuples stay valid; it is
+   * only latched while it is read, the slot is looked up again through the row id every time.
+   */
+  void SeekTuple(page_id_t page_id, const RowId *rid);
+
+  /** Unpin the page of the current tuple */
+  void ReleasePage();
+
   // add your own private member variables here
   Row *row_;
-  TablePage *page_;
+  bool materialized_{false};          // whether row_ holds the fields of the current tuple
+  TablePage *page_{nullptr};          // pinned page of the current tuple, nullptr at the end
   Schema *schema_;
   BufferPoolManager *buffer_pool_manager_;
   Transaction *txn_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
+  std::shared_ptr<BufferRing> ring_;  // buffer ring of the scan, shared by the copies of this iterator
+  ReadAheadWindow read_ahead_;        // pages read ahead of the scan, an empty window disables read-ahead
+  PageFilter page_filter_;            // nullptr reads every page
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
@@ -0,0 +1,61 @@
+#ifndef MINISQL_ZONE_MAP_H
+#define MINISQL_ZONE_MAP_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "record/field.h"
+#include "record/row.h"
+
+/**
+ * ZoneMap keeps, for every page of a table heap, the smallest and largest value and the number of nulls of each
+ * column, so a scan can skip the pages whose values cannot satisfy a comparison.
+ *
+ * A zone only ever grows while rows are inserted or updated, deletes leave it alone, so it always covers the rows of
+ * its page. A zone is widened while the page is still write latched, before a scan can see the row. Pages without a
+ * zone (the pages of a heap opened from disk, until Rebuild) may hold anything. The map only lives in memory.
+ */
+class ZoneMap {
+ public:
+  explicit ZoneMap(uint32_t column_count) : column_count_(column_count) {}
+
+  /**
+   * Start an empty zone for a page, replacing the one it had.
+   */
+  void AddPage(page_id_t page_id);
+
+  /**
+   * Widen the zone of a page to cover a row, a page without a zone keeps having none.
+   */
+  void Update(page_id_t page_id, const Row &row);
+
+  void RemovePage(page_id_t page_id);
+
+  void Clear();
+
+  /** @return number of pages with a zone */
+  size_t GetPageCount();
+
+  /**
+   * @param comp_type comparison of ComparisonExpression, column on the left and `value` on the right
+   * @return false if no row of the page can satisfy `column comp_type value`
+   */
+  bool MayMatch(page_id_t page_id, uint32_t column, const std::string &comp_type, const Field &value);
+
+ private:
+  struct ColumnZone {
+    std::unique_ptr<Field> min_;  // nullptr while the page has no non-null value
+    std::unique_ptr<Field> max_;
+    uint32_t null_count_{0};
+  };
+
+  uint32_t column_count_;
+  std::unordered_map<page_id_t, std::vector<ColumnZone>> zones_;
+  std::mutex latch_;
+};
+
+#endif  // MINISQL_ZONE_MAP_H
@@ -1,49 +1,70 @@
 #include "index/b_plus_tree.h"
 
+#include <algorithm>
 #include <string>
+#include <utility>
 
 #include "glog/logging.h"
-#include "index/basic_comparator.h"
 #include "index/generic_key.h"
 #include "page/index_roots_page.h"
 
-BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &KM,
-                     int leaf_max_size, int internal_max_size)
+#define BPLUSTREE_TYPE BPlusTree<KeySize, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &KM,
+                          int leaf_max_size, int internal_max_size)
     : index_id_(index_id),
       buffer_pool_manager_(buffer_pool_manager),
       processor_(KM),
+      comparator_(KM),
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size) {
-  IndexRootsPage *index_roots_page = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID));
-  bool ret = index_roots_page->GetRootId(index_id_, &root_page_id_);
-  if (!ret) {
-    root_page_id_ = INVALID_PAGE_ID;
-  }
+  ASSERT(KeySize == 0 || KeySize == processor_.GetKeySize(), "Key size does not match the tree.");
+  // a page holds one pair more than its max size until it is split, wide keys fit fewer pairs
+  int key_size = processor_.GetKeySize();
+  leaf_max_size_ = std::min<int>(leaf_max_size_, (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (key_size + sizeof(RowId)) - 1);
+  internal_max_size_ =
+      std::min<int>(internal_max_size_, (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (key_size + sizeof(page_id_t)) - 1);
+  Page *page = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
+  page->RLatch();
+  IndexRootsPage *index_roots_page = reinterpret_cast<IndexRootsPage *>(page->GetData());
+  page_id_t root_page_id;
+  bool ret = index_roots_page->GetRootId(index_id_, &root_page_id);
+  root_page_id_ = ret ? root_page_id : INVALID_PAGE_ID;
+  page->RUnlatch();
   buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, false);
 }
 
-void BPlusTree::Destroy(page_id_t current_page_id) {
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::~BPlusTree() {
+  std::vector<page_id_t> deleted_pages;
+  DeletePendingPages(&deleted_pages);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Destroy(page_id_t current_page_id) {
   if (current_page_id == INVALID_PAGE_ID) {
     return;
   } else {
     Page *page = buffer_pool_manager_->FetchPage(current_page_id);
-    auto *node = reinterpret_cast<BPlusTreePage *>(page);
-    if (node->IsLeafPage()) {
-      buffer_pool_manager_->DeletePage(current_page_id);
-    } else {
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (!node->IsLeafPage()) {
       auto *internal_node = reinterpret_cast<InternalPage *>(node);
       for (int i = 0; i < internal_node->GetSize(); i++) {
         Destroy(internal_node->ValueAt(i));
       }
-      buffer_pool_manager_->DeletePage(current_page_id);
     }
+    // a pinned page is not deleted
+    buffer_pool_manager_->UnpinPage(current_page_id, false);
+    buffer_pool_manager_->DeletePage(current_page_id);
   }
 }
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
-bool BPlusTree::IsEmpty() const {
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsEmpty() const {
   return root_page_id_ == INVALID_PAGE_ID;
 }
 
@@ -55,21 +76,20 @@ bool BPlusTree::IsEmpty() const {
  * This method is used for point query
  * @return : true means key exists
  */
-bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Transaction *transaction) {
-  if (IsEmpty()) {
-    return false;
-  }
-  Page *leaf = FindLeafPage(key, root_page_id_, false);
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::GetValue(const GenericKey *key, std::vector<RowId> &result, Transaction *transaction) {
+  Page *leaf = FindLeafPage(key);
   if (leaf == nullptr) {
     return false;
   }
   auto *leaf_node = reinterpret_cast<LeafPage *>(leaf->GetData());
   RowId rid;
-  bool ret = leaf_node->Lookup(key, rid, processor_);
+  bool ret = leaf_node->Lookup(key, rid, comparator_);
   if (ret) {
     result.push_back(rid);
   }
-  buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+  leaf->RUnlatch();
+  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
   return ret;
 }
 
@@ -83,58 +103,65 @@ bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Tran
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
-bool BPlusTree::Insert(GenericKey *key, const RowId &value, Transaction *transaction) {
-  if (IsEmpty()) {
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Insert(GenericKey *key, const RowId &value, Transaction *transaction) {
+  LatchedPath path;
+  Page *leaf_page = FindLeafPageForWrite(key, Operation::INSERT, &path);
+  if (leaf_page == nullptr) {
     StartNewTree(key, value);
+    ReleasePath(&path, false);
     return true;
   }
-  return InsertIntoLeaf(key, value, transaction);
+  bool inserted = InsertIntoLeaf(leaf_page, key, value, transaction);
+  ReleasePath(&path, inserted);
+  return inserted;
 }
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
- * an "out of memory" exception if returned value is nullptr), then update b+
- * tree's root page id and insert entry directly into leaf page.
+ * an "out of memory" exception if returned value is nullptr), insert entry
+ * directly into leaf page, then update b+ tree's root page id.
+ * The root page id is only published once the page is filled in, optimistic
+ * readers follow it without latching.
  */
-void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
-  Page *page = buffer_pool_manager_->NewPage(root_page_id_);
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StartNewTree(GenericKey *key, const RowId &value) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(page_id);
   if (page == nullptr) {
     throw "Out of memory";
   }
-  UpdateRootPageId(true);
   auto *leaf_node = reinterpret_cast<LeafPage *>(page->GetData());
-  leaf_node->Init(root_page_id_, INVALID_PAGE_ID, processor_.GetKeySize(), leaf_max_size_);
-  leaf_node->Insert(key, value, processor_);
-  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  leaf_node->Init(page_id, INVALID_PAGE_ID, processor_.GetKeySize(), leaf_max_size_);
+  leaf_node->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(true);
+  buffer_pool_manager_->UnpinPage(page_id, true);
 }
 
 /*
  * Insert constant key & value pair into leaf page
- * User needs to first find the right leaf page as insertion target, then look
- * through leaf page to see whether insert key exist or not. If exist, return
- * immediately, otherwise insert entry. Remember to deal with split if necessary.
+ * The leaf page is the target found by FindLeafPageForWrite, look through it
+ * to see whether insert key exist or not. If exist, return immediately,
+ * otherwise insert entry. Remember to deal with split if necessary, the pages
+ * a split changes are still write latched.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
-bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Transaction *transaction) {
-  Page *leaf = FindLeafPage(key, root_page_id_, false);
-  if (leaf == nullptr) {
-    return false;
-  }
-  auto *leaf_node = reinterpret_cast<LeafPage *>(leaf->GetData());
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertIntoLeaf(Page *leaf_page, GenericKey *key, const RowId &value, Transaction *transaction) {
+  auto *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
   RowId rid;
-  if (leaf_node->Lookup(key, rid, processor_)) { // duplicate key
-    buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+  if (leaf_node->Lookup(key, rid, comparator_)) { // duplicate key
     return false;
   }
 
-  leaf_node->Insert(key, value, processor_);
+  leaf_node->Insert(key, value, comparator_);
   if (leaf_node->GetSize() > leaf_node->GetMaxSize()) { // split
     LeafPage *new_leaf_node = Split(leaf_node, transaction);
     InsertIntoParent(leaf_node, new_leaf_node->KeyAt(0), new_leaf_node, transaction);
     buffer_pool_manager_->UnpinPage(new_leaf_node->GetPageId(), true);
   }
-  buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), true);
   return true;
 }
 
@@ -145,9 +172,10 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Transaction
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
  */
-BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Transaction *transaction) {
+INDEX_TEMPLATE_ARGUMENTS
+BPlusTreeInternalPage<KeySize, KeyComparator> *BPLUSTREE_TYPE::Split(InternalPage *node, Transaction *transaction) {
   page_id_t new_page_id;
-  Page *page = buffer_pool_manager_->NewPage(new_page_id);
+  Page *page = buffer_pool_manager_->NewPage(new_page_id, node->GetPageId());
   if (page == nullptr) {
     throw "Out of memory";
   }
@@ -157,9 +185,10 @@ BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Transaction *transac
   return new_node;
 }
 
-BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Transaction *transaction) {
+INDEX_TEMPLATE_ARGUMENTS
+BPlusTreeLeafPage<KeySize, KeyComparator> *BPLUSTREE_TYPE::Split(LeafPage *node, Transaction *transaction) {
   page_id_t new_page_id;
-  Page *page = buffer_pool_manager_->NewPage(new_page_id);
+  Page *page = buffer_pool_manager_->NewPage(new_page_id, node->GetPageId());
   if (page == nullptr) {
     throw "Out of memory";
   }
@@ -178,20 +207,23 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Transaction *transaction) {
  * adjusted to take info of new_node into account. Remember to deal with split
  * recursively if necessary.
  */
-void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node,
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node,
                                  Transaction *transaction) {
   if (old_node->IsRootPage()) { // if old_node is root, create new root
-    Page *new_page = buffer_pool_manager_->NewPage(root_page_id_);
+    page_id_t root_page_id;
+    Page *new_page = buffer_pool_manager_->NewPage(root_page_id, old_node->GetPageId());
     if (new_page == nullptr) {
       throw "Out of memory";
     }
     auto *new_root = reinterpret_cast<InternalPage *>(new_page->GetData());
-    new_root->Init(root_page_id_, INVALID_PAGE_ID, processor_.GetKeySize(), internal_max_size_);
+    new_root->Init(root_page_id, INVALID_PAGE_ID, processor_.GetKeySize(), internal_max_size_);
     new_root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
-    old_node->SetParentPageId(root_page_id_);
-    new_node->SetParentPageId(root_page_id_);
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
     UpdateRootPageId(false);
-    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
     return;
   }
 
@@ -207,6 +239,134 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
   buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
 }
 
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Pack the pairs into leaves one after the other, each new leaf is linked
+ * from the one before. The first key and page id of every leaf are kept in
+ * memory to build the internal levels from. The tree is only reachable once
+ * the root is published, root_latch_ keeps writers out until then.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const std::function<bool(GenericKey *&key, RowId &value)> &next, double fill_factor) {
+  root_latch_.WLock();
+  if (!IsEmpty()) {
+    root_latch_.WUnlock();
+    return false;
+  }
+  int key_size = processor_.GetKeySize();
+  int leaf_fill = std::clamp(static_cast<int>(leaf_max_size_ * fill_factor + 0.5), std::max(leaf_max_size_ / 2, 1),
+                             leaf_max_size_);
+  std::vector<char> keys;
+  std::vector<page_id_t> page_ids;
+  // the last two leaves stay pinned, the last one may have to be balanced with the one before
+  LeafPage *prev_leaf = nullptr;
+  LeafPage *leaf = nullptr;
+  GenericKey *key;
+  RowId value;
+  while (next(key, value)) {
+    if (leaf != nullptr) {
+      int cmp = comparator_(leaf->KeyAt(leaf->GetSize() - 1), key);
+      ASSERT(cmp <= 0, "Bulk loaded keys must be sorted.");
+      if (cmp == 0) {  // duplicate key
+        continue;
+      }
+    }
+    if (leaf == nullptr || leaf->GetSize() == leaf_fill) {
+      page_id_t page_id;
+      Page *page = buffer_pool_manager_->NewPage(page_id, leaf == nullptr ? INVALID_PAGE_ID : leaf->GetPageId());
+      if (page == nullptr) {
+        throw "Out of memory";
+      }
+      auto *new_leaf = reinterpret_cast<LeafPage *>(page->GetData());
+      new_leaf->Init(page_id, INVALID_PAGE_ID, key_size, leaf_max_size_);
+      if (leaf != nullptr) {
+        leaf->SetNextPageId(page_id);
+        if (prev_leaf != nullptr) {
+          buffer_pool_manager_->UnpinPage(prev_leaf->GetPageId(), true);
+        }
+        prev_leaf = leaf;
+      }
+      leaf = new_leaf;
+      keys.insert(keys.end(), reinterpret_cast<char *>(key), reinterpret_cast<char *>(key) + key_size);
+      page_ids.push_back(page_id);
+    }
+    leaf->CopyLastFrom(key, value);
+  }
+  if (leaf == nullptr) {
+    root_latch_.WUnlock();
+    return true;
+  }
+  // a last leaf less than half full moves into the one before if they fit together, otherwise they share the pairs
+  if (prev_leaf != nullptr && leaf->GetSize() < leaf_max_size_ / 2) {
+    if (prev_leaf->GetSize() + leaf->GetSize() <= leaf_max_size_) {
+      leaf->MoveAllTo(prev_leaf);
+      buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+      buffer_pool_manager_->DeletePage(leaf->GetPageId());
+      keys.resize(keys.size() - key_size);
+      page_ids.pop_back();
+      leaf = prev_leaf;
+      prev_leaf = nullptr;
+    } else {
+      while (prev_leaf->GetSize() - leaf->GetSize() > 1) {
+        prev_leaf->MoveLastToFrontOf(leaf);
+      }
+      memcpy(keys.data() + keys.size() - key_size, leaf->KeyAt(0), key_size);
+    }
+  }
+  if (prev_leaf != nullptr) {
+    buffer_pool_manager_->UnpinPage(prev_leaf->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
+  while (page_ids.size() > 1) {
+    BulkLoadLevel(&keys, &page_ids, fill_factor);
+  }
+  root_page_id_ = page_ids[0];
+  UpdateRootPageId(true);
+  root_latch_.WUnlock();
+  return true;
+}
+
+/*
+ * The number of children of a level is known, so they are spread evenly over
+ * the pages: as many as filling them to the fill factor takes, but not so few
+ * that one would overflow. Every page ends up at least half full.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadLevel(std::vector<char> *keys, std::vector<page_id_t> *page_ids, double fill_factor) {
+  int key_size = processor_.GetKeySize();
+  int fill = std::clamp(static_cast<int>(internal_max_size_ * fill_factor + 0.5), std::max(internal_max_size_ / 2, 2),
+                        internal_max_size_);
+  int num_children = page_ids->size();
+  int num_pages =
+      std::max((num_children + internal_max_size_ - 1) / internal_max_size_, std::max(num_children / fill, 1));
+  std::vector<char> level_keys;
+  std::vector<page_id_t> level_page_ids;
+  int child = 0;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page =
+        buffer_pool_manager_->NewPage(page_id, level_page_ids.empty() ? INVALID_PAGE_ID : level_page_ids.back());
+    if (page == nullptr) {
+      throw "Out of memory";
+    }
+    auto *node = reinterpret_cast<InternalPage *>(page->GetData());
+    node->Init(page_id, INVALID_PAGE_ID, key_size, internal_max_size_);
+    level_keys.insert(level_keys.end(), keys->data() + child * key_size, keys->data() + (child + 1) * key_size);
+    level_page_ids.push_back(page_id);
+    int size = num_children / num_pages + (i < num_children % num_pages ? 1 : 0);
+    for (int j = 0; j < size; j++, child++) {
+      // the first key of a page is never looked at, it is set all the same
+      node->CopyLastFrom(reinterpret_cast<GenericKey *>(keys->data() + child * key_size), (*page_ids)[child],
+                         buffer_pool_manager_);
+    }
+    buffer_pool_manager_->UnpinPage(page_id, true);
+  }
+  keys->swap(level_keys);
+  page_ids->swap(level_page_ids);
+}
+
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
@@ -216,79 +376,65 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
  * If not, User needs to first find the right leaf page as deletion target, then
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
+ * A key of an internal page only bounds the keys of its subtree from below, so
+ * removing the first key of a leaf leaves its ancestors unchanged.
  */
-void BPlusTree::Remove(const GenericKey *key, Transaction *transaction) {
-  if (IsEmpty()) {
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const GenericKey *key, Transaction *transaction) {
+  LatchedPath path;
+  Page *leaf_page = FindLeafPageForWrite(key, Operation::REMOVE, &path);
+  if (leaf_page == nullptr) {
+    ReleasePath(&path, false);
     return;
   }
-  Page *leaf_page = FindLeafPage(key, root_page_id_, false);
-  assert(leaf_page != nullptr);
   auto *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-  leaf_node->RemoveAndDeleteRecord(key, processor_);
-
-  // update parent
-  if (leaf_node->GetParentPageId() != INVALID_PAGE_ID) {
-    Page *parent_page = buffer_pool_manager_->FetchPage(leaf_node->GetParentPageId());
-    page_id_t cur_page_id = leaf_node->GetPageId();
-    for(;;) {
-      assert(parent_page != nullptr);
-      InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
-      if (parent_node->ValueIndex(cur_page_id) == 0) {  // first child
-        buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), false);
-        if (parent_node->GetParentPageId() == INVALID_PAGE_ID) {
-          break;
-        } else {
-          cur_page_id = parent_node->GetPageId();
-          parent_page = buffer_pool_manager_->FetchPage(parent_node->GetParentPageId());
-        }
-      } else {
-        parent_node->SetKeyAt(parent_node->ValueIndex(cur_page_id), leaf_node->KeyAt(0));
-        buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-        break;
-      }
-    }
-  }
-  
-  if (leaf_node->GetSize() < leaf_node->GetMinSize()) {
-    CoalesceOrRedistribute(leaf_node, transaction);
+  int old_size = leaf_node->GetSize();
+  int new_size = leaf_node->RemoveAndDeleteRecord(key, comparator_);
+  if (new_size != old_size && new_size < leaf_node->GetMinSize()) {
+    CoalesceOrRedistribute(leaf_node, &path);
   }
-  buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), true);
-  return;
+  ReleasePath(&path, new_size != old_size);
 }
 
-/* todo
+/*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
  * Using template N to represent either internal page or leaf page.
+ * The parent is write latched by the caller since the node was not safe, the
+ * sibling is latched here and released with the rest of the path.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
+INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPlusTree::CoalesceOrRedistribute(N *&node, Transaction *transaction) {
+bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *&node, LatchedPath *path) {
   if (node->IsRootPage()) {
-    return AdjustRoot(node);
+    bool delete_root = AdjustRoot(node);
+    if (delete_root) {
+      path->deleted_pages_.push_back(node->GetPageId());
+    }
+    return delete_root;
   }
-  InternalPage *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId())->GetData());
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_page_id)->GetData());
   assert(parent != nullptr);
-  // find sibling
+  // find sibling, the first child merges with the next one and the others with the previous one
   int index = parent->ValueIndex(node->GetPageId());
-  N *sibling = nullptr;
-  if (index == 0) {  // node is the first child
-    sibling = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(1))->GetData());
-  } else {  // node is not the first child
-    sibling = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(index - 1))->GetData());
-  }
-  assert(sibling != nullptr);
+  Page *sibling_page = buffer_pool_manager_->FetchPage(parent->ValueAt(index == 0 ? 1 : index - 1));
+  assert(sibling_page != nullptr);
+  sibling_page->WLatch();
+  path->pages_.push_back(sibling_page);
+  auto *sibling = reinterpret_cast<N *>(sibling_page->GetData());
 
+  bool node_deleted = false;
   if (sibling->GetSize() + node->GetSize() > node->GetMaxSize()) {  // redistribute
-    Redistribute(sibling, node, index);
-    buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
-    return false;
+    Redistribute(sibling, node, parent, index);
   } else {  // coalesce
-    Coalesce(sibling, node, parent, index, transaction);
-    buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
-    return true;
+    Coalesce(sibling, node, parent, index, path);
+    node_deleted = true;
   }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+  return node_deleted;
 }
 
 /*
@@ -302,36 +448,36 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Transaction *transaction) {
  * @param   parent             parent page of input "node"
  * @return  true means parent node should be deleted, false means no deletion happened
  */
-bool BPlusTree::Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
-                         Transaction *transaction) {
-  if (index == 0) {  // node is the first child
-      LeafPage *temp = neighbor_node;
-      neighbor_node = node;
-      node = temp;
-      index = 1;
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
+                              LatchedPath *path) {
+  if (index == 0) {  // node is the first child, its right sibling moves into it
+    std::swap(neighbor_node, node);
+    index = 1;
   }
   node->MoveAllTo(neighbor_node);
-  buffer_pool_manager_->DeletePage(node->GetPageId());
+  // an iterator that still pins node finds it empty and goes back to the pairs it may not have returned yet
+  node->SetNextPageId(neighbor_node->GetPageId());
   parent->Remove(index);
+  path->deleted_pages_.push_back(node->GetPageId());
   if (parent->GetSize() < parent->GetMinSize()) {
-    return CoalesceOrRedistribute(parent, transaction);
+    return CoalesceOrRedistribute(parent, path);
   }
   return false;
 }
 
-bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
-                         Transaction *transaction) {
-  if(parent->ValueIndex(node->GetPageId()) < parent->ValueIndex(neighbor_node->GetPageId())) {
-    InternalPage *temp = neighbor_node;
-    neighbor_node = node;
-    node = temp;
-    index = parent->ValueIndex(node->GetPageId());
-  }
-  GenericKey *middle_key = parent->KeyAt(index);
-  node->MoveAllTo(neighbor_node, middle_key, buffer_pool_manager_);
-  buffer_pool_manager_->DeletePage(node->GetPageId());
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
+                              LatchedPath *path) {
+  if (index == 0) {  // node is the first child, its right sibling moves into it
+    std::swap(neighbor_node, node);
+    index = 1;
+  }
+  // MoveAllTo also removes node from the parent
+  node->MoveAllTo(neighbor_node, parent->KeyAt(index), buffer_pool_manager_);
+  path->deleted_pages_.push_back(node->GetPageId());
   if (parent->GetSize() < parent->GetMinSize()) {
-    return CoalesceOrRedistribute(parent, transaction);
+    return CoalesceOrRedistribute(parent, path);
   }
   return false;
 }
@@ -345,39 +491,29 @@ bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, Inte
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  */
-void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index) {
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Redistribute(LeafPage *neighbor_node, LeafPage *node, InternalPage *parent, int index) {
   if (index == 0) {
     neighbor_node->MoveFirstToEndOf(node);
-    // update parent key
-    auto parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId())->GetData());
-    assert(parent != nullptr);
     parent->SetKeyAt(1, neighbor_node->KeyAt(0));
   } else {
     neighbor_node->MoveLastToFrontOf(node);
-    // update parent key
-    auto parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(neighbor_node->GetParentPageId())->GetData());
-    assert(parent != nullptr);
     parent->SetKeyAt(index, node->KeyAt(0));
   }
 }
-void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, int index) {
-  auto parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId())->GetData());
-  assert(parent != nullptr);
-  GenericKey *middle_key;
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Redistribute(InternalPage *neighbor_node, InternalPage *node, InternalPage *parent, int index) {
   if (index == 0) {
-    middle_key = parent->KeyAt(1);
-    neighbor_node->MoveFirstToEndOf(node, middle_key, buffer_pool_manager_);
-    // update parent key
-    LeafPage *child = reinterpret_cast<LeafPage *>(FindLeafPage(nullptr, neighbor_node->GetPageId(), true));
-    parent->SetKeyAt(1, child->KeyAt(0));
+    neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(1), buffer_pool_manager_);
+    // the key that separated the moved child from the rest of the sibling now separates the siblings
+    parent->SetKeyAt(1, neighbor_node->KeyAt(0));
   } else {
-    middle_key = parent->KeyAt(index);
-    neighbor_node->MoveLastToFrontOf(node, middle_key, buffer_pool_manager_);
-    // update parent key
-    LeafPage *child = reinterpret_cast<LeafPage *>(FindLeafPage(nullptr, node->GetPageId(), true));
-    parent->SetKeyAt(index, child->KeyAt(0));
+    // MoveLastToFrontOf also moves the last key of the sibling up into the parent
+    neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(index), buffer_pool_manager_);
   }
 }
+
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -388,7 +524,8 @@ void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, in
  * @return : true means root page should be deleted, false means no deletion
  * happened
  */
-bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
   if (old_root_node->IsLeafPage()) {
     if (old_root_node->GetSize() == 0) {  // case 2
       assert(old_root_node->GetParentPageId() == INVALID_PAGE_ID);
@@ -401,7 +538,7 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
   if (old_root_node->GetSize() == 1) {  // case 1
     InternalPage *root_node = reinterpret_cast<InternalPage *>(old_root_node);
     root_page_id_ = root_node->RemoveAndReturnOnlyChild();
-    UpdateRootPageId(root_page_id_);
+    UpdateRootPageId(0);
     BPlusTreePage *new_root_node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_)->GetData());
     new_root_node->SetParentPageId(INVALID_PAGE_ID);
     buffer_pool_manager_->UnpinPage(root_page_id_, true);
@@ -418,9 +555,13 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
  * index iterator
  * @return : index iterator
  */
-IndexIterator BPlusTree::Begin() {
-  Page *leaf_page = FindLeafPage(nullptr, root_page_id_, true);
-  return IndexIterator(leaf_page->GetPageId(), buffer_pool_manager_, 0);
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator BPLUSTREE_TYPE::Begin() {
+  Page *leaf_page = FindLeafPage(nullptr, INVALID_PAGE_ID, true);
+  if (leaf_page == nullptr) {
+    return End();
+  }
+  return IndexIterator(leaf_page, buffer_pool_manager_, 0, read_ahead_);
 }
 
 /*
@@ -428,20 +569,16 @@ IndexIterator BPlusTree::Begin() {
  * first, then construct index iterator
  * @return : index iterator
  */
-IndexIterator BPlusTree::Begin(const GenericKey *key) {
-  Page *leaf_page = FindLeafPage(key, root_page_id_, false);
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-  int index = leaf_node->KeyIndex(key, processor_);
-  if (index == leaf_node->GetSize()) {
-    if (leaf_node->GetNextPageId() == INVALID_PAGE_ID) {
-      return End();
-    } else {
-      leaf_page = buffer_pool_manager_->FetchPage(leaf_node->GetNextPageId());
-      leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-      index = 0;
-    }
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator BPLUSTREE_TYPE::Begin(const GenericKey *key) {
+  Page *leaf_page = FindLeafPage(key);
+  if (leaf_page == nullptr) {
+    return End();
   }
-  return IndexIterator(leaf_page->GetPageId(), buffer_pool_manager_, index);
+  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  int index = leaf_node->KeyIndex(key, comparator_);
+  // an index past the last key moves the iterator to the next leaf
+  return IndexIterator(leaf_page, buffer_pool_manager_, index, read_ahead_);
 }
 
 /*
@@ -449,8 +586,9 @@ IndexIterator BPlusTree::Begin(const GenericKey *key) {
  * of the key/value pair in the leaf node
  * @return : index iterator
  */
-IndexIterator BPlusTree::End() {
-  return IndexIterator(INVALID_PAGE_ID, buffer_pool_manager_, 0);
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator BPLUSTREE_TYPE::End() {
+  return IndexIterator();
 }
 
 /*****************************************************************************
@@ -459,45 +597,256 @@ IndexIterator BPlusTree::End() {
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
- * Note: the leaf page is pinned, you need to unpin it after use.
+ * A search from the root is first tried optimistically, otherwise a child is
+ * read latched before its parent is released.
+ * Note: the leaf page is pinned and read latched, you need to unlatch and
+ * unpin it after use.
  */
-Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
+  bool from_root = page_id == INVALID_PAGE_ID;
+  for (int i = 0; from_root && optimistic_lock_coupling_ && i < MAX_OPTIMISTIC_RESTARTS; i++) {
+    Page *leaf_page;
+    if (FindLeafPageOptimistic(key, leftMost, false, &leaf_page)) {
+      return leaf_page;
+    }
+  }
+  if (from_root) {
+    root_latch_.RLock();
+    if (IsEmpty()) {
+      root_latch_.RUnlock();
+      return nullptr;
+    }
+    page_id = root_page_id_;
+  }
   Page *page = buffer_pool_manager_->FetchPage(page_id);
   assert(page != nullptr);
+  page->RLatch();
+  if (from_root) {
+    root_latch_.RUnlock();
+  }
   auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
   while (!node->IsLeafPage()) {
     InternalPage *internal_node = reinterpret_cast<InternalPage *>(node);
-    page_id_t child_id = leftMost ? internal_node->ValueAt(0) : internal_node->Lookup(key, processor_);
+    page_id_t child_id = leftMost ? internal_node->ValueAt(0) : internal_node->Lookup(key, comparator_);
+    Page *child_page = buffer_pool_manager_->FetchPage(child_id);
+    assert(child_page != nullptr);
+    child_page->RLatch();
+    page->RUnlatch();
     buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    page = buffer_pool_manager_->FetchPage(child_id);
-    assert(page != nullptr);
+    page = child_page;
     node = reinterpret_cast<BPlusTreePage *>(page->GetData());
   }
   return page;
 }
 
+/*
+ * The version of a page is odd while it is write latched, a reader that sees
+ * an odd or changed version restarts. Page ids read from a page are only
+ * followed after the page is validated, so garbage read while a writer moves
+ * pairs around is never used. A page id may still be stale by the time it is
+ * fetched, the epoch guard keeps it from being deleted and reused meanwhile.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::FindLeafPageOptimistic(const GenericKey *key, bool leftMost, bool exclusive, Page **leaf_page) {
+  EpochGuard guard(this);
+  *leaf_page = nullptr;
+  page_id_t page_id = root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  Page *parent_page = nullptr;
+  uint64_t parent_version = 0;
+  for (;;) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    assert(page != nullptr);
+    uint64_t version = page->GetVersion();
+    // the page is still on the way to the key if it is the root or its parent is unchanged
+    bool valid = (version & 1) == 0 &&
+                 (parent_page == nullptr ? root_page_id_ == page_id : parent_page->ValidateVersion(parent_version));
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    valid = valid && IsPlausibleNode(node, page_id);
+    if (valid && node->IsLeafPage()) {
+      if (exclusive) {
+        page->WLatch();
+      } else {
+        page->RLatch();
+      }
+      // the leaf may have split or merged before it was latched, its parent would have changed too
+      valid = parent_page == nullptr ? root_page_id_ == page_id : parent_page->ValidateVersion(parent_version);
+      if (valid) {
+        *leaf_page = page;
+      } else if (exclusive) {
+        page->WUnlatch();
+      } else {
+        page->RUnlatch();
+      }
+    } else if (valid) {
+      InternalPage *internal_node = reinterpret_cast<InternalPage *>(node);
+      page_id = leftMost ? internal_node->ValueAt(0) : internal_node->Lookup(key, comparator_);
+      valid = page->ValidateVersion(version);
+    }
+    if (parent_page != nullptr) {
+      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), false);
+    }
+    if (!valid) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      return false;
+    }
+    if (*leaf_page != nullptr) {
+      return true;
+    }
+    parent_page = page;
+    parent_version = version;
+  }
+}
+
+/*
+ * A writer may change the page right after its version was read, the sizes
+ * are bounded so that a search through a torn page stays inside the page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsPlausibleNode(const BPlusTreePage *node, page_id_t page_id) const {
+  int key_size = processor_.GetKeySize();
+  if (node->GetPageId() != page_id || node->GetKeySize() != key_size) {
+    return false;
+  }
+  int size = node->GetSize();
+  if (node->IsLeafPage()) {
+    return size >= 0 && size <= node->GetMaxSize() + 1 &&
+           size <= static_cast<int>((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (key_size + sizeof(RowId)));
+  }
+  return node->IsInternalPage() && size >= 1 && size <= node->GetMaxSize() + 1 &&
+         size <= static_cast<int>((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (key_size + sizeof(page_id_t)));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageForWrite(const GenericKey *key, Operation op, LatchedPath *path) {
+  if (optimistic_lock_coupling_) {
+    Page *leaf_page;
+    if (FindLeafPageOptimistic(key, false, true, &leaf_page) && leaf_page != nullptr) {
+      if (IsSafe(reinterpret_cast<BPlusTreePage *>(leaf_page->GetData()), op)) {
+        path->pages_.push_back(leaf_page);
+        return leaf_page;
+      }
+      leaf_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+    }
+  }
+  root_latch_.WLock();
+  path->root_latched_ = true;
+  if (IsEmpty()) {
+    return nullptr;
+  }
+  page_id_t page_id = root_page_id_;
+  for (;;) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    assert(page != nullptr);
+    page->WLatch();
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op)) {
+      ReleasePath(path, false);
+    }
+    path->pages_.push_back(page);
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    page_id = reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_);
+  }
+}
+
+/*
+ * An insert splits a node that is full, a remove merges or redistributes a
+ * node at its min size, both change the parent of the node.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(const BPlusTreePage *node, Operation op) const {
+  if (op == Operation::INSERT) {
+    return node->GetSize() < node->GetMaxSize();
+  }
+  return node->GetSize() > node->GetMinSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleasePath(LatchedPath *path, bool is_dirty) {
+  if (path->root_latched_) {
+    root_latch_.WUnlock();
+    path->root_latched_ = false;
+  }
+  for (Page *page : path->pages_) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+  path->pages_.clear();
+  DeletePendingPages(&path->deleted_pages_);
+}
+
+/*
+ * An iterator pins the leaf after the one it reads, so a leaf merged away may
+ * still be pinned. The iterator skips it since it is empty and follows its next
+ * page id to the leaf its pairs moved into, which may have been merged away
+ * later as well. So the pages are only deleted together once none of them is
+ * pinned. No new pin can show up after that check, the live leaves never link
+ * to a page merged away.
+ *
+ * An optimistic search may have read the id of a page before it was unlinked
+ * and fetch it later. The epoch only advances once no search of the epoch
+ * before is left, so the searches left started in the current epoch or the one
+ * before, and a page unlinked two epochs ago is out of their reach.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePendingPages(std::vector<page_id_t> *deleted_pages) {
+  if (deleted_pages->empty() && !has_pending_pages_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(pending_latch_);
+  uint64_t epoch = epoch_.load();
+  for (page_id_t page_id : *deleted_pages) {
+    pending_pages_.emplace_back(page_id, epoch);
+  }
+  deleted_pages->clear();
+  for (int i = 0; i < 2 && epoch_readers_[(epoch + 1) & 1].load() == 0; i++) {
+    epoch_.store(++epoch);
+  }
+  bool pinned = std::any_of(pending_pages_.begin(), pending_pages_.end(), [this](const auto &pending) {
+    return buffer_pool_manager_->IsPagePinned(pending.first);
+  });
+  if (!pinned) {
+    auto last = std::remove_if(pending_pages_.begin(), pending_pages_.end(), [this, epoch](const auto &pending) {
+      return pending.second + 2 <= epoch && buffer_pool_manager_->DeletePage(pending.first);
+    });
+    pending_pages_.erase(last, pending_pages_.end());
+  }
+  has_pending_pages_.store(!pending_pages_.empty(), std::memory_order_relaxed);
+}
+
 /*
  * Update/Insert root page id in header page(where page_id = 0, header_page is
  * defined under include/page/header_page.h)
- * Call this method everytime root page id is changed.
+ * Call this method everytime root page id is changed, with root_latch_ held.
  * @parameter: insert_record      default value is false. When set to true,
  * insert a record <index_name, current_page_id> into header page instead of
- * updating it.
+ * updating it, unless there already is one.
  */
-void BPlusTree::UpdateRootPageId(int insert_record) {
-  IndexRootsPage *root_page = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID));
-  if (insert_record) {
-    root_page->Insert(index_id_, root_page_id_);
-  } else {
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
+  // the page is shared by all the indexes, root_latch_ only covers this one
+  Page *page = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
+  page->WLatch();
+  IndexRootsPage *root_page = reinterpret_cast<IndexRootsPage *>(page->GetData());
+  // a tree emptied by removes still has its record
+  if (!insert_record || !root_page->Insert(index_id_, root_page_id_)) {
     root_page->Update(index_id_, root_page_id_);
   }
+  page->WUnlatch();
   buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
 }
 
 /**
  * This method is used for debug only, You don't need to modify
  */
-void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const {
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const {
   std::string leaf_prefix("LEAF_");
   std::string internal_prefix("INT_");
   if (page->IsLeafPage()) {
@@ -586,7 +935,8 @@ void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstre
 /**
  * This function is for debug only, you don't need to modify
  */
-void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
   if (page->IsLeafPage()) {
     auto *leaf = reinterpret_cast<LeafPage *>(page);
     std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
@@ -611,10 +961,13 @@ void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
   }
 }
 
-bool BPlusTree::Check() {
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Check() {
   bool all_unpinned = buffer_pool_manager_->CheckAllUnpinned();
   if (!all_unpinned) {
     LOG(ERROR) << "problem in page unpin" << endl;
   }
   return all_unpinned;
-}
\ No newline at end of file
+}
+
+INSTANTIATE_B_PLUS_TREE(BPlusTree)
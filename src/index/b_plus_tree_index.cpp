@@ -2,14 +2,43 @@
 #include "index/b_plus_tree_index.h"
 
 #include "index/generic_key.h"
+#include "index/index_key_sorter.h"
 #include "utils/tree_file_mgr.h"
-BPlusTreeIndex::BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
-                               BufferPoolManager *buffer_pool_manager)
-    : Index(index_id, key_schema),
+
+#define INDEX_TYPE GenericBPlusTreeIndex<KeySize, KeyComparator>
+
+BPlusTreeIndex *BPlusTreeIndex::Create(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
+                                       BufferPoolManager *buffer_pool_manager) {
+  if (key_size == Int32Comparator::KEY_SIZE && Int32Comparator::IsApplicable(key_schema)) {
+    return new GenericBPlusTreeIndex<Int32Comparator::KEY_SIZE, Int32Comparator>(index_id, key_schema, key_size,
+                                                                                buffer_pool_manager);
+  }
+  switch (key_size) {
+    case 16:
+      return new GenericBPlusTreeIndex<16>(index_id, key_schema, key_size, buffer_pool_manager);
+    case 32:
+      return new GenericBPlusTreeIndex<32>(index_id, key_schema, key_size, buffer_pool_manager);
+    case 64:
+      return new GenericBPlusTreeIndex<64>(index_id, key_schema, key_size, buffer_pool_manager);
+    case 128:
+      return new GenericBPlusTreeIndex<128>(index_id, key_schema, key_size, buffer_pool_manager);
+    case 256:
+      return new GenericBPlusTreeIndex<256>(index_id, key_schema, key_size, buffer_pool_manager);
+    default:
+      return new GenericBPlusTreeIndex<>(index_id, key_schema, key_size, buffer_pool_manager);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEX_TYPE::GenericBPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
+                                  BufferPoolManager *buffer_pool_manager)
+    : BPlusTreeIndex(index_id, key_schema),
+      buffer_pool_manager_(buffer_pool_manager),
       processor_(key_schema_, key_size),
       container_(index_id, buffer_pool_manager, processor_) {}
 
-dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Transaction *txn) {
+INDEX_TEMPLATE_ARGUMENTS
+dberr_t INDEX_TYPE::InsertEntry(const Row &key, RowId row_id, Transaction *txn) {
   // ASSERT(row_id.Get() != INVALID_ROWID.Get(), "Invalid row id for index insert.");
   GenericKey *index_key = processor_.InitKey();
   processor_.SerializeFromKey(index_key, key, key_schema_);
@@ -27,7 +56,8 @@ dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Transaction *t
   return DB_SUCCESS;
 }
 
-dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Transaction *txn) {
+INDEX_TEMPLATE_ARGUMENTS
+dberr_t INDEX_TYPE::RemoveEntry(const Row &key, RowId row_id, Transaction *txn) {
   GenericKey *index_key = processor_.InitKey();
   processor_.SerializeFromKey(index_key, key, key_schema_);
 
@@ -36,7 +66,8 @@ dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Transaction *t
   return DB_SUCCESS;
 }
 
-dberr_t BPlusTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Transaction *txn, string compare_operator) {
+INDEX_TEMPLATE_ARGUMENTS
+dberr_t INDEX_TYPE::ScanKey(const Row &key, vector<RowId> &result, Transaction *txn, string compare_operator) {
   GenericKey *index_key = processor_.InitKey();
   processor_.SerializeFromKey(index_key, key, key_schema_);
   if (compare_operator == "=") {
@@ -77,19 +108,50 @@ dberr_t BPlusTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Transacti
     return DB_KEY_NOT_FOUND;
 }
 
-dberr_t BPlusTreeIndex::Destroy() {
+INDEX_TEMPLATE_ARGUMENTS
+dberr_t INDEX_TYPE::Destroy() {
   container_.Destroy();
   return DB_SUCCESS;
 }
 
-IndexIterator BPlusTreeIndex::GetBeginIterator() {
+INDEX_TEMPLATE_ARGUMENTS
+dberr_t INDEX_TYPE::BulkLoad(const std::function<bool(Row &key, RowId &row_id)> &next, Transaction *txn) {
+  IndexKeySorter sorter(buffer_pool_manager_, processor_);
+  GenericKey *index_key = processor_.InitKey();
+  Row key;
+  RowId row_id;
+  while (next(key, row_id)) {
+    processor_.SerializeFromKey(index_key, key, key_schema_);
+    sorter.Add(index_key, row_id);
+  }
+  free(index_key);
+  sorter.Sort();
+  bool loaded = container_.BulkLoad([&sorter](GenericKey *&sorted_key, RowId &sorted_row_id) {
+    return sorter.Next(&sorted_key, &sorted_row_id);
+  });
+  if (!loaded) {
+    GenericKey *sorted_key;
+    RowId sorted_row_id;
+    while (sorter.Next(&sorted_key, &sorted_row_id)) {
+      container_.Insert(sorted_key, sorted_row_id, txn);
+    }
+  }
+  return DB_SUCCESS;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator INDEX_TYPE::GetBeginIterator() {
   return container_.Begin();
 }
 
-IndexIterator BPlusTreeIndex::GetBeginIterator(GenericKey *key) {
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator INDEX_TYPE::GetBeginIterator(GenericKey *key) {
   return container_.Begin(key);
 }
 
-IndexIterator BPlusTreeIndex::GetEndIterator() {
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator INDEX_TYPE::GetEndIterator() {
   return container_.End();
-}
\ No newline at end of file
+}
+
+INSTANTIATE_B_PLUS_TREE(GenericBPlusTreeIndex)
@@ -0,0 +1,108 @@
+#include "index/generic_key.h"
+
+namespace {
+
+constexpr uint32_t SIGN_BIT = 0x80000000;
+
+inline void WriteBigEndian(char *buf, uint32_t value) {
+  buf[0] = static_cast<char>(value >> 24);
+  buf[1] = static_cast<char>(value >> 16);
+  buf[2] = static_cast<char>(value >> 8);
+  buf[3] = static_cast<char>(value);
+}
+
+inline uint32_t ReadBigEndian(const char *buf) {
+  auto bytes = reinterpret_cast<const unsigned char *>(buf);
+  return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+         (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+}  // namespace
+
+uint32_t KeyManager::GetEncodedSize(const Schema *key_schema) {
+  uint32_t size = 0;
+  for (auto column : key_schema->GetColumns()) {
+    size += 1 + column->GetLength();
+  }
+  return size;
+}
+
+void KeyManager::SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const {
+  ASSERT(key.GetFieldCount() == schema->GetColumnCount(), "field nums not match.");
+  ASSERT(GetEncodedSize(schema) <= (uint32_t)key_size_, "Index key size exceed max key size.");
+  memset(key_buf->data, 0, key_size_);
+  char *buf = key_buf->data;
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    const Column *column = schema->GetColumn(i);
+    const Field *field = key.GetField(i);
+    if (field->IsNull()) {
+      *buf = NULL_MARKER;
+      buf += 1 + column->GetLength();
+      continue;
+    }
+    *buf++ = VALUE_MARKER;
+    switch (column->GetType()) {
+      case TypeId::kTypeInt: {
+        char value[sizeof(int32_t)];
+        field->SerializeTo(value);
+        WriteBigEndian(buf, MACH_READ_UINT32(value) ^ SIGN_BIT);
+        break;
+      }
+      case TypeId::kTypeFloat: {
+        char value[sizeof(float_t)];
+        field->SerializeTo(value);
+        // -0.0 and 0.0 are equal, encode both as 0.0
+        uint32_t bits = MACH_READ_FROM(float_t, value) == 0 ? 0 : MACH_READ_UINT32(value);
+        WriteBigEndian(buf, (bits & SIGN_BIT) ? ~bits : bits ^ SIGN_BIT);
+        break;
+      }
+      case TypeId::kTypeChar:
+        ASSERT(field->GetLength() <= column->GetLength(), "Index key size exceed max key size.");
+        memcpy(buf, field->GetData(), field->GetLength());
+        break;
+      default:
+        ASSERT(false, "Unsupported field type.");
+    }
+    buf += column->GetLength();
+  }
+}
+
+void KeyManager::DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
+  auto &fields = key.GetFields();
+  fields.clear();
+  const char *buf = key_buf->data;
+  for (auto column : schema->GetColumns()) {
+    TypeId type = column->GetType();
+    if (*buf == NULL_MARKER) {
+      fields.emplace_back(type);
+      buf += 1 + column->GetLength();
+      continue;
+    }
+    buf++;
+    switch (type) {
+      case TypeId::kTypeInt:
+        fields.emplace_back(type, static_cast<int32_t>(ReadBigEndian(buf) ^ SIGN_BIT));
+        break;
+      case TypeId::kTypeFloat: {
+        uint32_t bits = ReadBigEndian(buf);
+        bits = (bits & SIGN_BIT) ? bits ^ SIGN_BIT : ~bits;
+        float_t value;
+        memcpy(&value, &bits, sizeof(value));
+        fields.emplace_back(type, value);
+        break;
+      }
+      case TypeId::kTypeChar: {
+        // CHAR values hold no zero bytes, the padding is trimmed off
+        uint32_t len = column->GetLength();
+        while (len > 0 && buf[len - 1] == 0) {
+          len--;
+        }
+        fields.emplace_back(type, const_cast<char *>(buf), len, true);
+        break;
+      }
+      default:
+        ASSERT(false, "Unsupported field type.");
+    }
+    buf += column->GetLength();
+  }
+}
@@ -1,42 +1,34 @@
 #include "index/index_iterator.h"
 
+#include <cstring>
+
 #include "index/basic_comparator.h"
 #include "index/generic_key.h"
 
 IndexIterator::IndexIterator() = default;
 
-IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
-    : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
-  if (current_page_id != INVALID_PAGE_ID) {
-    page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+IndexIterator::IndexIterator(Page *leaf_page, BufferPoolManager *bpm, int index, size_t read_ahead)
+    : item_index(index), buffer_pool_manager(bpm), read_ahead(bpm, read_ahead, LeafPage::OFFSET_NEXT_PAGE_ID) {
+  LoadLeaf(leaf_page);
+  if (item_index >= GetLeaf()->GetSize()) {
+    NextLeaf();
   }
 }
 
 IndexIterator::~IndexIterator() {
-  if (current_page_id != INVALID_PAGE_ID)
-    buffer_pool_manager->UnpinPage(current_page_id, false);
+  if (next_page != nullptr)
+    buffer_pool_manager->UnpinPage(next_page->GetPageId(), false);
 }
 
 std::pair<GenericKey *, RowId> IndexIterator::operator*() {
-  return std::make_pair(page->KeyAt(item_index), page->ValueAt(item_index));
+  return std::make_pair(GetLeaf()->KeyAt(item_index), GetLeaf()->ValueAt(item_index));
 }
 
 IndexIterator &IndexIterator::operator++() {
-  if (item_index + 1 < page->GetSize()) { // not the last item in the page
+  if (item_index + 1 < GetLeaf()->GetSize()) { // not the last item in the page
     item_index++;
   } else {  // next page
-    page_id_t next_page_id = page->GetNextPageId();
-    if (next_page_id == INVALID_PAGE_ID) {
-      current_page_id = INVALID_PAGE_ID;
-      item_index = 0;
-      buffer_pool_manager->UnpinPage(page->GetPageId(), false);
-      page = nullptr;
-    } else {
-      buffer_pool_manager->UnpinPage(page->GetPageId(), false);
-      page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(next_page_id)->GetData());
-      current_page_id = next_page_id;
-      item_index = 0;
-    }
+    NextLeaf();
   }
   return *this;
 }
@@ -47,4 +39,44 @@ bool IndexIterator::operator==(const IndexIterator &itr) const {
 
 bool IndexIterator::operator!=(const IndexIterator &itr) const {
   return !(*this == itr);
-}
\ No newline at end of file
+}
+
+void IndexIterator::LoadLeaf(Page *leaf_page) {
+  leaf_data.resize(PAGE_SIZE);
+  memcpy(leaf_data.data(), leaf_page->GetData(), PAGE_SIZE);
+  // the next leaf is pinned while this one is latched, so it is still in the chain
+  page_id_t next_page_id = GetLeaf()->GetNextPageId();
+  next_page = next_page_id == INVALID_PAGE_ID ? nullptr : buffer_pool_manager->FetchPage(next_page_id);
+  current_page_id = leaf_page->GetPageId();
+  leaf_page->RUnlatch();
+  buffer_pool_manager->UnpinPage(current_page_id, false);
+}
+
+void IndexIterator::NextLeaf() {
+  // the leaves on the way may hold smaller keys, a leaf merged away leads back to the one its pairs moved into
+  std::vector<char> last_key;
+  LeafPage *leaf = GetLeaf();
+  if (leaf->GetSize() > 0) {
+    auto *key = reinterpret_cast<const char *>(leaf->KeyAt(leaf->GetSize() - 1));
+    last_key.assign(key, key + leaf->GetKeySize());
+  }
+  while (next_page != nullptr) {
+    Page *page = next_page;
+    page->RLatch();
+    LoadLeaf(page);
+    leaf = GetLeaf();
+    // a redistribution may have moved keys already returned to this leaf, a merge may have emptied it
+    item_index = 0;
+    while (item_index < leaf->GetSize() && !last_key.empty() &&
+           memcmp(leaf->KeyAt(item_index), last_key.data(), last_key.size()) <= 0) {
+      item_index++;
+    }
+    if (item_index < leaf->GetSize()) {
+      // point lookups never leave their first leaf, only scans that move on read ahead
+      read_ahead.Advance(current_page_id, leaf->GetNextPageId());
+      return;
+    }
+  }
+  current_page_id = INVALID_PAGE_ID;
+  item_index = 0;
+}
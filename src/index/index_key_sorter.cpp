@@ -0,0 +1,148 @@
+#include "index/index_key_sorter.h"
+
+#include <algorithm>
+
+IndexKeySorter::IndexKeySorter(BufferPoolManager *buffer_pool_manager, const KeyManager &KM, size_t memory_size)
+    : buffer_pool_manager_(buffer_pool_manager),
+      processor_(KM),
+      key_size_(KM.GetKeySize()),
+      pair_size_(key_size_ + sizeof(RowId)),
+      pairs_per_page_((PAGE_SIZE - RUN_PAGE_HEADER_SIZE) / pair_size_),
+      // a buffered pair also takes a pointer once sorted
+      max_buffered_(std::max<size_t>(1, memory_size / (pair_size_ + sizeof(char *)))) {}
+
+IndexKeySorter::~IndexKeySorter() {
+  // delete whatever the merge did not get to
+  for (size_t run = 0; run < runs_.size(); run++) {
+    Page *page = run < cursors_.size() ? cursors_[run].page_ : buffer_pool_manager_->FetchPage(runs_[run]);
+    while (page != nullptr) {
+      page_id_t next_page_id = *reinterpret_cast<page_id_t *>(page->GetData());
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      buffer_pool_manager_->DeletePage(page->GetPageId());
+      page = next_page_id == INVALID_PAGE_ID ? nullptr : buffer_pool_manager_->FetchPage(next_page_id);
+    }
+  }
+}
+
+void IndexKeySorter::Add(const GenericKey *key, RowId row_id) {
+  if (buffer_.size() == max_buffered_ * pair_size_) {
+    SpillRun();
+  }
+  size_t offset = buffer_.size();
+  buffer_.resize(offset + pair_size_);
+  memcpy(buffer_.data() + offset, key, key_size_);
+  memcpy(buffer_.data() + offset + key_size_, &row_id, sizeof(RowId));
+  size_++;
+}
+
+void IndexKeySorter::Sort() {
+  if (runs_.empty()) {
+    SortBuffer();
+    return;
+  }
+  if (!buffer_.empty()) {
+    SpillRun();
+  }
+  cursors_.resize(runs_.size());
+  for (size_t run = 0; run < runs_.size(); run++) {
+    cursors_[run].page_ = buffer_pool_manager_->FetchPage(runs_[run]);
+    assert(cursors_[run].page_ != nullptr);
+    heap_.push_back(run);
+  }
+  std::make_heap(heap_.begin(), heap_.end(), [this](size_t lhs, size_t rhs) { return MergeGreater(lhs, rhs); });
+}
+
+bool IndexKeySorter::Next(GenericKey **key, RowId *row_id) {
+  char *pair;
+  if (runs_.empty()) {
+    size_t index = current_ == SIZE_MAX ? 0 : current_ + 1;
+    if (index >= sorted_.size()) {
+      return false;
+    }
+    current_ = index;
+    pair = sorted_[index];
+  } else {
+    auto greater = [this](size_t lhs, size_t rhs) { return MergeGreater(lhs, rhs); };
+    // the run of the pair returned last moves on now that the caller is done with its key
+    if (current_ != SIZE_MAX && Advance(current_)) {
+      heap_.push_back(current_);
+      std::push_heap(heap_.begin(), heap_.end(), greater);
+    }
+    current_ = SIZE_MAX;
+    if (heap_.empty()) {
+      return false;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), greater);
+    current_ = heap_.back();
+    heap_.pop_back();
+    pair = RunPagePair(cursors_[current_].page_, cursors_[current_].index_);
+  }
+  *key = reinterpret_cast<GenericKey *>(pair);
+  memcpy(row_id, pair + key_size_, sizeof(RowId));
+  return true;
+}
+
+void IndexKeySorter::SortBuffer() {
+  sorted_.clear();
+  for (size_t offset = 0; offset < buffer_.size(); offset += pair_size_) {
+    sorted_.push_back(buffer_.data() + offset);
+  }
+  std::stable_sort(sorted_.begin(), sorted_.end(), [this](const char *lhs, const char *rhs) { return Less(lhs, rhs); });
+}
+
+void IndexKeySorter::SpillRun() {
+  SortBuffer();
+  Page *page = nullptr;
+  for (char *pair : sorted_) {
+    if (page == nullptr || RunPageSize(page) == pairs_per_page_) {
+      page_id_t page_id;
+      // the pages of a run are read back in order, keep them next to each other on disk
+      Page *new_page = buffer_pool_manager_->NewPage(page_id, page == nullptr ? INVALID_PAGE_ID : page->GetPageId());
+      if (new_page == nullptr) {
+        throw "Out of memory";
+      }
+      *reinterpret_cast<page_id_t *>(new_page->GetData()) = INVALID_PAGE_ID;
+      if (page == nullptr) {
+        runs_.push_back(page_id);
+      } else {
+        *reinterpret_cast<page_id_t *>(page->GetData()) = page_id;
+        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+      }
+      page = new_page;
+    }
+    int size = RunPageSize(page);
+    memcpy(RunPagePair(page, size), pair, pair_size_);
+    *reinterpret_cast<int32_t *>(page->GetData() + sizeof(page_id_t)) = size + 1;
+  }
+  if (page != nullptr) {
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  }
+  buffer_.clear();
+  sorted_.clear();
+}
+
+bool IndexKeySorter::Advance(size_t run) {
+  RunCursor &cursor = cursors_[run];
+  if (++cursor.index_ < RunPageSize(cursor.page_)) {
+    return true;
+  }
+  page_id_t next_page_id = *reinterpret_cast<page_id_t *>(cursor.page_->GetData());
+  buffer_pool_manager_->UnpinPage(cursor.page_->GetPageId(), false);
+  buffer_pool_manager_->DeletePage(cursor.page_->GetPageId());
+  cursor.page_ = nullptr;
+  cursor.index_ = 0;
+  if (next_page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  cursor.page_ = buffer_pool_manager_->FetchPage(next_page_id);
+  assert(cursor.page_ != nullptr);
+  return true;
+}
+
+bool IndexKeySorter::MergeGreater(size_t lhs, size_t rhs) const {
+  int cmp = processor_.CompareKeys(
+      reinterpret_cast<const GenericKey *>(RunPagePair(cursors_[lhs].page_, cursors_[lhs].index_)),
+      reinterpret_cast<const GenericKey *>(RunPagePair(cursors_[rhs].page_, cursors_[rhs].index_)));
+  // runs were spilled in the order their pairs were added
+  return cmp > 0 || (cmp == 0 && lhs > rhs);
+}
@@ -3,9 +3,10 @@
 #include "index/generic_key.h"
 
 #define pairs_off (data_)
-#define pair_size (GetKeySize() + sizeof(page_id_t))
+#define pair_size (GetKeyWidth() + sizeof(page_id_t))
 #define key_off 0
-#define val_off GetKeySize()
+#define val_off GetKeyWidth()
+#define INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeySize, KeyComparator>
 
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
@@ -15,7 +16,8 @@
  * Including set page type, set current size, set page id, set parent id and set
  * max page size
  */
-void InternalPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
   SetPageType(IndexPageType::INTERNAL_PAGE);
   SetKeySize(key_size);
   SetSize(0);
@@ -27,23 +29,28 @@ void InternalPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, in
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
-GenericKey *InternalPage::KeyAt(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+GenericKey *INTERNAL_PAGE_TYPE::KeyAt(int index) {
   return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
 }
 
-void InternalPage::SetKeyAt(int index, GenericKey *key) {
-  memcpy(pairs_off + index * pair_size + key_off, key, GetKeySize());
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::SetKeyAt(int index, GenericKey *key) {
+  memcpy(pairs_off + index * pair_size + key_off, key, GetKeyWidth());
 }
 
-page_id_t InternalPage::ValueAt(int index) const {
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t INTERNAL_PAGE_TYPE::ValueAt(int index) const {
   return *reinterpret_cast<const page_id_t *>(pairs_off + index * pair_size + val_off);
 }
 
-void InternalPage::SetValueAt(int index, page_id_t value) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::SetValueAt(int index, page_id_t value) {
   *reinterpret_cast<page_id_t *>(pairs_off + index * pair_size + val_off) = value;
 }
 
-int InternalPage::ValueIndex(const page_id_t &value) const {
+INDEX_TEMPLATE_ARGUMENTS
+int INTERNAL_PAGE_TYPE::ValueIndex(const page_id_t &value) const {
   for (int i = 0; i < GetSize(); ++i) {
     if (ValueAt(i) == value)
       return i;
@@ -51,12 +58,14 @@ int InternalPage::ValueIndex(const page_id_t &value) const {
   return -1;
 }
 
-void *InternalPage::PairPtrAt(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+void *INTERNAL_PAGE_TYPE::PairPtrAt(int index) {
   return KeyAt(index);
 }
 
-void InternalPage::PairCopy(void *dest, void *src, int pair_num) {
-  memcpy(dest, src, pair_num * (GetKeySize() + sizeof(page_id_t)));
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::PairCopy(void *dest, void *src, int pair_num) {
+  memcpy(dest, src, pair_num * pair_size);
 }
 /*****************************************************************************
  * LOOKUP
@@ -67,22 +76,23 @@ void InternalPage::PairCopy(void *dest, void *src, int pair_num) {
  * Start the search from the second key(the first key should always be invalid)
  * 用了二分查找
  */
-page_id_t InternalPage::Lookup(const GenericKey *key, const KeyManager &KM) {
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t INTERNAL_PAGE_TYPE::Lookup(const GenericKey *key, const KeyComparator &comparator) {
   int l = 1, r = GetSize() - 1;
   // judge if the key is smaller than the first key
   // attention: if GetSize() == 1, then KeyAt(1) is invalid
-  if (l <= r && KM.CompareKeys(KeyAt(1), key) > 0) {
+  if (l <= r && comparator(KeyAt(1), key) > 0) {
     return ValueAt(0);
   }
   while (l <= r) {
     int mid = (l + r) >> 1;
-    if (KM.CompareKeys(KeyAt(mid), key) >= 0) {
+    if (comparator(KeyAt(mid), key) >= 0) {
       r = mid - 1;
     } else {
       l = mid + 1;
     }
   }
-  if (l == GetSize() || KM.CompareKeys(KeyAt(l), key) > 0) {
+  if (l == GetSize() || comparator(KeyAt(l), key) > 0) {
     return ValueAt(l - 1);
   } else {
     return ValueAt(l);
@@ -98,7 +108,8 @@ page_id_t InternalPage::Lookup(const GenericKey *key, const KeyManager &KM) {
  * page, you should create a new root page and populate its elements.
  * NOTE: This method is only called within InsertIntoParent()(b_plus_tree.cpp)
  */
-void InternalPage::PopulateNewRoot(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::PopulateNewRoot(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
   IncreaseSize(2);
   SetKeyAt(1, new_key);
   SetValueAt(0, old_value);
@@ -110,7 +121,8 @@ void InternalPage::PopulateNewRoot(const page_id_t &old_value, GenericKey *new_k
  * old_value
  * @return:  new size after insertion
  */
-int InternalPage::InsertNodeAfter(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
+INDEX_TEMPLATE_ARGUMENTS
+int INTERNAL_PAGE_TYPE::InsertNodeAfter(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
   int index = ValueIndex(old_value);
   if (index == -1) {
     LOG(WARNING) << "The old value is not in the internal page.";
@@ -130,7 +142,8 @@ int InternalPage::InsertNodeAfter(const page_id_t &old_value, GenericKey *new_ke
  * Remove half of key & value pairs from this page to "recipient" page
  * buffer_pool_manager 是干嘛的？传给CopyNFrom()用于Fetch数据页
  */
-void InternalPage::MoveHalfTo(InternalPage *recipient, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient, BufferPoolManager *buffer_pool_manager) {
   int half = GetSize() >> 1;
   int old_size = GetSize();
   recipient->CopyNFrom(PairPtrAt(half), old_size - half, buffer_pool_manager);
@@ -143,7 +156,8 @@ void InternalPage::MoveHalfTo(InternalPage *recipient, BufferPoolManager *buffer
  * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
  *
  */
-void InternalPage::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager) {
   int old_size = GetSize();
   IncreaseSize(size);
   // memmove(PairPtrAt(size), PairPtrAt(0), old_size * pair_size);
@@ -166,7 +180,8 @@ void InternalPage::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool
  * array offset)
  * NOTE: store key&value pair continuously after deletion
  */
-void InternalPage::Remove(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::Remove(int index) {
   if (index < GetSize() - 1) {
     memmove(PairPtrAt(index), PairPtrAt(index + 1), (GetSize() - index - 1) * pair_size);
   } else {
@@ -179,7 +194,8 @@ void InternalPage::Remove(int index) {
  * Remove the only key & value pair in internal page and return the value
  * NOTE: only call this method within AdjustRoot()(in b_plus_tree.cpp)
  */
-page_id_t InternalPage::RemoveAndReturnOnlyChild() {
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
   assert(GetSize() == 1);
   IncreaseSize(-1);
   return ValueAt(0);
@@ -195,12 +211,14 @@ page_id_t InternalPage::RemoveAndReturnOnlyChild() {
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
  * pages that are moved to the recipient
  */
-void InternalPage::MoveAllTo(InternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, GenericKey *middle_key,
+                                   BufferPoolManager *buffer_pool_manager) {
   int old_size = GetSize();
   page_id_t parent_page_id = GetParentPageId();
   Page *parent_page = buffer_pool_manager->FetchPage(parent_page_id);
   assert(parent_page != nullptr);
-  auto *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  auto *parent_node = reinterpret_cast<BPlusTreeInternalPage *>(parent_page->GetData());
  
   SetKeyAt(0, middle_key);
   // recipient->SetKeyAt(recipient->GetSize(), middle_key);
@@ -230,8 +248,9 @@ void InternalPage::MoveAllTo(InternalPage *recipient, GenericKey *middle_key, Bu
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
  * pages that are moved to the recipient
  */
-void InternalPage::MoveFirstToEndOf(InternalPage *recipient, GenericKey *middle_key,
-                                    BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, GenericKey *middle_key,
+                                          BufferPoolManager *buffer_pool_manager) {
   int old_size = GetSize();
   // update children's parent page id
   page_id_t child_page_id = ValueAt(0);
@@ -261,7 +280,9 @@ void InternalPage::MoveFirstToEndOf(InternalPage *recipient, GenericKey *middle_
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
-void InternalPage::CopyLastFrom(GenericKey *key, const page_id_t value, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::CopyLastFrom(GenericKey *key, const page_id_t value,
+                                      BufferPoolManager *buffer_pool_manager) {
   int old_size = GetSize();
   IncreaseSize(1);
   SetKeyAt(old_size, key);
@@ -281,8 +302,9 @@ void InternalPage::CopyLastFrom(GenericKey *key, const page_id_t value, BufferPo
  * You also need to use BufferPoolManager to persist changes to the parent page id for those pages that are
  * moved to the recipient
  */
-void InternalPage::MoveLastToFrontOf(InternalPage *recipient, GenericKey *middle_key,
-                                     BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, GenericKey *middle_key,
+                                           BufferPoolManager *buffer_pool_manager) {
   int old_size = GetSize();
   // update children's parent page id
   page_id_t child_page_id = ValueAt(old_size - 1);
@@ -292,17 +314,17 @@ void InternalPage::MoveLastToFrontOf(InternalPage *recipient, GenericKey *middle
   child_node->SetParentPageId(recipient->GetPageId());
   buffer_pool_manager->UnpinPage(child_page_id, true);
 
-  // update parent's children
+  // move last pair to the front of recipient
+  recipient->CopyFirstFrom(ValueAt(old_size - 1), buffer_pool_manager);
+  recipient->SetKeyAt(1, middle_key);
+
+  // the last key now separates this page from the recipient, middle_key may point to the key it replaces
   page_id_t parent_page_id = GetParentPageId();
   Page *parent_page = buffer_pool_manager->FetchPage(parent_page_id);
   assert(parent_page != nullptr);
-  auto *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
-  parent_node->SetKeyAt(parent_node->ValueIndex(GetPageId()), KeyAt(old_size - 1));
+  auto *parent_node = reinterpret_cast<BPlusTreeInternalPage *>(parent_page->GetData());
+  parent_node->SetKeyAt(parent_node->ValueIndex(recipient->GetPageId()), KeyAt(old_size - 1));
   buffer_pool_manager->UnpinPage(parent_page_id, true);
-
-  // move last pair to the front of recipient
-  recipient->CopyFirstFrom(ValueAt(old_size - 1), buffer_pool_manager);
-  recipient->SetKeyAt(1, middle_key);
   Remove(old_size - 1);
 }
 
@@ -310,7 +332,8 @@ void InternalPage::MoveLastToFrontOf(InternalPage *recipient, GenericKey *middle
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
-void InternalPage::CopyFirstFrom(const page_id_t value, BufferPoolManager *buffer_pool_manager) {
+INDEX_TEMPLATE_ARGUMENTS
+void INTERNAL_PAGE_TYPE::CopyFirstFrom(const page_id_t value, BufferPoolManager *buffer_pool_manager) {
   int old_size = GetSize();
   IncreaseSize(1);
   memmove(PairPtrAt(1), PairPtrAt(0), old_size * pair_size);
@@ -321,4 +344,6 @@ void InternalPage::CopyFirstFrom(const page_id_t value, BufferPoolManager *buffe
   auto *child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
   child_node->SetParentPageId(GetPageId());
   buffer_pool_manager->UnpinPage(value, true);
-}
\ No newline at end of file
+}
+
+INSTANTIATE_B_PLUS_TREE(BPlusTreeInternalPage)
@@ -5,9 +5,10 @@
 #include "index/generic_key.h"
 
 #define pairs_off (data_)
-#define pair_size (GetKeySize() + sizeof(RowId))
+#define pair_size (GetKeyWidth() + sizeof(RowId))
 #define key_off 0
-#define val_off GetKeySize()
+#define val_off GetKeyWidth()
+#define LEAF_PAGE_TYPE BPlusTreeLeafPage<KeySize, KeyComparator>
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
  *****************************************************************************/
@@ -18,7 +19,8 @@
  * next page id and set max size
  * 未初始化next_page_id
  */
-void LeafPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
   SetPageType(IndexPageType::LEAF_PAGE);
   SetKeySize(key_size);
   SetSize(0);
@@ -31,11 +33,13 @@ void LeafPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int ma
 /**
  * Helper methods to set/get next page id
  */
-page_id_t LeafPage::GetNextPageId() const {
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t LEAF_PAGE_TYPE::GetNextPageId() const {
   return next_page_id_;
 }
 
-void LeafPage::SetNextPageId(page_id_t next_page_id) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
   next_page_id_ = next_page_id;
   if (next_page_id == 0) {
     LOG(INFO) << "Fatal error";
@@ -47,13 +51,14 @@ void LeafPage::SetNextPageId(page_id_t next_page_id) {
  * NOTE: This method is only used when generating index iterator
  * 二分查找
  */
-int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) {
+INDEX_TEMPLATE_ARGUMENTS
+int LEAF_PAGE_TYPE::KeyIndex(const GenericKey *key, const KeyComparator &comparator) {
   int l = 0, r = GetSize() - 1;
   while (l <= r) {
     int mid = (l + r) >> 1;
-    if (KM.CompareKeys(KeyAt(mid), key) > 0) {
+    if (comparator(KeyAt(mid), key) > 0) {
       r = mid - 1;
-    } else if (KM.CompareKeys(KeyAt(mid), key) < 0) {
+    } else if (comparator(KeyAt(mid), key) < 0) {
       l = mid + 1;
     } else {
       return mid;
@@ -66,35 +71,42 @@ int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) {
  * Helper method to find and return the key associated with input "index"(a.k.a
  * array offset)
  */
-GenericKey *LeafPage::KeyAt(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+GenericKey *LEAF_PAGE_TYPE::KeyAt(int index) {
   return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
 }
 
-void LeafPage::SetKeyAt(int index, GenericKey *key) {
-  memcpy(pairs_off + index * pair_size + key_off, key, GetKeySize());
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::SetKeyAt(int index, GenericKey *key) {
+  memcpy(pairs_off + index * pair_size + key_off, key, GetKeyWidth());
 }
 
-RowId LeafPage::ValueAt(int index) const {
+INDEX_TEMPLATE_ARGUMENTS
+RowId LEAF_PAGE_TYPE::ValueAt(int index) const {
   return *reinterpret_cast<const RowId *>(pairs_off + index * pair_size + val_off);
 }
 
-void LeafPage::SetValueAt(int index, RowId value) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::SetValueAt(int index, RowId value) {
   *reinterpret_cast<RowId *>(pairs_off + index * pair_size + val_off) = value;
 }
 
-void *LeafPage::PairPtrAt(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+void *LEAF_PAGE_TYPE::PairPtrAt(int index) {
   return KeyAt(index);
 }
 
-void LeafPage::PairCopy(void *dest, void *src, int pair_num) {
-  memcpy(dest, src, pair_num * (GetKeySize() + sizeof(RowId)));
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::PairCopy(void *dest, void *src, int pair_num) {
+  memcpy(dest, src, pair_num * pair_size);
 }
 
 /*
  * Helper method to find and return the key & value pair associated with input
  * "index"(a.k.a. array offset)
  */
-std::pair<GenericKey *, RowId> LeafPage::GetItem(int index) {
+INDEX_TEMPLATE_ARGUMENTS
+std::pair<GenericKey *, RowId> LEAF_PAGE_TYPE::GetItem(int index) {
   return std::make_pair(KeyAt(index), ValueAt(index));
 }
 
@@ -105,9 +117,10 @@ std::pair<GenericKey *, RowId> LeafPage::GetItem(int index) {
  * Insert key & value pair into leaf page ordered by key
  * @return page size after insertion
  */
-int LeafPage::Insert(GenericKey *key, const RowId &value, const KeyManager &KM) {
-  int index = KeyIndex(key, KM);
-  if (index < GetSize() && KM.CompareKeys(KeyAt(index), key) == 0) {  // key already exists
+INDEX_TEMPLATE_ARGUMENTS
+int LEAF_PAGE_TYPE::Insert(GenericKey *key, const RowId &value, const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && comparator(KeyAt(index), key) == 0) {  // key already exists
     LOG(WARNING) << "Duplicate key";
     return GetSize();
   }
@@ -124,7 +137,8 @@ int LeafPage::Insert(GenericKey *key, const RowId &value, const KeyManager &KM)
 /*
  * Remove half of key & value pairs from this page to "recipient" page
  */
-void LeafPage::MoveHalfTo(LeafPage *recipient) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
   int half = GetSize() >> 1;
   recipient->CopyNFrom(PairPtrAt(half), GetSize() - half);
   recipient->SetNextPageId(GetNextPageId());
@@ -135,7 +149,8 @@ void LeafPage::MoveHalfTo(LeafPage *recipient) {
 /*
  * Copy starting from items, and copy {size} number of elements into me.
  */
-void LeafPage::CopyNFrom(void *src, int size) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::CopyNFrom(void *src, int size) {
   PairCopy(PairPtrAt(GetSize()), src, size);
   IncreaseSize(size);
 }
@@ -148,9 +163,10 @@ void LeafPage::CopyNFrom(void *src, int size) {
  * does, then store its corresponding value in input "value" and return true.
  * If the key does not exist, then return false
  */
-bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM) {
-  int index = KeyIndex(key, KM);
-  if (index < GetSize() && KM.CompareKeys(KeyAt(index), key) == 0) {
+INDEX_TEMPLATE_ARGUMENTS
+bool LEAF_PAGE_TYPE::Lookup(const GenericKey *key, RowId &value, const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && comparator(KeyAt(index), key) == 0) {
     value = ValueAt(index);
     return true;
   }
@@ -166,9 +182,10 @@ bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM)
  * NOTE: store key&value pair continuously after deletion
  * @return  page size after deletion
  */
-int LeafPage::RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM) {
-  int index = KeyIndex(key, KM);
-  if (KM.CompareKeys(KeyAt(index), key) == 0) {
+INDEX_TEMPLATE_ARGUMENTS
+int LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const GenericKey *key, const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && comparator(KeyAt(index), key) == 0) {
     if (index < GetSize() - 1) {
       memmove(KeyAt(index), KeyAt(index + 1), (GetSize() - index - 1) * pair_size);
     } else {
@@ -186,7 +203,8 @@ int LeafPage::RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM)
  * Remove all key & value pairs from this page to "recipient" page. Don't forget
  * to update the next_page id in the sibling page
  */
-void LeafPage::MoveAllTo(LeafPage *recipient) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
   recipient->CopyNFrom(PairPtrAt(0), GetSize());
   recipient->SetNextPageId(GetNextPageId());
   SetSize(0);
@@ -199,7 +217,8 @@ void LeafPage::MoveAllTo(LeafPage *recipient) {
  * Remove the first key & value pair from this page to "recipient" page.
  *
  */
-void LeafPage::MoveFirstToEndOf(LeafPage *recipient) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
   // // update parent key
   // Page *parent = buffer_pool_manager->FetchPage(GetParentPageId());
   // assert(parent != nullptr);
@@ -215,7 +234,8 @@ void LeafPage::MoveFirstToEndOf(LeafPage *recipient) {
 /*
  * Copy the item into the end of my item list. (Append item to my array)
  */
-void LeafPage::CopyLastFrom(GenericKey *key, const RowId value) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::CopyLastFrom(GenericKey *key, const RowId value) {
   SetKeyAt(GetSize(), key);
   SetValueAt(GetSize(), value);
   IncreaseSize(1);
@@ -224,7 +244,8 @@ void LeafPage::CopyLastFrom(GenericKey *key, const RowId value) {
 /*
  * Remove the last key & value pair from this page to "recipient" page.
  */
-void LeafPage::MoveLastToFrontOf(LeafPage *recipient) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
   // // update parent key
   // Page *parent = buffer_pool_manager->FetchPage(GetParentPageId());
   // assert(parent != nullptr);
@@ -240,9 +261,12 @@ void LeafPage::MoveLastToFrontOf(LeafPage *recipient) {
  * Insert item at the front of my items. Move items accordingly.
  *
  */
-void LeafPage::CopyFirstFrom(GenericKey *key, const RowId value) {
+INDEX_TEMPLATE_ARGUMENTS
+void LEAF_PAGE_TYPE::CopyFirstFrom(GenericKey *key, const RowId value) {
   memmove(KeyAt(1), KeyAt(0), GetSize() * pair_size);
   SetKeyAt(0, key);
   SetValueAt(0, value);
   IncreaseSize(1);
-}
\ No newline at end of file
+}
+
+INSTANTIATE_B_PLUS_TREE(BPlusTreeLeafPage)
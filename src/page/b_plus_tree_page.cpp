@@ -9,6 +9,10 @@ bool BPlusTreePage::IsLeafPage() const {
   return page_type_ == IndexPageType::LEAF_PAGE;
 }
 
+bool BPlusTreePage::IsInternalPage() const {
+  return page_type_ == IndexPageType::INTERNAL_PAGE;
+}
+
 bool BPlusTreePage::IsRootPage() const {
   return parent_page_id_ == INVALID_PAGE_ID;
 }
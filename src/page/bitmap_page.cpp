@@ -1,5 +1,7 @@
 #include "page/bitmap_page.h"
 
+#include <algorithm>
+
 #include "glog/logging.h"
 
 template <size_t PageSize>
@@ -16,6 +18,34 @@ bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
     return true;
 }
 
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocatePageInRange(uint32_t begin, uint32_t end, uint32_t &page_offset) {
+    end = std::min<uint32_t>(end, GetMaxSupportedSize());
+    // every page before next_free_page_ is allocated
+    uint32_t offset = std::max(begin, next_free_page_);
+    while (offset < end) {
+        if (offset % 8 == 0 && bytes[offset / 8] == 0xff) {
+            offset += 8;
+            continue;
+        }
+        if (IsPageFreeLow(offset / 8, offset % 8)) {
+            break;
+        }
+        offset++;
+    }
+    if (offset >= end) {
+        return false;
+    }
+    bytes[offset / 8] |= (1 << (offset % 8));
+    page_offset = offset;
+    if (offset == next_free_page_) {
+        while (next_free_page_ < GetMaxSupportedSize() && !IsPageFree(next_free_page_)) {
+            next_free_page_++;
+        }
+    }
+    return true;
+}
+
 template <size_t PageSize>
 bool BitmapPage<PageSize>::DeAllocatePage(uint32_t page_offset) {
     if (page_offset >= GetMaxSupportedSize()) {
@@ -39,6 +69,33 @@ bool BitmapPage<PageSize>::IsPageFree(uint32_t page_offset) const {
     return IsPageFreeLow(page_offset / 8, page_offset % 8);
 }
 
+template <size_t PageSize>
+bool BitmapPage<PageSize>::IsRangeFree(uint32_t begin, uint32_t end) const {
+    for (uint32_t offset = begin; offset < end; offset++) {
+        if (offset % 8 == 0 && offset + 8 <= end && offset / 8 < MAX_CHARS) {
+            if (bytes[offset / 8] != 0) {
+                return false;
+            }
+            offset += 7;
+        } else if (!IsPageFree(offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <size_t PageSize>
+bool BitmapPage<PageSize>::GetLastAllocatedPage(uint32_t &page_offset) const {
+    for (uint32_t byte_index = MAX_CHARS; byte_index > 0; byte_index--) {
+        uint8_t byte = bytes[byte_index - 1];
+        if (byte != 0) {
+            page_offset = (byte_index - 1) * 8 + (31 - __builtin_clz(byte));
+            return true;
+        }
+    }
+    return false;
+}
+
 template <size_t PageSize>
 bool BitmapPage<PageSize>::IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const {
     if (byte_index >= MAX_CHARS || bit_index >= 8) {
@@ -12,9 +12,6 @@ bool TablePage::InsertTuple(Row &row, Schema *schema, Transaction *txn, LockMana
                             LogManager *log_manager) {
   uint32_t serialized_size = row.GetSerializedSize(schema);
   ASSERT(serialized_size > 0, "Can not have empty row.");
-  if (GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
-    return false;
-  }
   // Try to find a free slot to reuse.
   uint32_t i;
   for (i = 0; i < GetTupleCount(); i++) {
@@ -24,7 +21,8 @@ bool TablePage::InsertTuple(Row &row, Schema *schema, Transaction *txn, LockMana
       break;
     }
   }
-  if (i == GetTupleCount() && GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
+  // A reused slot takes no room, a new one takes SIZE_TUPLE bytes.
+  if (GetFreeSpaceRemaining() < serialized_size + (i == GetTupleCount() ? SIZE_TUPLE : 0)) {
     return false;
   }
   // Otherwise we claim available free space..
@@ -144,7 +142,7 @@ void TablePage::RollbackDelete(const RowId &rid, Transaction *txn, LogManager *l
   }
 }
 
-bool TablePage::GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager) {
+bool TablePage::GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager, Arena *arena) {
   ASSERT(row != nullptr && row->GetRowId().Get() != INVALID_ROWID.Get(), "Invalid row.");
   // Get the current slot number.
   uint32_t slot_num = row->GetRowId().GetSlotNum();
@@ -160,11 +158,20 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager
   }
   // At this point, we have at least a shared lock on the RID. Copy the tuple data into our result.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
-  uint32_t __attribute__((unused)) read_bytes = row->DeserializeFrom(GetData() + tuple_offset, schema);
+  uint32_t __attribute__((unused)) read_bytes = row->DeserializeFrom(GetData() + tuple_offset, schema, arena);
   ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
   return true;
 }
 
+bool TablePage::GetTupleView(const RowId &rid, const Schema *schema, RowView *view) {
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+    return false;
+  }
+  *view = RowView(GetData() + GetTupleOffsetAtSlot(slot_num), schema);
+  return true;
+}
+
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
@@ -190,3 +197,26 @@ bool TablePage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) {
   next_rid->Set(INVALID_PAGE_ID, 0);
   return false;
 }
+
+void TablePage::Compact() {
+  // tuples are copied from a snapshot of the page, so packing one never overwrites another that was not copied yet
+  char snapshot[PAGE_SIZE];
+  memcpy(snapshot, GetData(), PAGE_SIZE);
+  uint32_t free_space_pointer = PAGE_SIZE;
+  uint32_t tuple_count = 0;
+  for (uint32_t slot = 0; slot < GetTupleCount(); slot++) {
+    uint32_t tuple_size = GetTupleSize(slot);
+    if (IsDeleted(tuple_size)) {
+      SetTupleOffsetAtSlot(slot, 0);
+      SetTupleSize(slot, 0);
+      continue;
+    }
+    free_space_pointer -= tuple_size;
+    memcpy(GetData() + free_space_pointer, snapshot + GetTupleOffsetAtSlot(slot), tuple_size);
+    SetTupleOffsetAtSlot(slot, free_space_pointer);
+    tuple_count = slot + 1;
+  }
+  // the empty slots after the last tuple are given back, the others are reused by inserts
+  SetTupleCount(tuple_count);
+  SetFreeSpacePointer(free_space_pointer);
+}
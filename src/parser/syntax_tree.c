@@ -169,6 +169,10 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeVacuum:
+      return "kNodeVacuum";
+    case kNodeAnalyze:
+      return "kNodeAnalyze";
     default:
       return "error type";
   }
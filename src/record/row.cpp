@@ -1,86 +1,53 @@
 #include "record/row.h"
 
+#include "record/row_view.h"
+
 uint32_t Row::SerializeTo(char *buf, Schema *schema) const {
     ASSERT(schema != nullptr, "Invalid schema before serialize.");
     ASSERT(schema->GetColumnCount() == fields_.size(), "Fields size do not match schema's column size.");
     if (fields_.empty()) {
         return 0;
     }
-    uint32_t offset = 0;
-    // page_id_t page_id = rid_.GetPageId();
-    // uint32_t slot_num = rid_.GetSlotNum();
-    // MACH_WRITE_UINT32(buf + offset, page_id);
-    // offset += sizeof(page_id_t);
-    // MACH_WRITE_INT32(buf + offset, slot_num);
-    // offset += sizeof(uint32_t);
-
     // Field Nums
-    MACH_WRITE_UINT32(buf + offset, fields_.size());
-    offset += sizeof(uint32_t);
-
+    MACH_WRITE_UINT32(buf, static_cast<uint32_t>(fields_.size()) | FIXED_OFFSET_FORMAT);
     // Null bitmap
-    uint32_t nullBitmapSize = fields_.size() / 8 + (fields_.size() % 8 == 0 ? 0 : 1);
-    char *nullBitmap = new char[nullBitmapSize];
-    memset(nullBitmap, 0, nullBitmapSize);
+    char *null_bitmap = buf + sizeof(uint32_t);
+    memset(null_bitmap, 0, schema->GetNullBitmapSize());
+    uint32_t data_offset = schema->GetVariableDataOffset();
     for (uint32_t i = 0; i < fields_.size(); i++) {
-        if (fields_[i]->IsNull()) {
-            nullBitmap[i / 8] |= (1 << (i % 8));
+        const Field *field = &fields_[i];
+        TypeId type = schema->GetColumn(i)->GetType();
+        uint32_t offset = schema->GetFieldOffset(i);
+        if (field->IsNull()) {
+            null_bitmap[i / 8] |= (1 << (i % 8));
         }
-    }
-    memcpy(buf + offset, &nullBitmapSize, sizeof(uint32_t));
-    offset += sizeof(uint32_t);
-    memcpy(buf + offset, nullBitmap, nullBitmapSize);
-    offset += nullBitmapSize;
-    delete[] nullBitmap;
-
-    for (uint32_t i = 0; i < fields_.size(); i++) {
-        if (!fields_[i]->IsNull()) {
-            offset += fields_[i]->SerializeTo(buf + offset);
+        if (type == TypeId::kTypeChar) {
+            MACH_WRITE_UINT32(buf + offset, data_offset);
+            if (!field->IsNull()) {
+                memcpy(buf + data_offset, field->GetData(), field->GetLength());
+                data_offset += field->GetLength();
+            }
+        } else if (field->IsNull()) {
+            memset(buf + offset, 0, Type::GetTypeSize(type));
+        } else {
+            field->SerializeTo(buf + offset);
         }
     }
-    return offset;
+    if (schema->GetVariableFieldCount() > 0) {
+        MACH_WRITE_UINT32(buf + schema->GetVariableDataOffset() - sizeof(uint32_t), data_offset);
+    }
+    return data_offset;
 }
 
-uint32_t Row::DeserializeFrom(char *buf, Schema *schema) {
+uint32_t Row::DeserializeFrom(char *buf, Schema *schema, Arena *arena) {
     ASSERT(schema != nullptr, "Invalid schema before serialize.");
-    fields_.clear();
+    destroy();
     if (schema->GetColumnCount() == 0) {
         return 0;
     }
-    uint32_t offset = 0;
-    // page_id_t page_id;
-    // uint32_t slot_num;
-    // page_id = MACH_READ_UINT32(buf + offset);
-    // offset += sizeof(page_id_t);
-    // slot_num = MACH_READ_INT32(buf + offset);
-    // offset += sizeof(uint32_t);
-    // rid_ = RowId(page_id, slot_num);
-
-    // Field Nums
-    uint32_t fieldNums;
-    fieldNums = MACH_READ_UINT32(buf + offset);
-    offset += sizeof(uint32_t);
-
-    // Null bitmap
-    uint32_t nullBitmapSize;
-    nullBitmapSize = MACH_READ_UINT32(buf + offset);
-    offset += sizeof(uint32_t);
-    char *nullBitmap = new char[nullBitmapSize];
-    memcpy(nullBitmap, buf + offset, nullBitmapSize);
-    offset += nullBitmapSize;
-
-    for (uint32_t i = 0; i < fieldNums; i++) {
-        TypeId type = schema->GetColumn(i)->GetType();
-        if (nullBitmap[i / 8] & (1 << (i % 8))) {
-            fields_.push_back(new Field(type));
-        } else {
-            Field *field;
-            offset += field->DeserializeFrom(buf + offset, type, &field, false);
-            fields_.push_back(field);
-        }
-    }
-    delete[] nullBitmap;
-    return offset;
+    RowView view(buf, schema);
+    view.Materialize(this, arena);
+    return view.GetSerializedSize();
 }
 
 uint32_t Row::GetSerializedSize(Schema *schema) const {
@@ -89,33 +56,21 @@ uint32_t Row::GetSerializedSize(Schema *schema) const {
     if (fields_.empty()) {
         return 0;
     }
-    uint32_t size = 0;
-    // size += sizeof(page_id_t);
-    // size += sizeof(uint32_t);
-
-    // Field Nums
-    size += sizeof(uint32_t);
-
-    // Null bitmap
-    uint32_t nullBitmapSize = fields_.size() / 8 + (fields_.size() % 8 == 0 ? 0 : 1);
-    size += sizeof(uint32_t);
-    size += nullBitmapSize;
-
+    uint32_t size = schema->GetVariableDataOffset();
     for (uint32_t i = 0; i < fields_.size(); i++) {
-        if (!fields_[i]->IsNull()) {
-            size += fields_[i]->GetSerializedSize();
+        if (schema->GetColumn(i)->GetType() == TypeId::kTypeChar && !fields_[i].IsNull()) {
+            size += fields_[i].GetLength();
         }
     }
     return size;
 }
 
 void Row::GetKeyFromRow(const Schema *schema, const Schema *key_schema, Row &key_row) {
-    auto columns = key_schema->GetColumns();
-    std::vector<Field> fields;
+    key_row.rid_ = RowId();
+    key_row.fields_.clear();
     uint32_t idx;
-    for (auto column : columns) {
+    for (auto column : key_schema->GetColumns()) {
         schema->GetColumnIndex(column->GetName(), idx);
-        fields.emplace_back(*this->GetField(idx));
+        key_row.fields_.emplace_back(fields_[idx]);
     }
-    key_row = Row(fields);
 }
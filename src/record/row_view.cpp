@@ -0,0 +1,150 @@
+#include "record/row_view.h"
+
+bool RowView::IsNull(uint32_t idx) const {
+    ASSERT(idx < GetFieldCount(), "Failed to access field");
+    return GetNullBitmap()[idx / 8] & (1 << (idx % 8));
+}
+
+const char *RowView::GetFieldData(uint32_t idx, uint32_t *len) const {
+    TypeId type = schema_->GetColumn(idx)->GetType();
+    if (!fixed_offset_) {
+        const char *field_data = GetLegacyFieldData(idx);
+        if (type == TypeId::kTypeChar) {
+            *len = MACH_READ_UINT32(field_data);
+            return field_data + sizeof(uint32_t);
+        }
+        *len = Type::GetTypeSize(type);
+        return field_data;
+    }
+    uint32_t offset = schema_->GetFieldOffset(idx);
+    if (type == TypeId::kTypeChar) {
+        // the entry after this one holds the start of the next CHAR field, or the end of the last one
+        uint32_t start = MACH_READ_UINT32(data_ + offset);
+        *len = MACH_READ_UINT32(data_ + offset + sizeof(uint32_t)) - start;
+        return data_ + start;
+    }
+    *len = Type::GetTypeSize(type);
+    return data_ + offset;
+}
+
+const char *RowView::GetLegacyFieldData(uint32_t idx) const {
+    uint32_t null_bitmap_size = MACH_READ_UINT32(data_ + sizeof(uint32_t));
+    const char *field_data = GetNullBitmap() + null_bitmap_size;
+    // only non-null fields are stored, skip the ones before idx
+    for (uint32_t i = 0; i < idx; i++) {
+        if (IsNull(i)) {
+            continue;
+        }
+        TypeId type = schema_->GetColumn(i)->GetType();
+        if (type == TypeId::kTypeChar) {
+            field_data += sizeof(uint32_t) + MACH_READ_UINT32(field_data);
+        } else {
+            field_data += Type::GetTypeSize(type);
+        }
+    }
+    return field_data;
+}
+
+Field RowView::GetField(uint32_t idx) const {
+    TypeId type = schema_->GetColumn(idx)->GetType();
+    if (IsNull(idx)) {
+        return Field(type);
+    }
+    uint32_t len;
+    const char *field_data = GetFieldData(idx, &len);
+    switch (type) {
+        case TypeId::kTypeInt:
+            return Field(type, MACH_READ_FROM(int32_t, field_data));
+        case TypeId::kTypeFloat:
+            return Field(type, MACH_READ_FROM(float_t, field_data));
+        case TypeId::kTypeChar:
+            return Field(type, const_cast<char *>(field_data), len, false);
+        default:
+            ASSERT(false, "Unsupported field type.");
+            return Field(type);
+    }
+}
+
+void RowView::AppendField(uint32_t idx, Row::FieldList *fields, Arena *arena) const {
+    TypeId type = schema_->GetColumn(idx)->GetType();
+    if (IsNull(idx)) {
+        fields->emplace_back(type);
+        return;
+    }
+    uint32_t len;
+    const char *field_data = GetFieldData(idx, &len);
+    switch (type) {
+        case TypeId::kTypeInt:
+            fields->emplace_back(type, MACH_READ_FROM(int32_t, field_data));
+            break;
+        case TypeId::kTypeFloat:
+            fields->emplace_back(type, MACH_READ_FROM(float_t, field_data));
+            break;
+        case TypeId::kTypeChar:
+            AppendChars(field_data, len, fields, arena);
+            break;
+        default:
+            ASSERT(false, "Unsupported field type.");
+    }
+}
+
+void RowView::AppendChars(const char *data, uint32_t len, Row::FieldList *fields, Arena *arena) {
+    if (arena == nullptr || len <= FIELD_INLINE_LEN) {
+        fields->emplace_back(TypeId::kTypeChar, const_cast<char *>(data), len, true);
+        return;
+    }
+    char *copy = arena->Allocate(len, 1);
+    memcpy(copy, data, len);
+    fields->emplace_back(TypeId::kTypeChar, copy, len, false);
+}
+
+uint32_t RowView::GetSerializedSize() const {
+    if (GetFieldCount() == 0) {
+        return 0;
+    }
+    if (!fixed_offset_) {
+        return GetLegacyFieldData(GetFieldCount()) - data_;
+    }
+    if (schema_->GetVariableFieldCount() == 0) {
+        return schema_->GetVariableDataOffset();
+    }
+    return MACH_READ_UINT32(data_ + schema_->GetVariableDataOffset() - sizeof(uint32_t));
+}
+
+void RowView::Materialize(Row *row, Arena *arena) const {
+    auto &fields = row->GetFields();
+    fields.clear();
+    if (fixed_offset_) {
+        for (uint32_t i = 0; i < GetFieldCount(); i++) {
+            AppendField(i, &fields, arena);
+        }
+        return;
+    }
+    // a legacy row is read in one pass
+    const char *field_data = GetLegacyFieldData(0);
+    for (uint32_t i = 0; i < GetFieldCount(); i++) {
+        TypeId type = schema_->GetColumn(i)->GetType();
+        if (IsNull(i)) {
+            fields.emplace_back(type);
+        } else if (type == TypeId::kTypeChar) {
+            uint32_t len = MACH_READ_UINT32(field_data);
+            AppendChars(field_data + sizeof(uint32_t), len, &fields, arena);
+            field_data += sizeof(uint32_t) + len;
+        } else {
+            if (type == TypeId::kTypeInt) {
+                fields.emplace_back(type, MACH_READ_FROM(int32_t, field_data));
+            } else {
+                fields.emplace_back(type, MACH_READ_FROM(float_t, field_data));
+            }
+            field_data += Type::GetTypeSize(type);
+        }
+    }
+}
+
+void RowView::Materialize(const std::vector<uint32_t> &columns, Row *row, Arena *arena) const {
+    auto &fields = row->GetFields();
+    fields.clear();
+    for (auto idx : columns) {
+        AppendField(idx, &fields, arena);
+    }
+}
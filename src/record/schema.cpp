@@ -44,4 +44,33 @@ uint32_t Schema::DeserializeFrom(char *buf, Schema *&schema) {
     offset += sizeof(uint32_t);
     schema = new Schema(columns, isManage);
     return offset;
-}
\ No newline at end of file
+}
+
+void Schema::ComputeLayout() {
+    uint32_t column_count = GetColumnCount();
+    null_bitmap_size_ = column_count / 8 + (column_count % 8 == 0 ? 0 : 1);
+    // fixed-width values go right after the header, in column order
+    uint32_t offset = sizeof(uint32_t) + null_bitmap_size_;
+    field_offsets_.resize(column_count);
+    variable_field_count_ = 0;
+    for (uint32_t i = 0; i < column_count; i++) {
+        TypeId type = columns_[i]->GetType();
+        if (type == TypeId::kTypeChar) {
+            variable_field_count_++;
+        } else {
+            field_offsets_[i] = offset;
+            offset += Type::GetTypeSize(type);
+        }
+    }
+    // then one start offset per CHAR column plus the end of the last one
+    for (uint32_t i = 0; i < column_count; i++) {
+        if (columns_[i]->GetType() == TypeId::kTypeChar) {
+            field_offsets_[i] = offset;
+            offset += sizeof(uint32_t);
+        }
+    }
+    if (variable_field_count_ > 0) {
+        offset += sizeof(uint32_t);
+    }
+    variable_data_offset_ = offset;
+}
@@ -1,37 +1,61 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
+#include <linux/falloc.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
 #include <filesystem>
 #include <stdexcept>
 
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+static inline bool IsPageAligned(const char *page_data) {
+    return reinterpret_cast<uintptr_t>(page_data) % PAGE_SIZE == 0;
+}
+
+DiskManager::DiskManager(const std::string &db_file, bool use_io_uring, bool direct_io) : file_name_(db_file) {
     std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    // directory or file does not exist
-    if (!db_io_.is_open()) {
-        db_io_.clear();
-        // create a new file
-        std::filesystem::path p = db_file;
-        if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-        db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-        db_io_.close();
-        // reopen with original mode
-        db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-        if (!db_io_.is_open()) {
-            throw std::exception();
+    // directory does not exist
+    std::filesystem::path p = db_file;
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+    // open the file, create it if it does not exist
+    if (direct_io) {
+        db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+        if (db_fd_ < 0 && errno == EINVAL) {
+            LOG(WARNING) << "The file system of " << db_file << " does not support O_DIRECT, using buffered I/O.";
         }
+        direct_io_ = db_fd_ >= 0;
+    }
+    if (db_fd_ < 0) {
+        db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
     }
+    if (db_fd_ < 0) {
+        LOG(ERROR) << "Cannot open db file " << db_file << ": " << strerror(errno);
+        throw std::exception();
+    }
+    file_size_ = GetFileSize(file_name_);
     ReadPhysicalPage(META_PAGE_ID, meta_data_);
+    if (use_io_uring) {
+        io_uring_ = std::make_unique<IOUring>(IO_URING_QUEUE_DEPTH);
+        if (!io_uring_->IsValid()) {
+            io_uring_.reset();
+        }
+    }
 }
 
 void DiskManager::Close() {
     std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-    WritePhysicalPage(META_PAGE_ID, meta_data_);
     if (!closed) {
-        db_io_.close();
+        // waits for the requests still in flight
+        io_uring_.reset();
+        // the meta page is written even if nothing was allocated, so a new file always has one
+        meta_dirty_ = true;
+        FlushMetadata();
+        close(db_fd_);
+        db_fd_ = -1;
         closed = true;
     }
 }
@@ -46,80 +70,268 @@ void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
     WritePhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
-page_id_t DiskManager::AllocatePage() {
-    page_id_t logical_page_id = INVALID_PAGE_ID;
-    for (page_id_t i = 0; i < reinterpret_cast<DiskFileMetaPage *>(meta_data_)->GetExtentNums(); i++) {
-        if (reinterpret_cast<DiskFileMetaPage *>(meta_data_)->GetExtentUsedPage(i) < BITMAP_SIZE) {
-            logical_page_id = i * BITMAP_SIZE + reinterpret_cast<DiskFileMetaPage *>(meta_data_)->GetExtentUsedPage(i);
-            break;
-        }
+IOHandle DiskManager::ReadPageAsync(page_id_t logical_page_id, char *page_data) {
+    ASSERT(logical_page_id >= 0, "Invalid page id.");
+    size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+    if (io_uring_ == nullptr || offset >= file_size_.load() || (direct_io_ && !IsPageAligned(page_data))) {
+        ReadPage(logical_page_id, page_data);
+        return IOHandle();
+    }
+    return io_uring_->Prepare(true, db_fd_, page_data, PAGE_SIZE, offset);
+}
+
+IOHandle DiskManager::WritePageAsync(page_id_t logical_page_id, const char *page_data) {
+    ASSERT(logical_page_id >= 0, "Invalid page id.");
+    if (io_uring_ == nullptr || (direct_io_ && !IsPageAligned(page_data))) {
+        WritePage(logical_page_id, page_data);
+        return IOHandle();
     }
-    if (logical_page_id == INVALID_PAGE_ID) {
-        // no free page, allocate a new extent
-        page_id_t extent_id = reinterpret_cast<DiskFileMetaPage *>(meta_data_)->GetExtentNums();
+    size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+    IOHandle handle = io_uring_->Prepare(false, db_fd_, const_cast<char *>(page_data), PAGE_SIZE, offset);
+    GrowFileSize(offset + PAGE_SIZE);
+    return handle;
+}
 
-        reinterpret_cast<DiskFileMetaPage *>(meta_data_)->num_extents_++;
-        reinterpret_cast<DiskFileMetaPage *>(meta_data_)->extent_used_page_[extent_id] = 0;
+void DiskManager::SubmitAsync() {
+    if (io_uring_ != nullptr) {
+        io_uring_->Submit();
+    }
+}
 
-        char bitmap_page[PAGE_SIZE];
-        memset(bitmap_page, 0, PAGE_SIZE);
-        uint32_t page_offset;
-        if (reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_page)->AllocatePage(page_offset)) {
-            reinterpret_cast<DiskFileMetaPage *>(meta_data_)->num_allocated_pages_++;
-            reinterpret_cast<DiskFileMetaPage *>(meta_data_)->extent_used_page_[extent_id]++;
-            logical_page_id = extent_id * BITMAP_SIZE + page_offset;
-            page_id_t bitmap_physical_page_id = extent_id * (BITMAP_SIZE + 1) + 1;
-            WritePhysicalPage(META_PAGE_ID, meta_data_);
-            WritePhysicalPage(bitmap_physical_page_id, bitmap_page);
-        } else {
-            LOG(ERROR) << "Allocate page failed.";
+page_id_t DiskManager::AllocatePage(page_id_t hint) {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    if (hint != INVALID_PAGE_ID && reserve_pages_) {
+        // continue in the hint's reservation, right after the hint if possible
+        page_id_t range = hint / PAGE_RESERVATION_SIZE;
+        if (reserved_ranges_.count(range) > 0) {
+            uint32_t extent_id = hint / BITMAP_SIZE;
+            uint32_t begin = range * PAGE_RESERVATION_SIZE % BITMAP_SIZE;
+            uint32_t offset = hint % BITMAP_SIZE;
+            page_id_t logical_page_id =
+                AllocatePageInExtent(extent_id, offset + 1, begin + PAGE_RESERVATION_SIZE, false);
+            if (logical_page_id == INVALID_PAGE_ID) {
+                logical_page_id = AllocatePageInExtent(extent_id, begin, offset, false);
+            }
+            if (logical_page_id != INVALID_PAGE_ID) {
+                return logical_page_id;
+            }
         }
+        // the reservation is full, reserve the next range so the owner's pages still follow each other
+        range = ReserveRange(range + 1);
+        if (range != INVALID_PAGE_ID) {
+            uint32_t begin = range * PAGE_RESERVATION_SIZE % BITMAP_SIZE;
+            return AllocatePageInExtent(range * PAGE_RESERVATION_SIZE / BITMAP_SIZE, begin,
+                                        begin + PAGE_RESERVATION_SIZE, false);
+        }
+    }
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    for (uint32_t extent_id = 0; extent_id <= meta_page->GetExtentNums(); extent_id++) {
+        if (meta_page->GetExtentUsedPage(extent_id) < BITMAP_SIZE) {
+            page_id_t logical_page_id = AllocatePageInExtent(extent_id, 0, BITMAP_SIZE, reserve_pages_);
+            if (logical_page_id != INVALID_PAGE_ID) {
+                return logical_page_id;
+            }
+        }
+    }
+    LOG(ERROR) << "Allocate page failed.";
+    return INVALID_PAGE_ID;
+}
+
+page_id_t DiskManager::AllocatePageInExtent(uint32_t extent_id, uint32_t begin, uint32_t end, bool skip_reserved) {
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    if (extent_id > meta_page->GetExtentNums() ||
+        (extent_id + 1) * BITMAP_SIZE > static_cast<size_t>(MAX_VALID_PAGE_ID)) {
+        return INVALID_PAGE_ID;
+    }
+    // the bitmap of the next extent is created zeroed, the extent only counts once a page of it is allocated
+    BitmapPage<PAGE_SIZE> *bitmap = GetBitmap(extent_id);
+    uint32_t page_offset;
+    bool allocated = false;
+    if (!skip_reserved) {
+        allocated = bitmap->AllocatePageInRange(begin, end, page_offset);
     } else {
-        // allocate a new page in an existing extent
-        page_id_t physical_page_id = MapPageId(logical_page_id);
-        page_id_t bitmap_id = (physical_page_id - 1) / (BITMAP_SIZE + 1);
-        page_id_t bitmap_physical_page_id = bitmap_id * (BITMAP_SIZE + 1) + 1;
-        uint32_t page_offset;
-        char bitmap_page[PAGE_SIZE];
-        ReadPhysicalPage(bitmap_physical_page_id, bitmap_page);
-        reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_page)->AllocatePage(page_offset);
-        reinterpret_cast<DiskFileMetaPage *>(meta_data_)->num_allocated_pages_++;
-        reinterpret_cast<DiskFileMetaPage *>(meta_data_)->extent_used_page_[bitmap_id]++;
-        WritePhysicalPage(bitmap_physical_page_id, bitmap_page);
-        WritePhysicalPage(META_PAGE_ID, meta_data_);
-        physical_page_id = bitmap_physical_page_id + page_offset + 1;
-        // convert to logical id
-        page_id_t index = (physical_page_id - 1) / (BITMAP_SIZE + 1);
-        page_id_t offset = (physical_page_id - 1) % (BITMAP_SIZE + 1) - 1;
-        logical_page_id = index * BITMAP_SIZE + offset;
+        // go through the range one reservation at a time from the first free page, leaving out the reserved ones
+        page_id_t first_range = extent_id * (BITMAP_SIZE / PAGE_RESERVATION_SIZE);
+        begin = std::max(begin, bitmap->GetNextFreePage());
+        for (uint32_t range_begin = begin - begin % PAGE_RESERVATION_SIZE; !allocated && range_begin < end;
+             range_begin += PAGE_RESERVATION_SIZE) {
+            if (reserved_ranges_.count(first_range + range_begin / PAGE_RESERVATION_SIZE) == 0) {
+                allocated = bitmap->AllocatePageInRange(std::max(begin, range_begin),
+                                                        std::min<uint32_t>(end, range_begin + PAGE_RESERVATION_SIZE),
+                                                        page_offset);
+            }
+        }
+    }
+    if (!allocated) {
+        return INVALID_PAGE_ID;
+    }
+    if (extent_id == meta_page->GetExtentNums()) {
+        meta_page->num_extents_++;
+        meta_page->extent_used_page_[extent_id] = 0;
+    }
+    meta_page->num_allocated_pages_++;
+    meta_page->extent_used_page_[extent_id]++;
+    bitmap_dirty_[extent_id] = true;
+    meta_dirty_ = true;
+    return extent_id * BITMAP_SIZE + page_offset;
+}
+
+page_id_t DiskManager::ReserveRange(page_id_t preferred) {
+    static_assert(BITMAP_SIZE % PAGE_RESERVATION_SIZE == 0, "a reservation must not cross extents");
+    constexpr uint32_t ranges_per_extent = BITMAP_SIZE / PAGE_RESERVATION_SIZE;
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    auto is_free = [&](page_id_t range) {
+        uint32_t extent_id = range / ranges_per_extent;
+        if (reserved_ranges_.count(range) > 0 || extent_id > meta_page->GetExtentNums() ||
+            (extent_id + 1) * BITMAP_SIZE > static_cast<size_t>(MAX_VALID_PAGE_ID)) {
+            return false;
+        }
+        // the pages of an extent that is not created yet are all free
+        if (extent_id == meta_page->GetExtentNums()) {
+            return true;
+        }
+        uint32_t begin = range % ranges_per_extent * PAGE_RESERVATION_SIZE;
+        return GetBitmap(extent_id)->IsRangeFree(begin, begin + PAGE_RESERVATION_SIZE);
+    };
+    if (is_free(preferred)) {
+        reserved_ranges_.insert(preferred);
+        return preferred;
+    }
+    for (uint32_t extent_id = 0; extent_id <= meta_page->GetExtentNums(); extent_id++) {
+        if (meta_page->GetExtentUsedPage(extent_id) + PAGE_RESERVATION_SIZE > BITMAP_SIZE) {
+            continue;
+        }
+        for (uint32_t range = extent_id * ranges_per_extent; range < (extent_id + 1) * ranges_per_extent; range++) {
+            if (is_free(range)) {
+                reserved_ranges_.insert(range);
+                return range;
+            }
+        }
+    }
+    return INVALID_PAGE_ID;
+}
+
+void DiskManager::SetPageReservation(bool enable) {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    reserve_pages_ = enable;
+    if (!enable) {
+        reserved_ranges_.clear();
     }
-    return logical_page_id;
 }
 
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
     ASSERT(logical_page_id >= 0, "Invalid page id.");
-    page_id_t physical_page_id = MapPageId(logical_page_id);
-    page_id_t bitmap_id = (physical_page_id - 1) / (BITMAP_SIZE + 1);
-    page_id_t bitmap_physical_page_id = bitmap_id * (BITMAP_SIZE + 1) + 1;
-    page_id_t offset = (physical_page_id - 1) % (BITMAP_SIZE + 1) - 1;
-    char bitmap_page[PAGE_SIZE];
-    ReadPhysicalPage(bitmap_physical_page_id, bitmap_page);
-    reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_page)->DeAllocatePage(offset);
-    reinterpret_cast<DiskFileMetaPage *>(meta_data_)->num_allocated_pages_--;
-    reinterpret_cast<DiskFileMetaPage *>(meta_data_)->extent_used_page_[bitmap_id]--;
-    WritePhysicalPage(bitmap_physical_page_id, bitmap_page);
-    WritePhysicalPage(META_PAGE_ID, meta_data_);
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+    uint32_t offset = logical_page_id % BITMAP_SIZE;
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    if (extent_id >= meta_page->GetExtentNums() || !GetBitmap(extent_id)->DeAllocatePage(offset)) {
+        return;
+    }
+    meta_page->num_allocated_pages_--;
+    meta_page->extent_used_page_[extent_id]--;
+    bitmap_dirty_[extent_id] = true;
+    meta_dirty_ = true;
+    // an empty range goes back to plain allocations, and its space to the file system on the next flush
+    page_id_t range = logical_page_id / PAGE_RESERVATION_SIZE;
+    uint32_t range_begin = offset - offset % PAGE_RESERVATION_SIZE;
+    if (GetBitmap(extent_id)->IsRangeFree(range_begin, range_begin + PAGE_RESERVATION_SIZE)) {
+        reserved_ranges_.erase(range);
+        free_ranges_.insert(range);
+    }
 }
 
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
     ASSERT(logical_page_id >= 0, "Invalid page id.");
-    page_id_t physical_page_id = MapPageId(logical_page_id);
-    page_id_t bitmap_page_id = physical_page_id / (BITMAP_SIZE + 1);
-    page_id_t bitmap_physical_page_id = bitmap_page_id * (BITMAP_SIZE + 1) + 1;
-    page_id_t offset = (physical_page_id - 1) % (BITMAP_SIZE + 1) - 1;
-    char bitmap_page[PAGE_SIZE];
-    ReadPhysicalPage(bitmap_physical_page_id, bitmap_page);
-    return reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_page)->IsPageFree(offset);
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+    if (extent_id >= reinterpret_cast<DiskFileMetaPage *>(meta_data_)->GetExtentNums()) {
+        return true;
+    }
+    return GetBitmap(extent_id)->IsPageFree(logical_page_id % BITMAP_SIZE);
+}
+
+void DiskManager::FlushMetadata() {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    // empty extents at the end of the file are dropped, their bitmaps are not written again
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    uint32_t num_extents = meta_page->GetExtentNums();
+    while (num_extents > 0 && meta_page->GetExtentUsedPage(num_extents - 1) == 0) {
+        num_extents--;
+    }
+    if (num_extents < meta_page->GetExtentNums()) {
+        meta_page->num_extents_ = num_extents;
+        bitmaps_.resize(std::min<size_t>(bitmaps_.size(), num_extents));
+        bitmap_dirty_.resize(bitmaps_.size());
+        meta_dirty_ = true;
+    }
+    // bitmaps first, a meta page on disk never counts pages its bitmaps do not have
+    for (uint32_t extent_id = 0; extent_id < bitmaps_.size(); extent_id++) {
+        if (bitmap_dirty_[extent_id]) {
+            WritePhysicalPage(extent_id * (BITMAP_SIZE + 1) + 1, reinterpret_cast<char *>(bitmaps_[extent_id].get()));
+            bitmap_dirty_[extent_id] = false;
+        }
+    }
+    if (meta_dirty_) {
+        WritePhysicalPage(META_PAGE_ID, meta_data_);
+        meta_dirty_ = false;
+    }
+    ReleaseFreeSpace();
+}
+
+void DiskManager::ReleaseFreeSpace() {
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    uint32_t num_extents = meta_page->GetExtentNums();
+    // the file ends with the last allocated page, or with the meta page if there is none
+    size_t file_end = PAGE_SIZE;
+    uint32_t last_offset;
+    if (num_extents > 0 && GetBitmap(num_extents - 1)->GetLastAllocatedPage(last_offset)) {
+        file_end = (static_cast<size_t>(MapPageId((num_extents - 1) * BITMAP_SIZE + last_offset)) + 1) * PAGE_SIZE;
+    }
+    if (file_end < file_size_.load()) {
+        if (ftruncate(db_fd_, static_cast<off_t>(file_end)) == 0) {
+            file_size_ = file_end;
+        } else {
+            LOG(WARNING) << "Cannot truncate db file " << file_name_ << ": " << strerror(errno);
+        }
+    }
+    for (page_id_t range : free_ranges_) {
+        if (!punch_holes_) {
+            break;
+        }
+        // the range may have been allocated again since it was freed
+        uint32_t extent_id = range * PAGE_RESERVATION_SIZE / BITMAP_SIZE;
+        uint32_t begin = range * PAGE_RESERVATION_SIZE % BITMAP_SIZE;
+        size_t offset = static_cast<size_t>(MapPageId(range * PAGE_RESERVATION_SIZE)) * PAGE_SIZE;
+        if (extent_id >= num_extents || offset >= file_size_.load() ||
+            !GetBitmap(extent_id)->IsRangeFree(begin, begin + PAGE_RESERVATION_SIZE)) {
+            continue;
+        }
+        if (fallocate(db_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+                      static_cast<off_t>(PAGE_RESERVATION_SIZE) * PAGE_SIZE) != 0) {
+            if (errno == EOPNOTSUPP) {
+                LOG(WARNING) << "The file system of " << file_name_ << " does not support hole punching.";
+                punch_holes_ = false;
+            } else {
+                LOG(WARNING) << "Cannot punch a hole in db file " << file_name_ << ": " << strerror(errno);
+            }
+        }
+    }
+    free_ranges_.clear();
+}
+
+BitmapPage<PAGE_SIZE> *DiskManager::GetBitmap(uint32_t extent_id) {
+    if (extent_id >= bitmaps_.size()) {
+        bitmaps_.resize(extent_id + 1);
+        bitmap_dirty_.resize(extent_id + 1, false);
+    }
+    if (bitmaps_[extent_id] == nullptr) {
+        bitmaps_[extent_id] = std::make_unique<BitmapPage<PAGE_SIZE>>();
+        if (extent_id < reinterpret_cast<DiskFileMetaPage *>(meta_data_)->GetExtentNums()) {
+            ReadPhysicalPage(extent_id * (BITMAP_SIZE + 1) + 1, reinterpret_cast<char *>(bitmaps_[extent_id].get()));
+        }
+    }
+    return bitmaps_[extent_id].get();
 }
 
 page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
@@ -128,45 +340,79 @@ page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
     return index * (BITMAP_SIZE + 1) + offset + 2;
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
+size_t DiskManager::GetFileSize(const std::string &file_name) {
     struct stat stat_buf;
     int rc = stat(file_name.c_str(), &stat_buf);
-    return rc == 0 ? stat_buf.st_size : -1;
+    return rc == 0 ? stat_buf.st_size : 0;
 }
 
 void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-    int offset = physical_page_id * PAGE_SIZE;
+    size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
     // check if read beyond file length
-    if (offset >= GetFileSize(file_name_)) {
+    if (offset >= file_size_.load()) {
 #ifdef ENABLE_BPM_DEBUG
         LOG(INFO) << "Read less than a page" << std::endl;
 #endif
         memset(page_data, 0, PAGE_SIZE);
-    } else {
-        // set read cursor to offset
-        db_io_.seekp(offset);
-        db_io_.read(page_data, PAGE_SIZE);
-        // if file ends before reading PAGE_SIZE
-        int read_count = db_io_.gcount();
-        if (read_count < PAGE_SIZE) {
+        return;
+    }
+    if (direct_io_ && !IsPageAligned(page_data)) {
+        alignas(PAGE_SIZE) char bounce[PAGE_SIZE];
+        ReadPhysicalPage(physical_page_id, bounce);
+        memcpy(page_data, bounce, PAGE_SIZE);
+        return;
+    }
+    size_t read_count = 0;
+    while (read_count < PAGE_SIZE) {
+        ssize_t rc = pread(db_fd_, page_data + read_count, PAGE_SIZE - read_count, offset + read_count);
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc < 0) {
+            LOG(ERROR) << "I/O error while reading: " << strerror(errno);
+            break;
+        }
+        if (rc == 0) {
+            break;
+        }
+        read_count += rc;
+    }
+    // if file ends before reading PAGE_SIZE
+    if (read_count < PAGE_SIZE) {
 #ifdef ENABLE_BPM_DEBUG
-            LOG(INFO) << "Read less than a page" << std::endl;
+        LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-            memset(page_data + read_count, 0, PAGE_SIZE - read_count);
-        }
+        memset(page_data + read_count, 0, PAGE_SIZE - read_count);
     }
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
-    size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-    // set write cursor to offset
-    db_io_.seekp(offset);
-    db_io_.write(page_data, PAGE_SIZE);
-    // check for I/O error
-    if (db_io_.bad()) {
-        LOG(ERROR) << "I/O error while writing";
+    if (direct_io_ && !IsPageAligned(page_data)) {
+        alignas(PAGE_SIZE) char bounce[PAGE_SIZE];
+        memcpy(bounce, page_data, PAGE_SIZE);
+        WritePhysicalPage(physical_page_id, bounce);
         return;
     }
-    // needs to flush to keep disk file in sync
-    db_io_.flush();
-}
\ No newline at end of file
+    size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
+    size_t write_count = 0;
+    while (write_count < PAGE_SIZE) {
+        ssize_t rc = pwrite(db_fd_, page_data + write_count, PAGE_SIZE - write_count, offset + write_count);
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        // check for I/O error
+        if (rc < 0) {
+            LOG(ERROR) << "I/O error while writing: " << strerror(errno);
+            return;
+        }
+        write_count += rc;
+    }
+    // the file grows when writing past its end
+    GrowFileSize(offset + PAGE_SIZE);
+}
+
+void DiskManager::GrowFileSize(size_t end) {
+    size_t size = file_size_.load();
+    while (size < end && !file_size_.compare_exchange_weak(size, end)) {
+    }
+}
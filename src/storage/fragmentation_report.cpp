@@ -0,0 +1,81 @@
+#include "storage/fragmentation_report.h"
+
+#include "page/b_plus_tree_internal_page.h"
+#include "page/b_plus_tree_leaf_page.h"
+#include "page/table_page.h"
+
+FragmentationReport FragmentationReport::FromPageIds(const std::vector<page_id_t> &page_ids) {
+    FragmentationReport report;
+    report.pages_ = page_ids.size();
+    for (size_t i = 0; i < page_ids.size(); i++) {
+        // logical ids are contiguous on disk, except for the bitmap page between two extents
+        if (i > 0 && page_ids[i] == page_ids[i - 1] + 1) {
+            continue;
+        }
+        report.runs_++;
+        if (i > 0) {
+            if (page_ids[i] < page_ids[i - 1]) {
+                report.backward_jumps_++;
+                report.jump_distance_ += page_ids[i - 1] - page_ids[i];
+            } else {
+                report.jump_distance_ += page_ids[i] - page_ids[i - 1];
+            }
+        }
+    }
+    return report;
+}
+
+std::vector<page_id_t> FragmentationReport::TableHeapPageIds(BufferPoolManager *buffer_pool_manager,
+                                                             page_id_t first_page_id) {
+    std::vector<page_id_t> page_ids;
+    page_id_t page_id = first_page_id;
+    while (page_id != INVALID_PAGE_ID) {
+        auto page = reinterpret_cast<TablePage *>(buffer_pool_manager->FetchPage(page_id));
+        if (page == nullptr) {
+            break;
+        }
+        page_ids.push_back(page_id);
+        page_id_t next_page_id = page->GetNextPageId();
+        buffer_pool_manager->UnpinPage(page_id, false);
+        page_id = next_page_id;
+    }
+    return page_ids;
+}
+
+std::vector<page_id_t> FragmentationReport::LeafPageIds(BufferPoolManager *buffer_pool_manager,
+                                                        page_id_t root_page_id) {
+    std::vector<page_id_t> page_ids;
+    // go down the leftmost path, then follow the leaf chain
+    page_id_t page_id = root_page_id;
+    while (page_id != INVALID_PAGE_ID) {
+        auto page = buffer_pool_manager->FetchPage(page_id);
+        if (page == nullptr) {
+            return page_ids;
+        }
+        auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+        if (node->IsLeafPage()) {
+            buffer_pool_manager->UnpinPage(page_id, false);
+            break;
+        }
+        page_id_t child_page_id = reinterpret_cast<BPlusTreeInternalPage<> *>(node)->ValueAt(0);
+        buffer_pool_manager->UnpinPage(page_id, false);
+        page_id = child_page_id;
+    }
+    while (page_id != INVALID_PAGE_ID) {
+        auto page = buffer_pool_manager->FetchPage(page_id);
+        if (page == nullptr) {
+            break;
+        }
+        page_ids.push_back(page_id);
+        page_id_t next_page_id = reinterpret_cast<BPlusTreeLeafPage<> *>(page->GetData())->GetNextPageId();
+        buffer_pool_manager->UnpinPage(page_id, false);
+        page_id = next_page_id;
+    }
+    return page_ids;
+}
+
+std::ostream &operator<<(std::ostream &os, const FragmentationReport &report) {
+    os << report.pages_ << " pages in " << report.runs_ << " runs (average run " << report.AverageRunLength()
+       << " pages), " << report.backward_jumps_ << " backward jumps, " << report.jump_distance_ << " pages jumped";
+    return os;
+}
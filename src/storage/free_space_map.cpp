@@ -0,0 +1,173 @@
+#include "storage/free_space_map.h"
+
+#include "glog/logging.h"
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id)
+    : buffer_pool_manager_(buffer_pool_manager),
+      first_page_id_(first_page_id),
+      last_map_page_id_(first_page_id),
+      last_heap_page_id_(INVALID_PAGE_ID),
+      buckets_(BUCKET_COUNT) {
+    if (first_page_id_ == INVALID_PAGE_ID) {
+        auto page = buffer_pool_manager_->NewPage(first_page_id_);
+        ASSERT(page != nullptr, "Cannot allocate free space map page.");
+        reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->Init();
+        buffer_pool_manager_->UnpinPage(first_page_id_, true);
+        last_map_page_id_ = first_page_id_;
+        return;
+    }
+    // load every entry of the map
+    page_id_t map_page_id = first_page_id_;
+    while (map_page_id != INVALID_PAGE_ID) {
+        auto page = buffer_pool_manager_->FetchPage(map_page_id);
+        ASSERT(page != nullptr, "Cannot fetch free space map page.");
+        auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+        if (map_page_id == first_page_id_) {
+            last_heap_page_id_ = map_page->GetLastHeapPageId();
+        }
+        for (uint32_t slot = 0; slot < map_page->GetCount(); slot++) {
+            page_id_t heap_page_id = map_page->GetHeapPageId(slot);
+            if (heap_page_id == INVALID_PAGE_ID) {
+                holes_.emplace_back(map_page_id, slot);
+                continue;
+            }
+            uint32_t free_space = map_page->GetFreeSpace(slot);
+            entries_[heap_page_id] = {free_space, map_page_id, slot};
+            buckets_[GetBucket(free_space)].insert(heap_page_id);
+        }
+        last_map_page_id_ = map_page_id;
+        page_id_t next_page_id = map_page->GetNextPageId();
+        buffer_pool_manager_->UnpinPage(map_page_id, false);
+        map_page_id = next_page_id;
+    }
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t size) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    // every page of these buckets has room, so the lookup never looks at a single page that is too full
+    for (uint32_t bucket = (size + BUCKET_WIDTH - 1) / BUCKET_WIDTH; bucket < BUCKET_COUNT; bucket++) {
+        if (!buckets_[bucket].empty()) {
+            page_id_t heap_page_id = *buckets_[bucket].begin();
+            if (entries_[heap_page_id].free_space_ >= size) {
+                return heap_page_id;
+            }
+        }
+    }
+    return INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::Update(page_id_t heap_page_id, uint32_t free_space) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    auto it = entries_.find(heap_page_id);
+    if (it != entries_.end()) {
+        Entry &entry = it->second;
+        uint32_t old_bucket = GetBucket(entry.free_space_);
+        uint32_t new_bucket = GetBucket(free_space);
+        entry.free_space_ = free_space;
+        if (old_bucket != new_bucket) {
+            buckets_[old_bucket].erase(heap_page_id);
+            buckets_[new_bucket].insert(heap_page_id);
+            WriteEntry(entry);
+        }
+        return;
+    }
+    // a new heap page, its entry takes the hole of a removed page if there is one
+    if (!holes_.empty()) {
+        auto [map_page_id, slot] = holes_.back();
+        holes_.pop_back();
+        auto page = buffer_pool_manager_->FetchPage(map_page_id);
+        ASSERT(page != nullptr, "Cannot fetch free space map page.");
+        auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+        map_page->SetHeapPageId(slot, heap_page_id);
+        map_page->SetFreeSpace(slot, free_space);
+        buffer_pool_manager_->UnpinPage(map_page_id, true);
+        entries_[heap_page_id] = {free_space, map_page_id, slot};
+        buckets_[GetBucket(free_space)].insert(heap_page_id);
+        return;
+    }
+    // otherwise append it to the last map page
+    auto page = buffer_pool_manager_->FetchPage(last_map_page_id_);
+    ASSERT(page != nullptr, "Cannot fetch free space map page.");
+    auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+    if (map_page->IsFull()) {
+        page_id_t new_page_id;
+        auto new_page = buffer_pool_manager_->NewPage(new_page_id, last_map_page_id_);
+        ASSERT(new_page != nullptr, "Cannot allocate free space map page.");
+        map_page->SetNextPageId(new_page_id);
+        buffer_pool_manager_->UnpinPage(last_map_page_id_, true);
+        last_map_page_id_ = new_page_id;
+        page = new_page;
+        map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+        map_page->Init();
+    }
+    uint32_t slot = map_page->Append(heap_page_id, free_space);
+    buffer_pool_manager_->UnpinPage(last_map_page_id_, true);
+    entries_[heap_page_id] = {free_space, last_map_page_id_, slot};
+    buckets_[GetBucket(free_space)].insert(heap_page_id);
+}
+
+void FreeSpaceMap::Remove(page_id_t heap_page_id) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    auto it = entries_.find(heap_page_id);
+    if (it == entries_.end()) {
+        return;
+    }
+    Entry &entry = it->second;
+    buckets_[GetBucket(entry.free_space_)].erase(heap_page_id);
+    auto page = buffer_pool_manager_->FetchPage(entry.map_page_id_);
+    ASSERT(page != nullptr, "Cannot fetch free space map page.");
+    reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->SetHeapPageId(entry.slot_, INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(entry.map_page_id_, true);
+    holes_.emplace_back(entry.map_page_id_, entry.slot_);
+    entries_.erase(it);
+}
+
+bool FreeSpaceMap::Contains(page_id_t heap_page_id) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    return entries_.count(heap_page_id) > 0;
+}
+
+page_id_t FreeSpaceMap::GetLastHeapPageId() {
+    std::scoped_lock<std::mutex> lock(latch_);
+    return last_heap_page_id_;
+}
+
+void FreeSpaceMap::SetLastHeapPageId(page_id_t heap_page_id) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    last_heap_page_id_ = heap_page_id;
+    auto page = buffer_pool_manager_->FetchPage(first_page_id_);
+    ASSERT(page != nullptr, "Cannot fetch free space map page.");
+    reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->SetLastHeapPageId(heap_page_id);
+    buffer_pool_manager_->UnpinPage(first_page_id_, true);
+}
+
+size_t FreeSpaceMap::GetPageCount() {
+    std::scoped_lock<std::mutex> lock(latch_);
+    return entries_.size();
+}
+
+void FreeSpaceMap::Destroy() {
+    std::scoped_lock<std::mutex> lock(latch_);
+    page_id_t map_page_id = first_page_id_;
+    while (map_page_id != INVALID_PAGE_ID) {
+        auto page = buffer_pool_manager_->FetchPage(map_page_id);
+        ASSERT(page != nullptr, "Cannot fetch free space map page.");
+        page_id_t next_page_id = reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->GetNextPageId();
+        buffer_pool_manager_->UnpinPage(map_page_id, false);
+        buffer_pool_manager_->DeletePage(map_page_id);
+        map_page_id = next_page_id;
+    }
+    entries_.clear();
+    holes_.clear();
+    for (auto &bucket : buckets_) {
+        bucket.clear();
+    }
+    first_page_id_ = last_map_page_id_ = last_heap_page_id_ = INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::WriteEntry(const Entry &entry) {
+    auto page = buffer_pool_manager_->FetchPage(entry.map_page_id_);
+    ASSERT(page != nullptr, "Cannot fetch free space map page.");
+    reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->SetFreeSpace(entry.slot_, entry.free_space_);
+    buffer_pool_manager_->UnpinPage(entry.map_page_id_, true);
+}
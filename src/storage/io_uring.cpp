@@ -0,0 +1,201 @@
+#include "storage/io_uring.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include "glog/logging.h"
+
+static int IOUringSetup(unsigned entries, struct io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int IOUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+bool IOHandle::Wait() {
+    if (completion_ == nullptr) {
+        return true;
+    }
+    if (!IsDone()) {
+        // the request may still be in the submission queue, send the whole batch now
+        ring_->Submit();
+    }
+    std::unique_lock<std::mutex> lock(completion_->latch_);
+    completion_->cv_.wait(lock, [this] { return completion_->done_; });
+    return completion_->result_ == static_cast<int>(completion_->len_);
+}
+
+bool IOHandle::IsDone() {
+    if (completion_ == nullptr) {
+        return true;
+    }
+    std::scoped_lock<std::mutex> lock(completion_->latch_);
+    return completion_->done_;
+}
+
+IOUring::IOUring(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = IOUringSetup(entries, &params);
+    if (ring_fd_ < 0) {
+        LOG(WARNING) << "io_uring is not available: " << strerror(errno);
+        return;
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        LOG(WARNING) << "io_uring is too old, IORING_FEAT_SINGLE_MMAP is required";
+        close(ring_fd_);
+        ring_fd_ = -1;
+        return;
+    }
+    entries_ = params.sq_entries;
+    sq_ring_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                             params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+        LOG(WARNING) << "Cannot map io_uring: " << strerror(errno);
+        if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+        if (sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+        sq_ring_ = sqes_ = nullptr;
+        close(ring_fd_);
+        ring_fd_ = -1;
+        return;
+    }
+    auto base = reinterpret_cast<char *>(sq_ring_);
+    sq_head_ = reinterpret_cast<std::atomic<unsigned> *>(base + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<std::atomic<unsigned> *>(base + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+    cq_head_ = reinterpret_cast<std::atomic<unsigned> *>(base + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<std::atomic<unsigned> *>(base + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+    cqes_ = base + params.cq_off.cqes;
+    completion_thread_ = std::thread(&IOUring::CompletionLoop, this);
+}
+
+IOUring::~IOUring() {
+    if (!IsValid()) {
+        return;
+    }
+    {
+        // wait for the outstanding requests, then wake up the completion thread with a nop
+        std::unique_lock<std::mutex> lock(submit_latch_);
+        SubmitLocked();
+        slot_cv_.wait(lock, [this] { return in_flight_ == 0 || shutdown_; });
+        shutdown_ = true;
+        unsigned tail = sq_tail_->load(std::memory_order_relaxed);
+        unsigned index = tail & sq_mask_;
+        auto sqe = reinterpret_cast<struct io_uring_sqe *>(sqes_) + index;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+        sq_array_[index] = index;
+        sq_tail_->store(tail + 1, std::memory_order_release);
+        IOUringEnter(ring_fd_, 1, 0, 0);
+    }
+    completion_thread_.join();
+    munmap(sqes_, sqes_size_);
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+}
+
+IOHandle IOUring::Prepare(bool is_read, int fd, char *buf, unsigned len, uint64_t offset) {
+    auto completion = std::make_shared<IOCompletion>();
+    completion->buf_ = buf;
+    completion->len_ = len;
+    completion->is_read_ = is_read;
+    std::unique_lock<std::mutex> lock(submit_latch_);
+    // never have more requests in flight than the completion queue can hold
+    if (in_flight_ >= entries_) {
+        SubmitLocked();
+        slot_cv_.wait(lock, [this] { return in_flight_ < entries_; });
+    }
+    unsigned tail = sq_tail_->load(std::memory_order_relaxed);
+    unsigned index = tail & sq_mask_;
+    auto sqe = reinterpret_cast<struct io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = is_read ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    // the completion thread owns this reference until the request completes
+    sqe->user_data = reinterpret_cast<uint64_t>(new std::shared_ptr<IOCompletion>(completion));
+    sq_array_[index] = index;
+    sq_tail_->store(tail + 1, std::memory_order_release);
+    queued_++;
+    in_flight_++;
+    return IOHandle(completion, this);
+}
+
+void IOUring::Submit() {
+    std::scoped_lock<std::mutex> lock(submit_latch_);
+    SubmitLocked();
+}
+
+void IOUring::SubmitLocked() {
+    while (queued_ > 0) {
+        int rc = IOUringEnter(ring_fd_, queued_, 0, 0);
+        if (rc < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+            return;
+        }
+        queued_ -= rc;
+    }
+}
+
+void IOUring::CompletionLoop() {
+    for (;;) {
+        int rc = IOUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        if (rc < 0 && errno != EINTR) {
+            LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+        }
+        unsigned head = cq_head_->load(std::memory_order_relaxed);
+        unsigned tail = cq_tail_->load(std::memory_order_acquire);
+        unsigned completed = 0;
+        bool stop = false;
+        for (; head != tail; head++) {
+            auto cqe = reinterpret_cast<struct io_uring_cqe *>(cqes_) + (head & cq_mask_);
+            if (cqe->user_data == 0) {
+                stop = true;
+                continue;
+            }
+            auto completion_ref = reinterpret_cast<std::shared_ptr<IOCompletion> *>(cqe->user_data);
+            auto &completion = *completion_ref;
+            {
+                std::scoped_lock<std::mutex> lock(completion->latch_);
+                completion->result_ = cqe->res;
+                // a read past the end of file comes back short, the rest of the page is zero
+                if (completion->is_read_ && cqe->res >= 0 && static_cast<unsigned>(cqe->res) < completion->len_) {
+                    memset(completion->buf_ + cqe->res, 0, completion->len_ - cqe->res);
+                    completion->result_ = static_cast<int>(completion->len_);
+                }
+                completion->done_ = true;
+            }
+            completion->cv_.notify_all();
+            delete completion_ref;
+            completed++;
+        }
+        cq_head_->store(head, std::memory_order_release);
+        if (completed > 0) {
+            {
+                std::scoped_lock<std::mutex> lock(submit_latch_);
+                in_flight_ -= completed;
+            }
+            slot_cv_.notify_all();
+        }
+        if (stop) {
+            return;
+        }
+    }
+}
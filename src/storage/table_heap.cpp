@@ -1,43 +1,179 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
+
+TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
+                     LogManager *log_manager, LockManager *lock_manager, page_id_t free_space_map_page_id)
+    : buffer_pool_manager_(buffer_pool_manager),
+      first_page_id_(first_page_id),
+      schema_(schema),
+      log_manager_(log_manager),
+      lock_manager_(lock_manager),
+      zone_map_(std::make_unique<ZoneMap>(schema->GetColumnCount())) {
+    if (free_space_map_page_id != INVALID_PAGE_ID) {
+        free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_, free_space_map_page_id);
+    } else {
+        RebuildFreeSpaceMap();
+    }
+}
+
+void TableHeap::RebuildFreeSpaceMap() {
+    free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_);
+    page_id_t page_id = first_page_id_;
+    page_id_t last_page_id = first_page_id_;
+    while (page_id != INVALID_PAGE_ID) {
+        auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+        assert(page != nullptr);
+        page->RLatch();
+        uint32_t free_space = page->GetFreeSpaceRemaining();
+        page_id_t next_page_id = page->GetNextPageId();
+        page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(page_id, false);
+        free_space_map_->Update(page_id, free_space);
+        last_page_id = page_id;
+        page_id = next_page_id;
+    }
+    free_space_map_->SetLastHeapPageId(last_page_id);
+}
+
 bool TableHeap::InsertTuple(Row &row, Transaction *txn) {
-    if (row.GetSerializedSize(schema_) >= PAGE_SIZE) {
+    uint32_t serialized_size = row.GetSerializedSize(schema_);
+    if (serialized_size > TablePage::SIZE_MAX_ROW) {
         LOG(ERROR) << "row tuple size is too large!";
         return false;
     }
+    uint32_t space_needed = serialized_size + TablePage::SIZE_TUPLE;
 
-    page_id_t page_id = first_page_id_;
-    for (;;) {
+    // Try the pages the free space map says have room, a failed attempt corrects the map so it is not retried.
+    for (page_id_t page_id = free_space_map_->FindPage(space_needed); page_id != INVALID_PAGE_ID;
+         page_id = free_space_map_->FindPage(space_needed)) {
         auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
         assert(page != nullptr);
         page->WLatch();
-        if (page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+        if (!free_space_map_->Contains(page_id)) {
+            // Vacuum took the page out of the heap since it was found
             page->WUnlatch();
-            buffer_pool_manager_->UnpinPage(page_id, true);
-            return true;
+            buffer_pool_manager_->UnpinPage(page_id, false);
+            continue;
         }
+        bool inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+        if (inserted) {
+            // widen the zone before the row can be seen, a scan must not skip the page for missing it
+            zone_map_->Update(page_id, row);
+        }
+        free_space_map_->Update(page_id, page->GetFreeSpaceRemaining());
         page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(page_id, false);
-        if (page->GetNextPageId() == INVALID_PAGE_ID) {
-            break;
+        buffer_pool_manager_->UnpinPage(page_id, inserted);
+        if (inserted) {
+            return true;
         }
-        page_id = page->GetNextPageId();
     }
 
-    // If no page can fit the tuple, then create a new page.
+    // If no page can fit the tuple, then create a new page after the last one.
+    std::scoped_lock<std::mutex> lock(append_latch_);
+    page_id_t last_page_id = free_space_map_->GetLastHeapPageId();
     page_id_t new_page_id;
-    auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id));
+    auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id, last_page_id));
     assert(new_page != nullptr);
     new_page->WLatch();
-    new_page->Init(new_page_id, page_id, log_manager_, txn);
-    new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    new_page->Init(new_page_id, last_page_id, log_manager_, txn);
+    if (!new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+        // the page is not linked yet, give it back
+        new_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(new_page_id, false);
+        buffer_pool_manager_->DeletePage(new_page_id);
+        LOG(ERROR) << "row tuple does not fit in an empty page!";
+        return false;
+    }
+    zone_map_->AddPage(new_page_id);
+    zone_map_->Update(new_page_id, row);
+    free_space_map_->Update(new_page_id, new_page->GetFreeSpaceRemaining());
     new_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(page_id, true);
-    auto old_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    auto old_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id));
     old_page->WLatch();
     old_page->SetNextPageId(new_page_id);
     old_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(page_id, true);
+    buffer_pool_manager_->UnpinPage(last_page_id, true);
+    free_space_map_->SetLastHeapPageId(new_page_id);
+    return true;
+}
+
+bool TableHeap::InsertTuples(std::vector<Row> &rows, Transaction *txn) {
+    for (auto &row : rows) {
+        if (row.GetSerializedSize(schema_) > TablePage::SIZE_MAX_ROW) {
+            LOG(ERROR) << "row tuple size is too large!";
+            return false;
+        }
+    }
+    auto space_needed = [&](size_t i) { return rows[i].GetSerializedSize(schema_) + TablePage::SIZE_TUPLE; };
+    size_t next = 0;
+
+    // Fill the pages that have room first, one pin and latch per page.
+    while (next < rows.size()) {
+        page_id_t page_id = free_space_map_->FindPage(space_needed(next));
+        if (page_id == INVALID_PAGE_ID) {
+            break;
+        }
+        auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+        assert(page != nullptr);
+        page->WLatch();
+        if (!free_space_map_->Contains(page_id)) {
+            // Vacuum took the page out of the heap since it was found
+            page->WUnlatch();
+            buffer_pool_manager_->UnpinPage(page_id, false);
+            continue;
+        }
+        size_t first = next;
+        while (next < rows.size() && page->InsertTuple(rows[next], schema_, txn, lock_manager_, log_manager_)) {
+            zone_map_->Update(page_id, rows[next]);
+            next++;
+        }
+        free_space_map_->Update(page_id, page->GetFreeSpaceRemaining());
+        page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(page_id, next > first);
+    }
+    if (next == rows.size()) {
+        return true;
+    }
+
+    // Then write the rest into a run of new pages, each one linked to the previous while both are pinned, and hook the
+    // run to the end of the heap once.
+    std::scoped_lock<std::mutex> lock(append_latch_);
+    page_id_t last_page_id = free_space_map_->GetLastHeapPageId();
+    page_id_t run_first_page_id = INVALID_PAGE_ID;
+    page_id_t prev_page_id = last_page_id;
+    TablePage *prev_page = nullptr;
+    while (next < rows.size()) {
+        page_id_t new_page_id;
+        auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id, prev_page_id));
+        assert(new_page != nullptr);
+        new_page->WLatch();
+        new_page->Init(new_page_id, prev_page_id, log_manager_, txn);
+        zone_map_->AddPage(new_page_id);
+        while (next < rows.size() && new_page->InsertTuple(rows[next], schema_, txn, lock_manager_, log_manager_)) {
+            zone_map_->Update(new_page_id, rows[next]);
+            next++;
+        }
+        if (prev_page != nullptr) {
+            prev_page->SetNextPageId(new_page_id);
+            prev_page->WUnlatch();
+            buffer_pool_manager_->UnpinPage(prev_page_id, true);
+        } else {
+            run_first_page_id = new_page_id;
+        }
+        free_space_map_->Update(new_page_id, new_page->GetFreeSpaceRemaining());
+        prev_page = new_page;
+        prev_page_id = new_page_id;
+    }
+    prev_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(prev_page_id, true);
+    auto last_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id));
+    last_page->WLatch();
+    last_page->SetNextPageId(run_first_page_id);
+    last_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(last_page_id, true);
+    free_space_map_->SetLastHeapPageId(prev_page_id);
     return true;
 }
 
@@ -57,7 +193,7 @@ bool TableHeap::MarkDelete(const RowId &rid, Transaction *txn) {
 }
 
 bool TableHeap::UpdateTuple(const Row &row, const RowId &rid, Transaction *txn) {
-    if (row.GetSerializedSize(schema_) >= PAGE_SIZE) {
+    if (row.GetSerializedSize(schema_) > TablePage::SIZE_MAX_ROW) {
         LOG(ERROR) << "row tuple size is too large!";
         return false;
     }
@@ -88,6 +224,10 @@ bool TableHeap::UpdateTuple(const Row &row, const RowId &rid, Transaction *txn)
         }
         return true;
     }
+    if (result) {
+        zone_map_->Update(rid.GetPageId(), row);
+    }
+    free_space_map_->Update(rid.GetPageId(), page->GetFreeSpaceRemaining());
     page->WUnlatch();
     buffer_pool_manager_->UnpinPage(rid.GetPageId(), result);
     return result;
@@ -100,45 +240,175 @@ void TableHeap::ApplyDelete(const RowId &rid, Transaction *txn) {
     // Step2: Delete the tuple from the page.
     page->WLatch();
     page->ApplyDelete(rid, txn, log_manager_);
+    // Step3: The freed space can take new tuples.
+    free_space_map_->Update(rid.GetPageId(), page->GetFreeSpaceRemaining());
     page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+    buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Transaction *txn) {
     // Find the page which contains the tuple.
     auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
     assert(page != nullptr);
-    // Rollback to delete.
+    // Rollback to delete, a zone rebuilt since the delete does not cover the tuple.
     page->WLatch();
     page->RollbackDelete(rid, txn, log_manager_);
+    Row row(rid);
+    if (page->GetTuple(&row, schema_, txn, lock_manager_)) {
+        zone_map_->Update(rid.GetPageId(), row);
+    }
     page->WUnlatch();
     buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
-bool TableHeap::GetTuple(Row *row, Transaction *txn) {
+VacuumStats TableHeap::Vacuum(std::vector<std::pair<RowId, RowId>> *moved, Transaction *txn) {
+    std::scoped_lock<std::mutex> lock(append_latch_);
+    VacuumStats stats;
+
+    // Step1: Compact every page, its tuples keep their slots.
+    std::vector<page_id_t> page_ids;
+    for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+        auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+        assert(page != nullptr);
+        page->WLatch();
+        page->Compact();
+        free_space_map_->Update(page_id, page->GetFreeSpaceRemaining());
+        page_id_t next_page_id = page->GetNextPageId();
+        page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(page_id, true);
+        page_ids.push_back(page_id);
+        page_id = next_page_id;
+    }
+    stats.pages_before_ = static_cast<uint32_t>(page_ids.size() + unlinked_pages_.size());
+    DeleteUnlinkedPages();
+
+    // Step2: Move tuples from the end of the heap into the free space of the front pages, and cut the pages emptied this
+    // way off the end of the chain. The pages left are a prefix of the chain, so a scan still reads them in order. A
+    // tuple only moves from a back page to a front page, so it moves at most once.
+    // The free space map of a page only changes under its write latch. The back page leaves the map before its tuples
+    // move, so an insert that found it earlier sees it is gone once it gets the latch and tries another page.
+    size_t front = 0;
+    size_t back = page_ids.size() - 1;
+    while (front < back) {
+        auto front_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_ids[front]));
+        auto back_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_ids[back]));
+        assert(front_page != nullptr && back_page != nullptr);
+        front_page->WLatch();
+        back_page->WLatch();
+        free_space_map_->Remove(page_ids[back]);
+        std::vector<RowId> moved_out;
+        RowId rid;
+        bool found = back_page->GetFirstTupleRid(&rid);
+        for (; found; found = back_page->GetNextTupleRid(rid, &rid)) {
+            Row row(rid);
+            back_page->GetTuple(&row, schema_, txn, lock_manager_);
+            if (!front_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+                break;
+            }
+            zone_map_->Update(page_ids[front], row);
+            moved->emplace_back(rid, row.GetRowId());
+            moved_out.push_back(rid);
+        }
+        if (!found) {
+            // the back page is empty now, unlink it from the chain and release it
+            page_id_t prev_page_id = page_ids[back - 1];
+            if (prev_page_id == page_ids[front]) {
+                front_page->SetNextPageId(INVALID_PAGE_ID);
+            } else {
+                auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+                assert(prev_page != nullptr);
+                prev_page->WLatch();
+                prev_page->SetNextPageId(INVALID_PAGE_ID);
+                prev_page->WUnlatch();
+                buffer_pool_manager_->UnpinPage(prev_page_id, true);
+            }
+            back_page->WUnlatch();
+            buffer_pool_manager_->UnpinPage(page_ids[back], false);
+            zone_map_->RemovePage(page_ids[back]);
+            unlinked_pages_.push_back(page_ids[back]);
+            free_space_map_->SetLastHeapPageId(prev_page_id);
+            back--;
+        } else {
+            // the front page is full, drop the moved tuples from the back page and go on with the next front page
+            for (auto &moved_rid : moved_out) {
+                back_page->ApplyDelete(moved_rid, txn, log_manager_);
+            }
+            free_space_map_->Update(page_ids[back], back_page->GetFreeSpaceRemaining());
+            back_page->WUnlatch();
+            buffer_pool_manager_->UnpinPage(page_ids[back], true);
+            front++;
+        }
+        free_space_map_->Update(front_page->GetTablePageId(), front_page->GetFreeSpaceRemaining());
+        front_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(front_page->GetTablePageId(), true);
+    }
+    DeleteUnlinkedPages();
+    stats.pages_after_ = static_cast<uint32_t>(back + 1 + unlinked_pages_.size());
+    stats.rows_moved_ = static_cast<uint32_t>(moved->size());
+    return stats;
+}
+
+void TableHeap::DeleteUnlinkedPages() {
+    // a scan or a read ahead may still pin a page it reached before the page was cut off
+    auto last = std::remove_if(unlinked_pages_.begin(), unlinked_pages_.end(),
+                               [this](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); });
+    unlinked_pages_.erase(last, unlinked_pages_.end());
+}
+
+bool TableHeap::GetTuple(Row *row, Transaction *txn, Arena *arena) {
     auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(row->GetRowId().GetPageId()));
     assert(page != nullptr);
     page->RLatch();
-    bool result = page->GetTuple(row, schema_, txn, lock_manager_);
+    bool result = page->GetTuple(row, schema_, txn, lock_manager_, arena);
     page->RUnlatch();
     buffer_pool_manager_->UnpinPage(row->GetRowId().GetPageId(), false);
     return result;
 }
 
 void TableHeap::DeleteTable(page_id_t page_id) {
-    if (page_id != INVALID_PAGE_ID) {
-        auto temp_table_page =
-            reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
-        if (temp_table_page->GetNextPageId() != INVALID_PAGE_ID) DeleteTable(temp_table_page->GetNextPageId());
+    if (page_id == INVALID_PAGE_ID || page_id == first_page_id_) {
+        page_id = first_page_id_;
+        free_space_map_->Destroy();
+        zone_map_->Clear();
+        DeleteUnlinkedPages();
+    }
+    // 删除table_heap, walk the chain one page at a time so that only one page is pinned
+    while (page_id != INVALID_PAGE_ID) {
+        auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+        assert(temp_table_page != nullptr);
+        page_id_t next_page_id = temp_table_page->GetNextPageId();
         buffer_pool_manager_->UnpinPage(page_id, false);
         buffer_pool_manager_->DeletePage(page_id);
-    } else {
-        DeleteTable(first_page_id_);
+        page_id = next_page_id;
+    }
+}
+
+uint32_t TableHeap::RebuildZoneMap() {
+    uint32_t page_count = 0;
+    for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID; page_count++) {
+        auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+        assert(page != nullptr);
+        page->RLatch();
+        zone_map_->AddPage(page_id);
+        RowId rid;
+        for (bool found = page->GetFirstTupleRid(&rid); found; found = page->GetNextTupleRid(rid, &rid)) {
+            Row row(rid);
+            page->GetTuple(&row, schema_, nullptr, lock_manager_);
+            zone_map_->Update(page_id, row);
+        }
+        page_id_t next_page_id = page->GetNextPageId();
+        page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(page_id, false);
+        page_id = next_page_id;
     }
+    return page_count;
 }
 
-TableIterator TableHeap::Begin(Transaction *txn) {
-    return TableIterator(BEGIN_ITERATOR, first_page_id_, schema_, buffer_pool_manager_, txn, log_manager_, lock_manager_);
+TableIterator TableHeap::Begin(Transaction *txn, size_t ring_size, size_t read_ahead, PageFilter page_filter) {
+    // large scans read through a small ring of frames so they don't evict the working set of the main pool
+    std::shared_ptr<BufferRing> ring = ring_size > 0 ? std::make_shared<BufferRing>(ring_size) : nullptr;
+    return TableIterator(BEGIN_ITERATOR, first_page_id_, schema_, buffer_pool_manager_, txn, log_manager_, lock_manager_,
+                         ring, read_ahead, std::move(page_filter));
 }
 
 TableIterator TableHeap::End() {
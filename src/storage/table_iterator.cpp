@@ -5,94 +5,119 @@
 
 // mode = false: begin iterator; mode = true: end iterator
 TableIterator::TableIterator(bool mode, page_id_t first_page_id, Schema *schema, BufferPoolManager *buffer_pool_manager,
-                             Transaction *txn, LogManager *log_manager, LockManager *lock_manager)
-    : schema_(schema),
+                             Transaction *txn, LogManager *log_manager, LockManager *lock_manager,
+                             std::shared_ptr<BufferRing> ring, size_t read_ahead, PageFilter page_filter)
+    : row_(new Row(RowId(INVALID_PAGE_ID, 0))),
+      schema_(schema),
       buffer_pool_manager_(buffer_pool_manager),
       txn_(txn),
       log_manager_(log_manager),
-      lock_manager_(lock_manager) {
+      lock_manager_(lock_manager),
+      ring_(std::move(ring)),
+      read_ahead_(buffer_pool_manager, read_ahead, TablePage::OFFSET_NEXT_PAGE_ID, ring_),
+      page_filter_(std::move(page_filter)) {
     if (mode == END_ITERATOR) {
-        page_ = nullptr;
-        row_ = new Row(RowId(INVALID_PAGE_ID, 0));
-        return;
-    }
-    page_ = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id));
-    assert(page_ != nullptr);
-    RowId rid;
-    if (!page_->GetFirstTupleRid(&rid)) {   // empty table
-        buffer_pool_manager_->UnpinPage(first_page_id, false);
-        page_ = nullptr;
-        row_ = new Row(RowId(INVALID_PAGE_ID, 0));
         return;
     }
-    row_ = new Row(rid);
-    page_->GetTuple(row_, schema_, txn, lock_manager_);
-    buffer_pool_manager_->UnpinPage(first_page_id, false);
+    SeekTuple(first_page_id, nullptr);
 }
 
-TableIterator::TableIterator(const TableIterator &other) { 
-    row_ = new Row(*other.row_);
-    page_ = other.page_;
+TableIterator::TableIterator(const TableIterator &other) {
+    // a copy only takes the fields if they were read already
+    row_ = other.materialized_ ? new Row(*other.row_) : new Row(other.row_->GetRowId());
+    materialized_ = other.materialized_;
     schema_ = other.schema_;
     buffer_pool_manager_ = other.buffer_pool_manager_;
     txn_ = other.txn_;
     log_manager_ = other.log_manager_;
     lock_manager_ = other.lock_manager_;
+    ring_ = other.ring_;
+    read_ahead_ = other.read_ahead_;
+    page_filter_ = other.page_filter_;
+    if (other.page_ != nullptr) {
+        page_ = reinterpret_cast<TablePage *>(
+                buffer_pool_manager_->FetchPage(other.page_->GetTablePageId(), ring_.get()));
+    }
 }
 
-TableIterator::~TableIterator() { delete row_; }
+TableIterator::TableIterator(TableIterator &&other) noexcept
+    : row_(other.row_),
+      materialized_(other.materialized_),
+      page_(other.page_),
+      schema_(other.schema_),
+      buffer_pool_manager_(other.buffer_pool_manager_),
+      txn_(other.txn_),
+      log_manager_(other.log_manager_),
+      lock_manager_(other.lock_manager_),
+      ring_(std::move(other.ring_)),
+      read_ahead_(std::move(other.read_ahead_)),
+      page_filter_(std::move(other.page_filter_)) {
+    other.row_ = new Row(RowId(INVALID_PAGE_ID, 0));
+    other.materialized_ = false;
+    other.page_ = nullptr;
+}
 
-bool TableIterator::operator==(const TableIterator &itr) const {
-    if (page_ == nullptr || itr.page_ == nullptr) {
-        return page_ == itr.page_;
-    }
-    return row_->GetRowId() == itr.row_->GetRowId();
+TableIterator::~TableIterator() {
+    ReleasePage();
+    delete row_;
 }
 
+bool TableIterator::operator==(const TableIterator &itr) const { return row_->GetRowId() == itr.row_->GetRowId(); }
+
 bool TableIterator::operator!=(const TableIterator &itr) const { return !(*this == itr); }
 
-const Row &TableIterator::operator*() { return *row_; }
+const Row &TableIterator::operator*() { return *operator->(); }
 
-Row *TableIterator::operator->() { return row_; }
+Row *TableIterator::operator->() {
+    if (!materialized_ && page_ != nullptr) {
+        page_->RLatch();
+        page_->GetTuple(row_, schema_, txn_, lock_manager_);
+        page_->RUnlatch();
+        materialized_ = true;
+    }
+    return row_;
+}
+
+LatchedRowView TableIterator::GetView() {
+    LatchedRowView view;
+    if (page_ != nullptr) {
+        page_->RLatch();
+        view.page_ = page_;
+        page_->GetTupleView(row_->GetRowId(), schema_, &view.view_);
+    }
+    return view;
+}
 
 TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
     if (this != &itr) {
+        ReleasePage();
         delete row_;
-        row_ = new Row(*itr.row_);
-        page_ = itr.page_;
+        row_ = itr.materialized_ ? new Row(*itr.row_) : new Row(itr.row_->GetRowId());
+        materialized_ = itr.materialized_;
         schema_ = itr.schema_;
         buffer_pool_manager_ = itr.buffer_pool_manager_;
         txn_ = itr.txn_;
         log_manager_ = itr.log_manager_;
         lock_manager_ = itr.lock_manager_;
+        ring_ = itr.ring_;
+        read_ahead_ = itr.read_ahead_;
+        page_filter_ = itr.page_filter_;
+        if (itr.page_ != nullptr) {
+            page_ = reinterpret_cast<TablePage *>(
+                    buffer_pool_manager_->FetchPage(itr.page_->GetTablePageId(), ring_.get()));
+        }
     }
     return *this;
 }
 
 // ++iter
 TableIterator &TableIterator::operator++() {
-    if (page_ == nullptr) {
+    RowId rid = row_->GetRowId();
+    if (rid.GetPageId() == INVALID_PAGE_ID) {
         LOG(WARNING) << "TableIterator: operator++() on a null page";
         return *this;
     }
-    RowId next_rid;
-    if (page_->GetNextTupleRid(row_->GetRowId(), &next_rid)) {
-        row_->SetRowId(next_rid);
-        page_->GetTuple(row_, schema_, txn_, lock_manager_);
-        return *this;
-    }
-    page_id_t next_page_id = page_->GetNextPageId();
-    if (next_page_id == INVALID_PAGE_ID) {
-        row_->SetRowId(RowId(INVALID_PAGE_ID, 0));
-        page_ = nullptr;
-        return *this;
-    }
-    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
-    page_ = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-    assert(page_ != nullptr);
-    page_->GetFirstTupleRid(&next_rid);
-    row_->SetRowId(next_rid);
-    page_->GetTuple(row_, schema_, txn_, lock_manager_);
+    SeekTuple(rid.GetPageId(), &rid);
     return *this;
 }
 
@@ -100,5 +125,45 @@ TableIterator &TableIterator::operator++() {
 TableIterator TableIterator::operator++(int) {
     TableIterator tmp(*this);
     operator++();
-    return TableIterator(tmp);
+    return tmp;
+}
+
+void TableIterator::SeekTuple(page_id_t page_id, const RowId *rid) {
+    materialized_ = false;
+    while (page_id != INVALID_PAGE_ID) {
+        if (page_ == nullptr || page_->GetTablePageId() != page_id) {
+            ReleasePage();
+            page_ = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, ring_.get()));
+            assert(page_ != nullptr);
+        }
+        page_->RLatch();
+        RowId next_rid;
+        page_id_t next_page_id = page_->GetNextPageId();
+        bool found;
+        if (rid == nullptr) {
+            found = (page_filter_ == nullptr || page_filter_(page_id)) && page_->GetFirstTupleRid(&next_rid);
+        } else {
+            found = page_->GetNextTupleRid(*rid, &next_rid);
+        }
+        page_->RUnlatch();
+        if (found) {
+            row_->SetRowId(next_rid);
+            if (rid == nullptr) {  // entered a new page
+                read_ahead_.Advance(page_id, next_page_id);
+            }
+            return;
+        }
+        // no more tuples on this page, or none that can match, skip to the next one
+        page_id = next_page_id;
+        rid = nullptr;
+    }
+    ReleasePage();
+    row_->SetRowId(RowId(INVALID_PAGE_ID, 0));
+}
+
+void TableIterator::ReleasePage() {
+    if (page_ != nullptr) {
+        buffer_pool_manager_->UnpinPage(page_->GetTablePageId(), false);
+        page_ = nullptr;
+    }
 }
@@ -0,0 +1,85 @@
+#include "storage/zone_map.h"
+
+void ZoneMap::AddPage(page_id_t page_id) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    auto &zone = zones_[page_id];
+    zone.clear();
+    zone.resize(column_count_);
+}
+
+void ZoneMap::Update(page_id_t page_id, const Row &row) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    auto it = zones_.find(page_id);
+    if (it == zones_.end()) {
+        return;
+    }
+    for (uint32_t i = 0; i < column_count_ && i < row.GetFieldCount(); i++) {
+        const Field *field = row.GetField(i);
+        ColumnZone &column = it->second[i];
+        if (field->IsNull()) {
+            column.null_count_++;
+        } else if (column.min_ == nullptr) {
+            column.min_ = std::make_unique<Field>(field->DeepCopy());
+            column.max_ = std::make_unique<Field>(field->DeepCopy());
+        } else if (field->CompareLessThan(*column.min_) == CmpBool::kTrue) {
+            column.min_ = std::make_unique<Field>(field->DeepCopy());
+        } else if (field->CompareGreaterThan(*column.max_) == CmpBool::kTrue) {
+            column.max_ = std::make_unique<Field>(field->DeepCopy());
+        }
+    }
+}
+
+void ZoneMap::RemovePage(page_id_t page_id) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    zones_.erase(page_id);
+}
+
+void ZoneMap::Clear() {
+    std::scoped_lock<std::mutex> lock(latch_);
+    zones_.clear();
+}
+
+size_t ZoneMap::GetPageCount() {
+    std::scoped_lock<std::mutex> lock(latch_);
+    return zones_.size();
+}
+
+bool ZoneMap::MayMatch(page_id_t page_id, uint32_t column, const std::string &comp_type, const Field &value) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    auto it = zones_.find(page_id);
+    if (it == zones_.end() || column >= column_count_) {
+        return true;
+    }
+    const ColumnZone &zone = it->second[column];
+    if (comp_type == "is") {
+        return zone.null_count_ > 0;
+    }
+    bool has_values = zone.min_ != nullptr;
+    if (comp_type == "not") {
+        return has_values;
+    }
+    // null values never satisfy a comparison
+    if (!has_values) {
+        return false;
+    }
+    // a constant of another type compares in ways the zone does not track
+    if (value.IsNull() || value.GetTypeId() != zone.min_->GetTypeId()) {
+        return true;
+    }
+    const Field &min = *zone.min_;
+    const Field &max = *zone.max_;
+    if (comp_type == "=") {
+        return min.CompareLessThanEquals(value) == CmpBool::kTrue && max.CompareGreaterThanEquals(value) == CmpBool::kTrue;
+    } else if (comp_type == "<>") {
+        return min.CompareNotEquals(value) == CmpBool::kTrue || max.CompareNotEquals(value) == CmpBool::kTrue;
+    } else if (comp_type == "<") {
+        return min.CompareLessThan(value) == CmpBool::kTrue;
+    } else if (comp_type == "<=") {
+        return min.CompareLessThanEquals(value) == CmpBool::kTrue;
+    } else if (comp_type == ">") {
+        return max.CompareGreaterThan(value) == CmpBool::kTrue;
+    } else if (comp_type == ">=") {
+        return max.CompareGreaterThanEquals(value) == CmpBool::kTrue;
+    }
+    return true;
+}
@@ -1,8 +1,17 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <iostream>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -71,4 +80,441 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+
+TEST(BufferPoolManagerTest, DISABLED_ConcurrentFetchUnpinBenchmark) {
+  const std::string db_name = "bpm_concurrent_test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 256;
+  const int num_threads = 4;
+  const int ops_per_thread = 20000;
+
+  for (size_t num_instances : {1, 2, 4, 8}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+    ASSERT_EQ(num_instances, bpm->GetNumInstances());
+
+    // every page holds its own id so readers can check they got the right frame
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      ASSERT_EQ(i, page_id);
+      *reinterpret_cast<page_id_t *>(page->GetData()) = page_id;
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+
+    std::atomic<int> errors{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t]() {
+        std::mt19937 rng(t);
+        std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+        for (int op = 0; op < ops_per_thread; op++) {
+          page_id_t page_id = dist(rng);
+          auto *page = bpm->FetchPage(page_id);
+          if (page == nullptr) {
+            continue;  // all frames of the instance are pinned by other threads
+          }
+          page->RLatch();
+          if (*reinterpret_cast<page_id_t *>(page->GetData()) != page_id) {
+            errors++;
+          }
+          page->RUnlatch();
+          if (!bpm->UnpinPage(page_id, false)) {
+            errors++;
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "instances=" << num_instances << " threads=" << num_threads << " ops/s="
+              << static_cast<uint64_t>(num_threads * ops_per_thread / elapsed) << std::endl;
+
+    EXPECT_EQ(0, errors.load());
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+    delete bpm;
+    disk_manager->Close();
+    delete disk_manager;
+    remove(db_name.c_str());
+  }
+}
+
+
+TEST(BufferPoolManagerTest, ConcurrentFetchUnpinTest) {
+  const std::string db_name = "bpm_concurrent_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 64;
+  const int num_threads = 4;
+  const int ops_per_thread = 2000;
+
+  for (size_t num_instances : {1, 4}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+    ASSERT_EQ(num_instances, bpm->GetNumInstances());
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      *reinterpret_cast<page_id_t *>(page->GetData()) = page_id;
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    // the pool is smaller than the pages, so the threads evict each other's pages from every instance
+    std::atomic<int> errors{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t]() {
+        std::mt19937 rng(t);
+        std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+        for (int op = 0; op < ops_per_thread; op++) {
+          page_id_t page_id = dist(rng);
+          auto *page = bpm->FetchPage(page_id);
+          if (page == nullptr) {
+            continue;
+          }
+          page->RLatch();
+          errors += *reinterpret_cast<page_id_t *>(page->GetData()) != page_id;
+          page->RUnlatch();
+          errors += !bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(0, errors.load());
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+    delete disk_manager;
+    remove(db_name.c_str());
+  }
+}
+
+/**
+ * Point lookups on a small hot set interleaved with full scans over a much larger table.
+ * @return hit rate of the lookups
+ */
+static double MixedScanLookupWorkload(ReplacerType replacer_type) {
+  const std::string db_name = "bpm_replacer_test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_hot_pages = 32;
+  const int num_pages = 512;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1, replacer_type);
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    EXPECT_NE(nullptr, bpm->NewPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, num_hot_pages - 1);
+  uint64_t lookup_hits = 0;
+  uint64_t lookups = 0;
+  for (int round = 0; round < 10; round++) {
+    // lookups warm up the hot set, then a scan runs through every page once
+    for (int i = 0; i < 2000; i++) {
+      page_id_t page_id = hot_dist(rng);
+      bpm->ResetStats();
+      EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+      lookup_hits += bpm->GetStats().hits_;
+      lookups++;
+      bpm->UnpinPage(page_id, false);
+    }
+    for (page_id_t page_id = num_hot_pages; page_id < num_pages; page_id++) {
+      EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+  }
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+  return static_cast<double>(lookup_hits) / lookups;
+}
+
+TEST(BufferPoolManagerTest, ScanResistanceTest) {
+  double lru = MixedScanLookupWorkload(ReplacerType::LRU);
+  double clock = MixedScanLookupWorkload(ReplacerType::CLOCK);
+  double lru_k = MixedScanLookupWorkload(ReplacerType::LRU_K);
+  std::cout << "lookup hit rate: LRU=" << lru << " CLOCK=" << clock << " LRU-K=" << lru_k << std::endl;
+  // the scan evicts the whole hot set under LRU, LRU-K keeps it
+  EXPECT_GT(lru_k, lru);
+  EXPECT_GT(lru_k, 0.99);
+}
+
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  const std::string db_name = "bpm_writer_test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 512;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // dirty pages stream through the pool, the writer cleans them before they are victimized
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = page_id;
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+    if (i % 16 == 15) {
+      bpm->RunBackgroundWriter();
+    }
+  }
+  auto stats = bpm->GetStats();
+  std::cout << "victim writes=" << stats.victim_writes_ << " background writes=" << stats.background_writes_
+            << std::endl;
+  EXPECT_GT(stats.background_writes_, 0);
+  EXPECT_LT(stats.victim_writes_, num_pages - buffer_pool_size);
+
+  // FlushAllPages leaves no dirty page behind
+  for (int i = num_pages - buffer_pool_size; i < num_pages; i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData() + sizeof(page_id_t)) = -page_ids[i];
+    bpm->UnpinPage(page_ids[i], true);
+  }
+  bpm->FlushAllPages();
+  char data[PAGE_SIZE];
+  for (int i = 0; i < num_pages; i++) {
+    disk_manager->ReadPage(page_ids[i], data);
+    ASSERT_EQ(page_ids[i], *reinterpret_cast<page_id_t *>(data));
+    if (i >= num_pages - static_cast<int>(buffer_pool_size)) {
+      ASSERT_EQ(-page_ids[i], *reinterpret_cast<page_id_t *>(data + sizeof(page_id_t)));
+    }
+  }
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, DeletePageShrinksFileTest) {
+  const std::string db_name = "bpm_delete_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 4 * PAGE_RESERVATION_SIZE;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+  bpm->FlushAllPages();
+  // most pages were evicted already, they must be freed on disk all the same
+  for (auto page_id : page_ids) {
+    ASSERT_TRUE(bpm->DeletePage(page_id));
+    ASSERT_TRUE(bpm->IsPageFree(page_id));
+  }
+  bpm->FlushAllPages();
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat(db_name.c_str(), &stat_buf));
+  EXPECT_EQ(PAGE_SIZE, stat_buf.st_size);
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, NewPageSkipsPinnedStaleCopyTest) {
+  const std::string db_name = "bpm_stale_test.db";
+  const size_t buffer_pool_size = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t freed_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(freed_page_id));
+  bpm->UnpinPage(freed_page_id, true);
+  ASSERT_TRUE(bpm->DeletePage(freed_page_id));
+  // a reader that followed a stale link pins the freed page again
+  auto *stale_page = bpm->FetchPage(freed_page_id);
+  ASSERT_NE(nullptr, stale_page);
+  page_id_t page_id;
+  auto *page = bpm->NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_NE(freed_page_id, page_id);
+  EXPECT_NE(stale_page, page);
+  EXPECT_TRUE(bpm->IsPageFree(freed_page_id));
+  // the reader's unpin lands on the stale frame, not on the new page
+  EXPECT_TRUE(bpm->UnpinPage(freed_page_id, false));
+  EXPECT_EQ(0, stale_page->GetPinCount());
+  EXPECT_EQ(1, page->GetPinCount());
+  bpm->UnpinPage(page_id, false);
+  // once unpinned the id is handed out again and the stale frame is reused
+  page_id_t reused_page_id;
+  EXPECT_EQ(stale_page, bpm->NewPage(reused_page_id));
+  EXPECT_EQ(freed_page_id, reused_page_id);
+  bpm->UnpinPage(reused_page_id, false);
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PrefetchPeekTest) {
+  const std::string db_name = "bpm_prefetch_test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 48;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData() + 16) = page_id;
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+  delete bpm;
+
+  for (int round = 0; round < 2; round++) {
+    bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    page_id_t peeked;
+    EXPECT_FALSE(bpm->PeekPage(page_ids[0], 16, sizeof(page_id_t), &peeked));
+    bpm->PrefetchPages(page_ids);
+    // fetches racing with the reads in flight wait for them, peeks never pin
+    for (auto page_id : page_ids) {
+      if (round == 0) {
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        ASSERT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData() + 16));
+        bpm->UnpinPage(page_id, false);
+      } else {
+        while (!bpm->PeekPage(page_id, 16, sizeof(page_id_t), &peeked)) {
+          std::this_thread::yield();
+        }
+        ASSERT_EQ(page_id, peeked);
+      }
+    }
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+  }
+
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+/**
+ * @return number of pages of the file currently held by the OS page cache
+ */
+static size_t CountCachedFilePages(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  size_t size = lseek(fd, 0, SEEK_END);
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  std::vector<unsigned char> residency((size + getpagesize() - 1) / getpagesize());
+  mincore(addr, size, residency.data());
+  munmap(addr, size);
+  close(fd);
+  size_t cached = 0;
+  for (auto page : residency) {
+    cached += page & 1;
+  }
+  return cached;
+}
+
+TEST(BufferPoolManagerTest, DISABLED_DirectIOBenchmark) {
+  const std::string db_name = "bpm_direct.db";
+  const int num_pages = 8192;
+  const size_t buffer_pool_size = 1024;
+  const int num_ops = 40000;
+  remove(db_name.c_str());
+  {
+    DiskManager disk_manager(db_name);
+    char data[PAGE_SIZE];
+    for (page_id_t i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_manager.AllocatePage());
+      memset(data, 0, PAGE_SIZE);
+      *reinterpret_cast<page_id_t *>(data) = i;
+      disk_manager.WritePage(i, data);
+    }
+  }
+
+  // random reads with one write out of eight, starting from an empty OS page cache
+  auto run = [&](bool direct_io, bool huge_pages) {
+    int fd = open(db_name.c_str(), O_RDWR);
+    fsync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    auto *disk_manager = new DiskManager(db_name, DEFAULT_USE_IO_URING, direct_io);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1, ReplacerType::LRU, DEFAULT_LRU_K, huge_pages);
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_ops; i++) {
+      page_id_t page_id = dist(rng);
+      Page *page = bpm->FetchPage(page_id);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+      EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+      bpm->UnpinPage(page_id, i % 8 == 0);
+    }
+    bpm->FlushAllPages();
+    double ops = num_ops / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t cached = CountCachedFilePages(db_name);
+    std::cout << (direct_io ? "O_DIRECT" : "buffered") << (huge_pages ? "+THP" : "") << ": " << static_cast<uint64_t>(ops)
+              << " fetches/s, pool " << bpm->GetFrameMemorySize() / 1024 << " KB + OS page cache " << cached * 4
+              << " KB" << std::endl;
+    bool really_direct = disk_manager->IsDirectIO();
+    delete bpm;
+    delete disk_manager;
+    return std::make_pair(cached, really_direct);
+  };
+  auto buffered = run(false, false);
+  auto direct = run(true, false);
+  run(true, true);
+  if (direct.second) {
+    // only the pages the buffer pool holds are cached, the OS copies are gone
+    EXPECT_LT(direct.first, buffered.first / 4);
+  }
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, DirectIOTest) {
+  const std::string db_name = "bpm_direct.db";
+  const int num_pages = 256;
+  const size_t buffer_pool_size = 32;
+  remove(db_name.c_str());
+  // the pages are written through evictions by a pool of small pages, then read back by one of huge pages
+  for (bool huge_pages : {false, true}) {
+    auto *disk_manager = new DiskManager(db_name, DEFAULT_USE_IO_URING, true);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1, ReplacerType::LRU, DEFAULT_LRU_K, huge_pages);
+    for (page_id_t i = 0; i < num_pages; i++) {
+      page_id_t page_id = i;
+      Page *page = huge_pages ? bpm->FetchPage(page_id) : bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      ASSERT_EQ(i, page_id);
+      ASSERT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+      if (!huge_pages) {
+        *reinterpret_cast<page_id_t *>(page->GetData()) = page_id;
+      }
+      ASSERT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+      bpm->UnpinPage(page_id, !huge_pages);
+    }
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
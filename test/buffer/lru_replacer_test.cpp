@@ -1,7 +1,54 @@
 #include "buffer/lru_replacer.h"
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <random>
+#include <unordered_set>
+
 #include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "gtest/gtest.h"
 
+/**
+ * The previous std::list based LRUReplacer, kept as the baseline of the benchmark below.
+ */
+class ListLRUReplacer : public Replacer {
+ public:
+  explicit ListLRUReplacer(size_t num_pages) : max_size_(num_pages) {}
+
+  bool Victim(frame_id_t *frame_id) override {
+    if (lru_list_.empty()) {
+      return false;
+    }
+    *frame_id = lru_list_.front();
+    lru_list_.pop_front();
+    lru_set_.erase(*frame_id);
+    return true;
+  }
+
+  void Pin(frame_id_t frame_id) override {
+    if (lru_set_.find(frame_id) != lru_set_.end()) {
+      lru_list_.remove(frame_id);
+      lru_set_.erase(frame_id);
+    }
+  }
+
+  void Unpin(frame_id_t frame_id) override {
+    if (lru_set_.find(frame_id) == lru_set_.end() && lru_list_.size() < max_size_) {
+      lru_list_.push_back(frame_id);
+      lru_set_.insert(frame_id);
+    }
+  }
+
+  size_t Size() override { return lru_list_.size(); }
+
+ private:
+  list<frame_id_t> lru_list_;
+  unordered_set<frame_id_t> lru_set_;
+  size_t max_size_;
+};
+
 TEST(LRUReplacerTest, SampleTest) {
   LRUReplacer lru_replacer(7);
 
@@ -80,4 +127,81 @@ TEST(LRUReplacerTest, ClockReplacerTest) {
   EXPECT_EQ(6, value);
   clock_replacer.Victim(&value);
   EXPECT_EQ(4, value);
-}
\ No newline at end of file
+}
+
+TEST(LRUReplacerTest, LRUKReplacerTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: frames 1-4 are accessed once, frames 1 and 2 a second time.
+  for (frame_id_t i = 1; i <= 4; i++) {
+    lru_k_replacer.Pin(i);
+  }
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Pin(1);
+  for (frame_id_t i = 1; i <= 4; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(4, lru_k_replacer.Size());
+
+  // Scenario: frames with less than K accesses go first, by their first access.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+
+  // Scenario: then the frame whose second most recent access is the oldest.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: a pinned frame is never victimized, a removed frame forgets its history.
+  lru_k_replacer.Pin(2);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.Pin(5);
+  lru_k_replacer.Pin(5);
+  lru_k_replacer.Unpin(5);
+  lru_k_replacer.Remove(2);
+  EXPECT_EQ(1, lru_k_replacer.Size());
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+/**
+ * Buffer pool hit pattern: pin a random unpinned frame and unpin it again, evicting one frame every 16 operations.
+ * @return operations per second
+ */
+static double ReplacerWorkload(Replacer &replacer, size_t num_frames, int num_ops) {
+  for (size_t i = 0; i < num_frames; i++) {
+    replacer.Unpin(static_cast<frame_id_t>(i));
+  }
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<frame_id_t> dist(0, static_cast<frame_id_t>(num_frames) - 1);
+  auto start = std::chrono::steady_clock::now();
+  for (int op = 0; op < num_ops; op++) {
+    frame_id_t frame_id = dist(rng);
+    replacer.Pin(frame_id);
+    replacer.Unpin(frame_id);
+    if (op % 16 == 0) {
+      frame_id_t victim;
+      EXPECT_TRUE(replacer.Victim(&victim));
+      replacer.Unpin(victim);
+    }
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(num_frames, replacer.Size());
+  return num_ops / elapsed;
+}
+
+TEST(LRUReplacerTest, DISABLED_PinUnpinBenchmark) {
+  for (size_t num_frames : {1000, 20000, 200000}) {
+    // the list replacer walks the whole list on every pin, so give it fewer operations
+    ListLRUReplacer list_replacer(num_frames);
+    double list_ops = ReplacerWorkload(list_replacer, num_frames, static_cast<int>(20000000 / num_frames));
+    LRUReplacer lru_replacer(num_frames);
+    double lru_ops = ReplacerWorkload(lru_replacer, num_frames, 1000000);
+    std::cout << "frames=" << num_frames << " list ops/s=" << static_cast<uint64_t>(list_ops)
+              << " intrusive ops/s=" << static_cast<uint64_t>(lru_ops) << std::endl;
+  }
+}
@@ -125,4 +125,59 @@ TEST(CatalogTest, CatalogIndexTest) {
     ASSERT_EQ(rid.Get(), ret_02[i].Get());
   }
   delete db_02;
-}
\ No newline at end of file
+}
+TEST(CatalogTest, CatalogLegacyIndexTest) {
+  auto db_01 = new DBStorageEngine(db_file_name, true);
+  auto &catalog_01 = db_01->catalog_mgr_;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Transaction txn;
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateTable("table-1", schema.get(), &txn, table_info));
+  std::vector<RowId> row_ids;
+  for (int i = 0; i < 1000; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                              Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, &txn));
+    row_ids.push_back(row.GetRowId());
+  }
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id"};
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateIndex("table-1", "index-1", index_keys, &txn, index_info, "bptree"));
+  // entries the rebuilt index must not keep, they stand for keys in the old layout
+  for (int i = 0; i < 1000; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, -1 - i)};
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(Row(fields), RowId(1000, i), &txn));
+  }
+  // mark the index as written before keys were memcomparable
+  Page *catalog_page = db_01->bpm_->FetchPage(CATALOG_META_PAGE_ID);
+  CatalogMeta *catalog_meta = CatalogMeta::DeserializeFrom(catalog_page->GetData());
+  db_01->bpm_->UnpinPage(CATALOG_META_PAGE_ID, false);
+  page_id_t index_meta_page_id = catalog_meta->GetIndexMetaPages()->begin()->second;
+  delete catalog_meta;
+  Page *index_meta_page = db_01->bpm_->FetchPage(index_meta_page_id);
+  MACH_WRITE_UINT32(index_meta_page->GetData(), 344528);
+  db_01->bpm_->UnpinPage(index_meta_page_id, true);
+  delete db_01;
+
+  auto db_02 = new DBStorageEngine(db_file_name, false);
+  IndexInfo *index_info_02 = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db_02->catalog_mgr_->GetIndex("table-1", "index-1", index_info_02));
+  for (int i = 0; i < 1000; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    std::vector<RowId> result;
+    index_info_02->GetIndex()->ScanKey(Row(fields), result, &txn);
+    ASSERT_EQ(1, result.size());
+    ASSERT_EQ(row_ids[i].Get(), result[0].Get());
+    std::vector<Field> dropped_fields{Field(TypeId::kTypeInt, -1 - i)};
+    result.clear();
+    index_info_02->GetIndex()->ScanKey(Row(dropped_fields), result, &txn);
+    ASSERT_TRUE(result.empty());
+  }
+  index_meta_page = db_02->bpm_->FetchPage(index_meta_page_id);
+  ASSERT_NE(344528, MACH_READ_UINT32(index_meta_page->GetData()));
+  db_02->bpm_->UnpinPage(index_meta_page_id, false);
+  delete db_02;
+}
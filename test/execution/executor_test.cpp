@@ -1,6 +1,9 @@
 //
 // Created by njz on 2023/1/26.
 //
+#include <chrono>
+#include <cstring>
+
 #include "executor/plans/delete_plan.h"
 #include "executor/plans/insert_plan.h"
 #include "executor/plans/seq_scan_plan.h"
@@ -153,6 +156,230 @@ TEST_F(ExecutorTest, SimpleRawInsertTest) {
   ASSERT_TRUE(result_set[0].GetField(2)->CompareEquals(Field(kTypeFloat, static_cast<float>(2.33))));
 }
 
+// INSERT INTO table-1 VALUES (1000, ...), ..., (3499, ...); spans several insert batches
+TEST_F(ExecutorTest, BatchInsertTest) {
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  const Schema *schema = table_info->GetSchema();
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id"};
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateIndex("table-1", "index-1", index_keys, GetTxn(),
+                                                                       index_info, "bptree"));
+
+  const int row_count = INSERT_BATCH_SIZE * 2 + 452;
+  std::vector<std::vector<AbstractExpressionRef>> raw_values;
+  for (int i = 0; i < row_count; i++) {
+    raw_values.push_back({MakeConstantValueExpression(Field(kTypeInt, 1000 + i)),
+                          MakeConstantValueExpression(Field(kTypeChar, const_cast<char *>("batch"), 5, false)),
+                          MakeConstantValueExpression(Field(kTypeFloat, static_cast<float>(i)))});
+  }
+  auto value_plan = std::make_shared<ValuesPlanNode>(nullptr, raw_values);
+  auto insert_plan = std::make_shared<InsertPlanNode>(nullptr, value_plan, "table-1");
+  std::vector<Row> result_set{};
+  ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->ExecutePlan(insert_plan, &result_set, GetTxn(), GetExecutorContext()));
+  result_set.clear();
+
+  // every inserted row is in the table and in the index
+  auto col_a = MakeColumnValueExpression(*schema, 0, "id");
+  auto predicate = MakeComparisonExpression(col_a, MakeConstantValueExpression(Field(kTypeInt, 1000)), ">=");
+  auto scan_plan = make_shared<SeqScanPlanNode>(schema, table_info->GetTableName(), predicate);
+  GetExecutionEngine()->ExecutePlan(scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(row_count, result_set.size());
+  for (const auto &row : result_set) {
+    std::vector<Field> key;
+    key.emplace_back(*row.GetField(0));
+    std::vector<RowId> scan_result;
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(Row(key), scan_result, GetTxn()));
+    ASSERT_EQ(1, scan_result.size());
+    Row stored(scan_result[0]);
+    ASSERT_TRUE(table_info->GetTableHeap()->GetTuple(&stored, GetTxn()));
+    ASSERT_TRUE(stored.GetField(0)->CompareEquals(*row.GetField(0)));
+  }
+}
+
+// Load rows through ExecuteEngine::BulkLoad and through one TableHeap::InsertTuple per row
+TEST_F(ExecutorTest, DISABLED_BulkLoadBenchmark) {
+  const int row_count = 200000;
+  const int chunk_size = 50000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableInfo *bulk_table = nullptr;
+  TableInfo *plain_table = nullptr;
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateTable("bulk", schema.get(), GetTxn(), bulk_table));
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateTable("plain", schema.get(), GetTxn(), plain_table));
+  char name[32];
+  memset(name, 'x', sizeof(name));
+  auto make_chunk = [&](int begin) {
+    std::vector<Row> rows;
+    rows.reserve(chunk_size);
+    for (int i = begin; i < begin + chunk_size; i++) {
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, 1 + i % 32, false)};
+      rows.emplace_back(fields);
+    }
+    return rows;
+  };
+
+  double bulk_seconds = 0;
+  double plain_seconds = 0;
+  for (int begin = 0; begin < row_count; begin += chunk_size) {
+    auto rows = make_chunk(begin);
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->BulkLoad("bulk", rows, GetExecutorContext()));
+    bulk_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    rows = make_chunk(begin);
+    start = std::chrono::steady_clock::now();
+    for (auto &row : rows) {
+      ASSERT_TRUE(plain_table->GetTableHeap()->InsertTuple(row, GetTxn()));
+    }
+    plain_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  std::cout << row_count << " rows: bulk load " << static_cast<uint64_t>(row_count / bulk_seconds)
+            << " rows/s, row by row " << static_cast<uint64_t>(row_count / plain_seconds) << " rows/s" << std::endl;
+
+  // the bulk loaded table holds every row once, in insertion order
+  int expected = 0;
+  TableHeap *table_heap = bulk_table->GetTableHeap();
+  for (auto iter = table_heap->Begin(GetTxn()); iter != table_heap->End(); iter++) {
+    ASSERT_TRUE(iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, expected)));
+    expected++;
+  }
+  ASSERT_EQ(row_count, expected);
+}
+
+TEST_F(ExecutorTest, VacuumTest) {
+  const int row_count = 3000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateTable("vacuum", schema.get(), GetTxn(), table_info));
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id"};
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateIndex("vacuum", "vacuum-index", index_keys, GetTxn(),
+                                                                       index_info, "bptree"));
+  char name[64];
+  memset(name, 'v', sizeof(name));
+  std::vector<Row> rows;
+  for (int i = 0; i < row_count; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, 64, false)};
+    rows.emplace_back(fields);
+  }
+  ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->BulkLoad("vacuum", rows, GetExecutorContext()));
+  // delete the first half of the rows the way DeleteExecutor does
+  for (int i = 0; i < row_count / 2; i++) {
+    ASSERT_TRUE(table_info->GetTableHeap()->MarkDelete(rows[i].GetRowId(), GetTxn()));
+    std::vector<Field> key;
+    key.emplace_back(*rows[i].GetField(0));
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->RemoveEntry(Row(key), rows[i].GetRowId(), GetTxn()));
+  }
+
+  VacuumStats stats;
+  ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->Vacuum("vacuum", GetExecutorContext(), &stats));
+  ASSERT_GT(stats.PagesReclaimed(), 0);
+  ASSERT_GT(stats.rows_moved_, 0);
+  // the index finds every row left at its new place
+  for (int i = row_count / 2; i < row_count; i++) {
+    std::vector<Field> key;
+    key.emplace_back(TypeId::kTypeInt, i);
+    std::vector<RowId> scan_result;
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(Row(key), scan_result, GetTxn()));
+    ASSERT_EQ(1, scan_result.size());
+    Row stored(scan_result[0]);
+    ASSERT_TRUE(table_info->GetTableHeap()->GetTuple(&stored, GetTxn()));
+    ASSERT_TRUE(stored.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, i)));
+  }
+  int count = 0;
+  for (auto iter = table_info->GetTableHeap()->Begin(GetTxn()); iter != table_info->GetTableHeap()->End(); iter++) {
+    count++;
+  }
+  ASSERT_EQ(row_count / 2, count);
+}
+
+// SELECT ts FROM events WHERE ts >= 9500 AND ts < 10000, on a table loaded in ts order
+TEST_F(ExecutorTest, ZoneMapScanTest) {
+  const int row_count = 10000;
+  std::vector<Column *> columns = {new Column("ts", TypeId::kTypeInt, 0, false, false),
+                                   new Column("payload", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateTable("events", schema.get(), GetTxn(), table_info));
+  char payload[64];
+  memset(payload, 'e', sizeof(payload));
+  std::vector<Row> rows;
+  for (int i = 0; i < row_count; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, payload, 64, false)};
+    rows.emplace_back(fields);
+  }
+  ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->BulkLoad("events", rows, GetExecutorContext()));
+
+  const Schema *table_schema = table_info->GetSchema();
+  auto col_ts = MakeColumnValueExpression(*table_schema, 0, "ts");
+  auto lower = MakeComparisonExpression(col_ts, MakeConstantValueExpression(Field(kTypeInt, row_count / 20 * 19)), ">=");
+  auto upper = MakeComparisonExpression(col_ts, MakeConstantValueExpression(Field(kTypeInt, row_count)), "<");
+  auto predicate = MakeLogicExpression(lower, upper, LogicType::And);
+  auto out_schema = MakeOutputSchema({{"ts", col_ts}});
+  auto plan = make_shared<SeqScanPlanNode>(out_schema, table_info->GetTableName(), predicate);
+  // the pages skipped by the zones hold no matching row
+  auto check = [&]() {
+    std::vector<Row> result_set{};
+    GetExecutionEngine()->ExecutePlan(plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(row_count / 20, result_set.size());
+    for (size_t i = 0; i < result_set.size(); i++) {
+      ASSERT_TRUE(result_set[i].GetField(0)->CompareEquals(Field(TypeId::kTypeInt, static_cast<int32_t>(row_count / 20 * 19 + i))));
+    }
+  };
+  check();
+  table_info->GetTableHeap()->GetZoneMap()->Clear();
+  check();
+  table_info->GetTableHeap()->RebuildZoneMap();
+  check();
+}
+
+// SELECT ts FROM events WHERE ts >= 190000 AND ts < 200000, on a table loaded in ts order
+TEST_F(ExecutorTest, DISABLED_ZoneMapScanBenchmark) {
+  const int row_count = 200000;
+  std::vector<Column *> columns = {new Column("ts", TypeId::kTypeInt, 0, false, false),
+                                   new Column("payload", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateTable("events", schema.get(), GetTxn(), table_info));
+  char payload[64];
+  memset(payload, 'e', sizeof(payload));
+  std::vector<Row> rows;
+  for (int i = 0; i < row_count; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, payload, 64, false)};
+    rows.emplace_back(fields);
+  }
+  ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->BulkLoad("events", rows, GetExecutorContext()));
+
+  const Schema *table_schema = table_info->GetSchema();
+  auto col_ts = MakeColumnValueExpression(*table_schema, 0, "ts");
+  auto lower = MakeComparisonExpression(col_ts, MakeConstantValueExpression(Field(kTypeInt, row_count / 20 * 19)), ">=");
+  auto upper = MakeComparisonExpression(col_ts, MakeConstantValueExpression(Field(kTypeInt, row_count)), "<");
+  auto predicate = MakeLogicExpression(lower, upper, LogicType::And);
+  auto out_schema = MakeOutputSchema({{"ts", col_ts}});
+  auto plan = make_shared<SeqScanPlanNode>(out_schema, table_info->GetTableName(), predicate);
+  auto run = [&]() {
+    std::vector<Row> result_set{};
+    auto start = std::chrono::steady_clock::now();
+    GetExecutionEngine()->ExecutePlan(plan, &result_set, GetTxn(), GetExecutorContext());
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(row_count / 20, result_set.size());
+    return elapsed;
+  };
+  double with_zones = run();
+  // without zones every page is read
+  table_info->GetTableHeap()->GetZoneMap()->Clear();
+  double without_zones = run();
+  table_info->GetTableHeap()->RebuildZoneMap();
+  double rebuilt = run();
+  std::cout << "range scan of 5% of " << row_count << " rows: " << without_zones * 1000 << " ms without zone map, "
+            << with_zones * 1000 << " ms with, " << rebuilt * 1000 << " ms after rebuild" << std::endl;
+  EXPECT_LT(with_zones, without_zones);
+}
+
 // UPDATE table-1 SET name = "minisql" where id = 500;
 TEST_F(ExecutorTest, SimpleUpdateTest) {
   // Construct a sequential scan of the table
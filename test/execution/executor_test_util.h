@@ -21,6 +21,7 @@
 #include "planner/expressions/column_value_expression.h"
 #include "planner/expressions/comparison_expression.h"
 #include "planner/expressions/constant_value_expression.h"
+#include "planner/expressions/logic_expression.h"
 #include "utils/utils.h"
 
 /**
@@ -138,6 +139,19 @@ class ExecutorTest : public ::testing::Test {
     return allocated_exprs_.back();
   }
 
+  /**
+   * Make a logic expression.
+   * @param lhs The abstract expression for the left-hand side of the logic computation
+   * @param rhs The abstract expression for the right-hand side of the logic computation
+   * @param logic_type The type of the logic computation operation
+   * @return A non-owning pointer to the LogicExpression
+   */
+  AbstractExpressionRef MakeLogicExpression(AbstractExpressionRef lhs, AbstractExpressionRef rhs,
+                                            LogicType logic_type) {
+    allocated_exprs_.emplace_back(std::make_shared<LogicExpression>(lhs, rhs, logic_type));
+    return allocated_exprs_.back();
+  }
+
   /**
    * Allocate a comparison expression and return it to the caller.
    * @param lhs The abstract expression for the left-hand side of the comparison
@@ -0,0 +1,75 @@
+#ifndef MINISQL_B_PLUS_TREE_CHECK_H
+#define MINISQL_B_PLUS_TREE_CHECK_H
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "index/generic_key.h"
+#include "page/b_plus_tree_internal_page.h"
+#include "page/b_plus_tree_leaf_page.h"
+
+/**
+ * Check the subtree of `page_id`: keys are sorted and within [lower, upper), children point back to their parent,
+ * nodes other than the root are at least half full and all leaves are at the same depth.
+ * Leaves are appended to `leaves` from left to right.
+ * @return number of keys in the subtree
+ */
+inline int CheckSubtree(BufferPoolManager *bpm, const KeyManager &KP, page_id_t page_id, page_id_t parent_id,
+                        GenericKey *lower, GenericKey *upper, int depth, int *leaf_depth, vector<page_id_t> *leaves) {
+  Page *page = bpm->FetchPage(page_id);
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  EXPECT_EQ(parent_id, node->GetParentPageId());
+  EXPECT_LE(node->GetSize(), node->GetMaxSize());
+  EXPECT_GE(node->GetSize(), node->GetMinSize());
+  int count = 0;
+  if (node->IsLeafPage()) {
+    auto *leaf = reinterpret_cast<LeafPage *>(node);
+    if (*leaf_depth < 0) {
+      *leaf_depth = depth;
+    }
+    EXPECT_EQ(*leaf_depth, depth);
+    for (int i = 0; i < leaf->GetSize(); i++) {
+      EXPECT_TRUE(i == 0 || KP.CompareKeys(leaf->KeyAt(i - 1), leaf->KeyAt(i)) < 0);
+      EXPECT_TRUE(lower == nullptr || KP.CompareKeys(lower, leaf->KeyAt(i)) <= 0);
+      EXPECT_TRUE(upper == nullptr || KP.CompareKeys(leaf->KeyAt(i), upper) < 0);
+    }
+    leaves->push_back(page_id);
+    count = leaf->GetSize();
+  } else {
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    for (int i = 0; i < internal->GetSize(); i++) {
+      GenericKey *child_lower = i == 0 ? lower : internal->KeyAt(i);
+      GenericKey *child_upper = i + 1 == internal->GetSize() ? upper : internal->KeyAt(i + 1);
+      count += CheckSubtree(bpm, KP, internal->ValueAt(i), page_id, child_lower, child_upper, depth + 1, leaf_depth,
+                            leaves);
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+  return count;
+}
+
+/**
+ * Check the structure of the whole tree and that the leaf chain visits the leaves in order.
+ * @return number of keys in the tree
+ */
+inline int CheckTree(BufferPoolManager *bpm, const KeyManager &KP, page_id_t root_page_id) {
+  if (root_page_id == INVALID_PAGE_ID) {
+    return 0;
+  }
+  int leaf_depth = -1;
+  vector<page_id_t> leaves;
+  int count = CheckSubtree(bpm, KP, root_page_id, INVALID_PAGE_ID, nullptr, nullptr, 0, &leaf_depth, &leaves);
+  vector<page_id_t> chain;
+  for (page_id_t page_id = leaves.front(); page_id != INVALID_PAGE_ID;) {
+    chain.push_back(page_id);
+    Page *page = bpm->FetchPage(page_id);
+    page_id_t next_page_id = reinterpret_cast<LeafPage *>(page->GetData())->GetNextPageId();
+    bpm->UnpinPage(page->GetPageId(), false);
+    page_id = next_page_id;
+  }
+  EXPECT_EQ(leaves, chain);
+  return count;
+}
+
+#endif  // MINISQL_B_PLUS_TREE_CHECK_H
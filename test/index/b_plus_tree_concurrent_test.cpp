@@ -0,0 +1,210 @@
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+#include "index/b_plus_tree.h"
+#include "index/comparator.h"
+#include "utils/b_plus_tree_check.h"
+#include "utils/utils.h"
+
+static const std::string db_name = "bp_tree_concurrent_test.db";
+
+/**
+ * Keys of a single INT column, key i holds the value i.
+ */
+vector<GenericKey *> MakeIntKeys(const KeyManager &KP, Schema *key_schema, int n) {
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), key_schema);
+    keys.push_back(key);
+  }
+  return keys;
+}
+
+/**
+ * Writers insert and remove keys while scanners run range scans and lookups, then the structure of the tree and
+ * its keys are checked.
+ */
+void InsertRemoveScan(DBStorageEngine &engine, index_id_t index_id, bool optimistic) {
+  std::vector<Column *> columns = {new Column("int", TypeId::kTypeInt, 0, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, 16);
+  // small nodes, so the writers split and merge all the time
+  BPlusTree tree(index_id, engine.bpm_, KP, 8, 8);
+  tree.SetOptimisticLockCoupling(optimistic);
+  const int n = 12000;
+  const int num_writers = 4;
+  const int num_scanners = 2;
+  // key i maps to RowId(i), keys i % 3 == 0 stay in the tree, i % 3 == 1 are inserted and i % 3 == 2 removed
+  vector<GenericKey *> keys = MakeIntKeys(KP, &key_schema, n);
+  vector<int> initial;
+  for (int i = 0; i < n; i++) {
+    if (i % 3 != 1) {
+      initial.push_back(i);
+    }
+  }
+  ShuffleArray(initial);
+  for (int i : initial) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+
+  std::atomic<int> errors{0};
+  std::atomic<int> writers_done{0};
+  std::atomic<int> scans{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_writers; t++) {
+    threads.emplace_back([&, t]() {
+      // every writer owns the keys of every num_writers-th group of three, spread over the whole tree
+      vector<int> work;
+      for (int i = 3 * t; i < n; i += 3 * num_writers) {
+        work.push_back(i + 1);
+        work.push_back(i + 2);
+      }
+      ShuffleArray(work);
+      vector<RowId> result;
+      for (int i : work) {
+        result.clear();
+        if (i % 3 == 1) {
+          errors += !tree.Insert(keys[i], RowId(i));
+          errors += !tree.GetValue(keys[i], result);
+        } else {
+          tree.Remove(keys[i]);
+          errors += tree.GetValue(keys[i], result);
+        }
+      }
+      writers_done++;
+    });
+  }
+  for (int t = 0; t < num_scanners; t++) {
+    threads.emplace_back([&, t]() {
+      std::mt19937 rng(t);
+      std::uniform_int_distribution<int> dist(0, n - 1);
+      vector<RowId> result;
+      while (writers_done < num_writers) {
+        // range scans come out in order and the keys they return match their values
+        int low = dist(rng);
+        int64_t prev = -1;
+        for (auto iter = low % 2 == 0 ? tree.Begin() : tree.Begin(keys[low]); iter != tree.End(); ++iter) {
+          int64_t value = (*iter).second.Get();
+          if (value <= prev || value >= n || KP.CompareKeys(keys[value], (*iter).first) != 0) {
+            errors++;
+          }
+          prev = value;
+        }
+        // keys no writer touches are always found
+        int stable = dist(rng) / 3 * 3;
+        result.clear();
+        if (!tree.GetValue(keys[stable], result) || result[0].Get() != stable) {
+          errors++;
+        }
+        scans++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, errors);
+  EXPECT_GT(scans, 0);
+  ASSERT_TRUE(tree.Check());
+
+  // the tree holds exactly the keys that stay and the ones inserted
+  EXPECT_EQ(n / 3 * 2, CheckTree(engine.bpm_, KP, tree.GetRootPageId()));
+  int expected = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter) {
+    ASSERT_EQ(expected, (*iter).second.Get());
+    expected += expected % 3 == 0 ? 1 : 2;
+  }
+  EXPECT_EQ(n, expected);
+  ASSERT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+TEST(BPlusTreeConcurrentTest, InsertRemoveScanTest) {
+  DBStorageEngine engine(db_name);
+  InsertRemoveScan(engine, 0, false);
+  InsertRemoveScan(engine, 1, true);
+}
+
+/**
+ * Run `total_ops` operations over `num_threads` threads, one in twenty inserts or removes a key of the thread and the
+ * others look up a key that is always there.
+ * @return operations per second
+ */
+double ReadHeavyThroughput(BPlusTree<> &tree, const vector<GenericKey *> &keys, int num_threads, int total_ops,
+                           std::atomic<int> &errors) {
+  const int n = keys.size();
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::mt19937 rng(t);
+      std::uniform_int_distribution<int> dist(0, n / 2 - 1);
+      vector<RowId> result;
+      // odd keys of the thread are inserted and removed again, so the tree ends as it started
+      int written = 2 * t + 1;
+      bool inserted = false;
+      for (int op = 0; op < total_ops / num_threads; op++) {
+        if (op % 20 == 19 && written < n) {
+          if (inserted) {
+            tree.Remove(keys[written]);
+            written += 2 * num_threads;
+          } else {
+            errors += !tree.Insert(keys[written], RowId(written));
+          }
+          inserted = !inserted;
+          continue;
+        }
+        int i = 2 * dist(rng);
+        result.clear();
+        if (!tree.GetValue(keys[i], result) || result[0].Get() != i) {
+          errors++;
+        }
+      }
+      if (inserted) {
+        tree.Remove(keys[written]);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return total_ops / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+TEST(BPlusTreeConcurrentTest, DISABLED_ReadScalingBenchmark) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("int", TypeId::kTypeInt, 0, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, 16);
+  BPlusTree tree(0, engine.bpm_, KP);
+  const int n = 40000;
+  const int total_ops = 128000;
+  vector<GenericKey *> keys = MakeIntKeys(KP, &key_schema, n);
+  for (int i = 0; i < n; i += 2) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+  std::atomic<int> errors{0};
+  for (int num_threads : {1, 4, 16, 64}) {
+    tree.SetOptimisticLockCoupling(false);
+    double latched = ReadHeavyThroughput(tree, keys, num_threads, total_ops, errors);
+    tree.SetOptimisticLockCoupling(true);
+    double optimistic = ReadHeavyThroughput(tree, keys, num_threads, total_ops, errors);
+    std::cout << num_threads << " threads: latch crabbing " << latched / 1000 << " kops/s, optimistic "
+              << optimistic / 1000 << " kops/s" << std::endl;
+  }
+  EXPECT_EQ(0, errors);
+  ASSERT_TRUE(tree.Check());
+  EXPECT_EQ(n / 2, CheckTree(engine.bpm_, KP, tree.GetRootPageId()));
+  for (auto key : keys) {
+    free(key);
+  }
+}
@@ -1,10 +1,12 @@
 #include "index/b_plus_tree_index.h"
 
+#include <chrono>
 #include <string>
 
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "index/generic_key.h"
+#include "utils/utils.h"
 
 static const std::string db_name = "bp_tree_index_test.db";
 
@@ -28,6 +30,71 @@ TEST(BPlusTreeTests, BPlusTreeIndexGenericKeyTest) {
   ASSERT_EQ(0, KP.CompareKeys(k1, k2));
 }
 
+TEST(BPlusTreeTests, MemcomparableKeyTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 1, true, false),
+                                   new Column("name", TypeId::kTypeChar, 8, 2, true, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, 32);
+  // every list is in ascending order, nulls sort first
+  std::vector<std::vector<Field>> values(3);
+  values[0].emplace_back(TypeId::kTypeInt);
+  for (int32_t i : {INT32_MIN, -100, -1, 0, 1, 100, INT32_MAX}) {
+    values[0].emplace_back(TypeId::kTypeInt, i);
+  }
+  values[1].emplace_back(TypeId::kTypeFloat);
+  for (float f : {-1e30f, -2.5f, -1e-30f, 0.0f, 1e-30f, 2.5f, 1e30f}) {
+    values[1].emplace_back(TypeId::kTypeFloat, f);
+  }
+  values[2].emplace_back(TypeId::kTypeChar);
+  for (const char *str : {"", "A", "a", "ab", "abcdefgh", "b", "\xff"}) {
+    values[2].emplace_back(TypeId::kTypeChar, const_cast<char *>(str), strlen(str), true);
+  }
+  // keys differing in one column compare like the values of that column
+  for (uint32_t col = 0; col < 3; col++) {
+    std::vector<GenericKey *> keys;
+    for (auto &value : values[col]) {
+      std::vector<Field> fields{Field(TypeId::kTypeInt, 7), Field(TypeId::kTypeFloat, 0.5f),
+                                Field(TypeId::kTypeChar, const_cast<char *>("x"), 1, true)};
+      fields[col] = Field(value);
+      Row key(fields);
+      keys.push_back(KP.InitKey());
+      KP.SerializeFromKey(keys.back(), key, &key_schema);
+      // decoding gives the values back
+      Row decoded(INVALID_ROWID);
+      KP.DeserializeToKey(keys.back(), decoded, &key_schema);
+      ASSERT_EQ(3, decoded.GetFieldCount());
+      for (uint32_t i = 0; i < 3; i++) {
+        ASSERT_EQ(fields[i].IsNull(), decoded.GetField(i)->IsNull());
+        if (!fields[i].IsNull()) {
+          ASSERT_EQ(CmpBool::kTrue, fields[i].CompareEquals(*decoded.GetField(i)));
+        }
+      }
+    }
+    for (uint32_t i = 0; i < keys.size(); i++) {
+      for (uint32_t j = 0; j < keys.size(); j++) {
+        int cmp = KP.CompareKeys(keys[i], keys[j]);
+        ASSERT_EQ(i < j, cmp < 0);
+        ASSERT_EQ(i == j, cmp == 0);
+      }
+    }
+    for (auto key : keys) {
+      free(key);
+    }
+  }
+  // -0.0 equals 0.0
+  std::vector<Field> zero{Field(TypeId::kTypeInt, 0), Field(TypeId::kTypeFloat, 0.0f), Field(TypeId::kTypeChar)};
+  std::vector<Field> negative_zero{Field(TypeId::kTypeInt, 0), Field(TypeId::kTypeFloat, -0.0f),
+                                   Field(TypeId::kTypeChar)};
+  GenericKey *k1 = KP.InitKey();
+  GenericKey *k2 = KP.InitKey();
+  KP.SerializeFromKey(k1, Row(zero), &key_schema);
+  KP.SerializeFromKey(k2, Row(negative_zero), &key_schema);
+  ASSERT_EQ(0, KP.CompareKeys(k1, k2));
+  free(k1);
+  free(k2);
+}
+
 TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
   //  using INDEX_KEY_TYPE = GenericKey<32>;
   //  using INDEX_COMPARATOR_TYPE = GenericComparator<32>;
@@ -39,7 +106,7 @@ TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
   std::vector<uint32_t> index_key_map{0, 1};
   const TableSchema table_schema(columns);
   auto *index_schema = Schema::ShallowCopySchema(&table_schema, index_key_map);
-  auto *index = new BPlusTreeIndex(0, index_schema, 256, engine.bpm_);
+  auto *index = BPlusTreeIndex::Create(0, index_schema, 256, engine.bpm_);
   for (int i = 0; i < 10; i++) {
     std::vector<Field> fields{Field(TypeId::kTypeInt, i),
                               Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
@@ -66,4 +133,94 @@ TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
     i++;
   }
   delete index;
-}
\ No newline at end of file
+}
+TEST(BPlusTreeTests, BPlusTreeIndexBulkLoadTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false)};
+  std::vector<uint32_t> index_key_map{0};
+  const TableSchema table_schema(columns);
+  auto *index_schema = Schema::ShallowCopySchema(&table_schema, index_key_map);
+  // rows in table order have keys in random order
+  const int n = 5000;
+  vector<int> values;
+  for (int i = 0; i < n; i++) {
+    values.push_back(i);
+  }
+  ShuffleArray(values);
+  auto *index = BPlusTreeIndex::Create(0, index_schema, 16, engine.bpm_);
+  int i = 0;
+  std::vector<Field> fields;
+  ASSERT_EQ(DB_SUCCESS, index->BulkLoad(
+                            [&](Row &key, RowId &row_id) {
+                              if (i == n) {
+                                return false;
+                              }
+                              fields = {Field(TypeId::kTypeInt, values[i])};
+                              key = Row(fields);
+                              row_id = RowId(i++);
+                              return true;
+                            },
+                            nullptr));
+  // the entries come out sorted by key
+  int count = 0;
+  for (auto iter = index->GetBeginIterator(); iter != index->GetEndIterator(); ++iter, count++) {
+    ASSERT_EQ(count, values[(*iter).second.Get()]);
+  }
+  ASSERT_EQ(n, count);
+  ASSERT_TRUE(engine.bpm_->CheckAllUnpinned());
+  delete index;
+}
+
+TEST(BPlusTreeTests, DISABLED_BulkLoadBenchmark) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false)};
+  std::vector<uint32_t> index_key_map{0};
+  const TableSchema table_schema(columns);
+  auto *index_schema = Schema::ShallowCopySchema(&table_schema, index_key_map);
+  // rows in table order have keys in random order
+  const int n = 200000;
+  vector<int> values;
+  for (int i = 0; i < n; i++) {
+    values.push_back(i);
+  }
+  ShuffleArray(values);
+  auto *inserted = BPlusTreeIndex::Create(0, index_schema, 16, engine.bpm_);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, values[i])};
+    ASSERT_EQ(DB_SUCCESS, inserted->InsertEntry(Row(fields), RowId(i), nullptr));
+  }
+  auto insert_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  auto *loaded = BPlusTreeIndex::Create(1, index_schema, 16, engine.bpm_);
+  start = std::chrono::steady_clock::now();
+  int i = 0;
+  std::vector<Field> fields;
+  ASSERT_EQ(DB_SUCCESS, loaded->BulkLoad(
+                            [&](Row &key, RowId &row_id) {
+                              if (i == n) {
+                                return false;
+                              }
+                              fields = {Field(TypeId::kTypeInt, values[i])};
+                              key = Row(fields);
+                              row_id = RowId(i++);
+                              return true;
+                            },
+                            nullptr));
+  auto load_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "index of " << n << " rows: insert " << insert_elapsed * 1000 << " ms, bulk load "
+            << load_elapsed * 1000 << " ms" << std::endl;
+  // both indexes hold the same entries in the same order
+  auto expected = inserted->GetBeginIterator();
+  int count = 0;
+  for (auto iter = loaded->GetBeginIterator(); iter != loaded->GetEndIterator(); ++iter, ++expected, count++) {
+    ASSERT_TRUE(expected != inserted->GetEndIterator());
+    ASSERT_EQ((*expected).second.Get(), (*iter).second.Get());
+    ASSERT_EQ(count, values[(*iter).second.Get()]);
+  }
+  ASSERT_EQ(n, count);
+  ASSERT_TRUE(engine.bpm_->CheckAllUnpinned());
+  delete inserted;
+  delete loaded;
+}
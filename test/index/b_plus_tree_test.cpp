@@ -1,8 +1,11 @@
 #include "index/b_plus_tree.h"
 
+#include <chrono>
+
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "index/comparator.h"
+#include "utils/b_plus_tree_check.h"
 #include "utils/tree_file_mgr.h"
 #include "utils/utils.h"
 
@@ -69,4 +72,279 @@ TEST(BPlusTreeTests, SampleTest) {
     ASSERT_TRUE(tree.GetValue(delete_seq[i], ans));
     ASSERT_EQ(kv_map[delete_seq[i]], ans[ans.size() - 1]);
   }
-}
\ No newline at end of file
+}
+
+TEST(BPlusTreeTests, DISABLED_KeyCompareBenchmark) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, 32);
+  const int n = 20000;
+  vector<GenericKey *> keys;
+  vector<vector<char>> rows;
+  for (int i = 0; i < n; i++) {
+    std::string name = "name" + std::to_string(i % 100);
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i / 100),
+                              Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+    Row key(fields);
+    keys.push_back(KP.InitKey());
+    KP.SerializeFromKey(keys.back(), key, &key_schema);
+    rows.emplace_back(key.GetSerializedSize(&key_schema));
+    key.SerializeTo(rows.back().data(), &key_schema);
+  }
+  // keys stored as rows are compared the way CompareKeys used to, by deserializing both into fields
+  auto compare_rows = [&](const vector<char> &lhs, const vector<char> &rhs) {
+    Row lhs_key(INVALID_ROWID);
+    Row rhs_key(INVALID_ROWID);
+    lhs_key.DeserializeFrom(const_cast<char *>(lhs.data()), &key_schema);
+    rhs_key.DeserializeFrom(const_cast<char *>(rhs.data()), &key_schema);
+    for (uint32_t i = 0; i < key_schema.GetColumnCount(); i++) {
+      if (lhs_key.GetField(i)->CompareLessThan(*rhs_key.GetField(i)) == CmpBool::kTrue) {
+        return true;
+      }
+      if (lhs_key.GetField(i)->CompareGreaterThan(*rhs_key.GetField(i)) == CmpBool::kTrue) {
+        return false;
+      }
+    }
+    return false;
+  };
+  auto start = std::chrono::steady_clock::now();
+  std::sort(rows.begin(), rows.end(), compare_rows);
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(std::binary_search(rows.begin(), rows.end(), rows[i], compare_rows));
+  }
+  auto row_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  auto compare_keys = [&](GenericKey *lhs, GenericKey *rhs) { return KP.CompareKeys(lhs, rhs) < 0; };
+  start = std::chrono::steady_clock::now();
+  std::sort(keys.begin(), keys.end(), compare_keys);
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(std::binary_search(keys.begin(), keys.end(), keys[i], compare_keys));
+  }
+  auto key_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  // both orders agree
+  for (int i = 0; i < n; i++) {
+    Row expected(INVALID_ROWID);
+    Row actual(INVALID_ROWID);
+    expected.DeserializeFrom(rows[i].data(), &key_schema);
+    KP.DeserializeToKey(keys[i], actual, &key_schema);
+    ASSERT_EQ(CmpBool::kTrue, expected.GetField(0)->CompareEquals(*actual.GetField(0)));
+    ASSERT_EQ(CmpBool::kTrue, expected.GetField(1)->CompareEquals(*actual.GetField(1)));
+  }
+  std::cout << "sort and search " << n << " keys: field compare " << row_elapsed * 1000 << " ms, memcmp "
+            << key_elapsed * 1000 << " ms" << std::endl;
+  // the tree itself
+  BPlusTree tree(1, engine.bpm_, KP);
+  ShuffleArray(keys);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+  auto insert_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  vector<RowId> result;
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(tree.GetValue(keys[i], result));
+  }
+  auto lookup_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  ASSERT_EQ(n, result.size());
+  std::cout << "b+ tree of " << n << " keys: insert " << insert_elapsed * 1000 << " ms, lookup "
+            << lookup_elapsed * 1000 << " ms" << std::endl;
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+/**
+ * Insert `keys` into a tree instantiated for KeySize and KeyComparator and look them all up.
+ * @return seconds spent inserting and looking up
+ */
+template <int KeySize, typename KeyComparator = GenericComparator<KeySize>>
+std::pair<double, double> RunTree(DBStorageEngine &engine, index_id_t index_id, const KeyManager &KP,
+                                  const vector<GenericKey *> &keys) {
+  BPlusTree<KeySize, KeyComparator> tree(index_id, engine.bpm_, KP);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+  auto insert_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  vector<RowId> result;
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_TRUE(tree.GetValue(keys[i], result));
+    EXPECT_EQ(RowId(i).Get(), result.back().Get());
+  }
+  auto lookup_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  // keys come out of the iterator in order, a key is only valid until the iterator moves
+  GenericKey *prev = KP.InitKey();
+  size_t count = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter, count++) {
+    if (count > 0) {
+      EXPECT_LT(KP.CompareKeys(prev, (*iter).first), 0);
+    }
+    memcpy(prev, (*iter).first, KP.GetKeySize());
+  }
+  free(prev);
+  EXPECT_EQ(keys.size(), count);
+  EXPECT_TRUE(tree.Check());
+  return {insert_elapsed, lookup_elapsed};
+}
+
+/**
+ * Keys of `key_schema`, an INT column followed by an optional CHAR column, in random order.
+ */
+vector<GenericKey *> MakeKeys(const KeyManager &KP, Schema *key_schema, int n) {
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    std::string name = "key" + std::to_string(n - i);
+    if (key_schema->GetColumnCount() > 1) {
+      fields.emplace_back(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true);
+    }
+    keys.push_back(KP.InitKey());
+    KP.SerializeFromKey(keys.back(), Row(fields), key_schema);
+  }
+  ShuffleArray(keys);
+  return keys;
+}
+
+template <int KeySize>
+void BenchmarkKeySize(DBStorageEngine &engine, int n) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, KeySize - 6, 1, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, KeySize);
+  ASSERT_EQ(KeySize, KeyManager::GetEncodedSize(&key_schema));
+  auto keys = MakeKeys(KP, &key_schema, n);
+  auto runtime = RunTree<0>(engine, 2 * KeySize, KP, keys);
+  auto specialized = RunTree<KeySize>(engine, 2 * KeySize + 1, KP, keys);
+  std::cout << "key size " << KeySize << ": run time width insert " << runtime.first * 1000 << " ms, lookup "
+            << runtime.second * 1000 << " ms; specialized insert " << specialized.first * 1000 << " ms, lookup "
+            << specialized.second * 1000 << " ms" << std::endl;
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+TEST(BPlusTreeTests, DISABLED_InstantiationBenchmark) {
+  DBStorageEngine engine(db_name);
+  const int n = 10000;
+  BenchmarkKeySize<16>(engine, n);
+  BenchmarkKeySize<32>(engine, n);
+  BenchmarkKeySize<64>(engine, n);
+  BenchmarkKeySize<128>(engine, n);
+  BenchmarkKeySize<256>(engine, n);
+  // a single INT column
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, Int32Comparator::KEY_SIZE);
+  ASSERT_TRUE(Int32Comparator::IsApplicable(&key_schema));
+  auto keys = MakeKeys(KP, &key_schema, n);
+  auto runtime = RunTree<0>(engine, 1000, KP, keys);
+  auto generic = RunTree<16>(engine, 1001, KP, keys);
+  auto native = RunTree<Int32Comparator::KEY_SIZE, Int32Comparator>(engine, 1002, KP, keys);
+  std::cout << "int key: run time width insert " << runtime.first * 1000 << " ms, lookup " << runtime.second * 1000
+            << " ms; memcmp insert " << generic.first * 1000 << " ms, lookup " << generic.second * 1000
+            << " ms; native insert " << native.first * 1000 << " ms, lookup " << native.second * 1000 << " ms"
+            << std::endl;
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+template <int KeySize>
+void CheckKeySize(DBStorageEngine &engine, int n) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, KeySize - 6, 1, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, KeySize);
+  ASSERT_EQ(KeySize, KeyManager::GetEncodedSize(&key_schema));
+  auto keys = MakeKeys(KP, &key_schema, n);
+  RunTree<0>(engine, 3 * KeySize, KP, keys);
+  RunTree<KeySize>(engine, 3 * KeySize + 1, KP, keys);
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+TEST(BPlusTreeTests, InstantiationTest) {
+  DBStorageEngine engine(db_name);
+  const int n = 1000;
+  CheckKeySize<16>(engine, n);
+  CheckKeySize<32>(engine, n);
+  CheckKeySize<64>(engine, n);
+  CheckKeySize<128>(engine, n);
+  CheckKeySize<256>(engine, n);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, Int32Comparator::KEY_SIZE);
+  ASSERT_TRUE(Int32Comparator::IsApplicable(&key_schema));
+  auto keys = MakeKeys(KP, &key_schema, n);
+  RunTree<Int32Comparator::KEY_SIZE, Int32Comparator>(engine, 1003, KP, keys);
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, 16);
+  const int max_n = 20000;
+  // key i holds 2 * i, so odd values are missing
+  vector<GenericKey *> keys;
+  for (int i = 0; i <= max_n; i++) {
+    keys.push_back(KP.InitKey());
+    std::vector<Field> fields{Field(TypeId::kTypeInt, 2 * i)};
+    KP.SerializeFromKey(keys.back(), Row(fields), &key_schema);
+  }
+  index_id_t index_id = 2000;
+  for (int max_size : {8, UNDEFINED_SIZE}) {
+    for (double fill_factor : {1.0, DEFAULT_FILL_FACTOR, 0.5, 0.1}) {
+      for (int n : {0, 1, 5, 9, 17, 1000, max_n}) {
+        BPlusTree tree(index_id++, engine.bpm_, KP, max_size, max_size);
+        // every key comes twice, the second one is dropped
+        int i = 0;
+        bool second = false;
+        ASSERT_TRUE(tree.BulkLoad(
+            [&](GenericKey *&key, RowId &value) {
+              if (i == n) {
+                return false;
+              }
+              key = keys[i];
+              value = RowId(second ? -1 : i);
+              i += second;
+              second = !second;
+              return true;
+            },
+            fill_factor));
+        ASSERT_TRUE(tree.Check());
+        ASSERT_EQ(n, CheckTree(engine.bpm_, KP, tree.GetRootPageId()));
+        vector<RowId> result;
+        for (int j = 0; j < n; j++) {
+          ASSERT_TRUE(tree.GetValue(keys[j], result));
+          ASSERT_EQ(j, result.back().Get());
+        }
+        int count = 0;
+        for (auto iter = tree.Begin(); iter != tree.End(); ++iter, count++) {
+          ASSERT_EQ(count, (*iter).second.Get());
+        }
+        ASSERT_EQ(n, count);
+        // a tree with keys is not bulk loaded again
+        ASSERT_EQ(n == 0, tree.BulkLoad([](GenericKey *&, RowId &) { return false; }));
+        // the tree takes inserts and removes as usual
+        ASSERT_TRUE(tree.Insert(keys[n], RowId(n)));
+        for (int j = 0; j < n; j += 2) {
+          tree.Remove(keys[j]);
+        }
+        ASSERT_EQ(n / 2 + 1, CheckTree(engine.bpm_, KP, tree.GetRootPageId()));
+        ASSERT_TRUE(tree.Check());
+        tree.Destroy(tree.GetRootPageId());
+      }
+    }
+  }
+  for (auto key : keys) {
+    free(key);
+  }
+}
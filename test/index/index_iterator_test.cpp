@@ -53,3 +53,48 @@ TEST(BPlusTreeTests, IndexIteratorTest) {
     EXPECT_EQ(RowId((2 * i - 1) * 100), (*iter).second);
   }
 }
+
+TEST(BPlusTreeTests, PinnedLeafDeleteTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("int", TypeId::kTypeInt, 0, false, false)};
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 16);
+  BPlusTree tree(0, engine.bpm_, KP, 8, 8);
+  vector<GenericKey *> keys;
+  for (int i = 0; i < 100; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+    ASSERT_TRUE(tree.Insert(key, RowId(i)));
+  }
+  Page *first_leaf = tree.FindLeafPage(keys[0]);
+  page_id_t second_leaf_id = reinterpret_cast<LeafPage *>(first_leaf->GetData())->GetNextPageId();
+  first_leaf->RUnlatch();
+  engine.bpm_->UnpinPage(first_leaf->GetPageId(), false);
+  {
+    // the iterator on the first leaf pins the second one, which a merge removes from the chain
+    auto iter = tree.Begin();
+    for (int i = 1; i < 12; i++) {
+      tree.Remove(keys[i]);
+    }
+    EXPECT_FALSE(engine.bpm_->IsPageFree(second_leaf_id));
+    std::vector<int> scanned;
+    for (; iter != tree.End(); ++iter) {
+      scanned.push_back((*iter).second.Get());
+    }
+    // the iterator copied the first leaf before the removes, the pairs merged into it later are read again
+    ASSERT_FALSE(scanned.empty());
+    EXPECT_EQ(0, scanned[0]);
+    EXPECT_TRUE(std::is_sorted(scanned.begin(), scanned.end()));
+    EXPECT_EQ(88, std::count_if(scanned.begin(), scanned.end(), [](int i) { return i >= 12; }));
+    EXPECT_EQ(99, scanned.back());
+  }
+  // the next change of the tree deletes the page once the iterator let go of it
+  tree.Remove(keys[99]);
+  EXPECT_TRUE(engine.bpm_->IsPageFree(second_leaf_id));
+  EXPECT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
@@ -0,0 +1,110 @@
+#include "index/index_key_sorter.h"
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+#include "utils/utils.h"
+
+static const std::string db_name = "index_key_sorter_test.db";
+
+/**
+ * Sort `n` pairs whose keys take n / 4 values, pair i is added with RowId(i), and check that they come out ordered by
+ * key, then by the order they were added.
+ */
+void SortAndCheck(DBStorageEngine &engine, int n, size_t memory_size, bool spilled) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 10, 1, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, 32);
+  vector<int> values;
+  for (int i = 0; i < n; i++) {
+    values.push_back(i / 4);
+  }
+  ShuffleArray(values);
+  IndexKeySorter sorter(engine.bpm_, KP, memory_size);
+  GenericKey *key = KP.InitKey();
+  for (int i = 0; i < n; i++) {
+    std::string name = "key" + std::to_string(values[i] % 7);
+    std::vector<Field> fields{Field(TypeId::kTypeInt, values[i] / 7),
+                              Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+    KP.SerializeFromKey(key, Row(fields), &key_schema);
+    sorter.Add(key, RowId(i));
+  }
+  sorter.Sort();
+  EXPECT_EQ(n, sorter.GetSize());
+  EXPECT_EQ(spilled, sorter.GetNumRuns() > 1);
+  GenericKey *sorted_key;
+  RowId row_id;
+  RowId prev_row_id;
+  int count = 0;
+  for (; sorter.Next(&sorted_key, &row_id); count++) {
+    if (count > 0) {
+      int cmp = KP.CompareKeys(key, sorted_key);
+      ASSERT_LE(cmp, 0);
+      ASSERT_TRUE(cmp < 0 || prev_row_id.Get() < row_id.Get());
+    }
+    // the key is the one added with the row id
+    Row row(INVALID_ROWID);
+    KP.DeserializeToKey(sorted_key, row, &key_schema);
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, values[row_id.Get()] / 7)));
+    memcpy(key, sorted_key, KP.GetKeySize());
+    prev_row_id = row_id;
+  }
+  EXPECT_EQ(n, count);
+  EXPECT_FALSE(sorter.Next(&sorted_key, &row_id));
+  EXPECT_TRUE(engine.bpm_->CheckAllUnpinned());
+  free(key);
+}
+
+TEST(IndexKeySorterTest, InMemorySortTest) {
+  DBStorageEngine engine(db_name);
+  SortAndCheck(engine, 0, SORT_MEMORY_SIZE, false);
+  SortAndCheck(engine, 1, SORT_MEMORY_SIZE, false);
+  SortAndCheck(engine, 10000, SORT_MEMORY_SIZE, false);
+}
+
+TEST(IndexKeySorterTest, ExternalSortTest) {
+  DBStorageEngine engine(db_name);
+  // a 64KB buffer holds 1638 pairs of 40 bytes
+  SortAndCheck(engine, 1639, 64 << 10, true);
+  SortAndCheck(engine, 50000, 64 << 10, true);
+  // runs of a single pair
+  SortAndCheck(engine, 100, 1, true);
+}
+
+TEST(IndexKeySorterTest, ReleaseRunsTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, 16);
+  GenericKey *key = KP.InitKey();
+  page_id_t page_id;
+  engine.bpm_->NewPage(page_id);
+  engine.bpm_->UnpinPage(page_id, false);
+  for (int stop : {-1, 0, 5000}) {
+    {
+      // a sorter dropped before or during the merge deletes its runs all the same
+      IndexKeySorter sorter(engine.bpm_, KP, 64 << 10);
+      for (int i = 0; i < 20000; i++) {
+        std::vector<Field> fields{Field(TypeId::kTypeInt, 20000 - i)};
+        KP.SerializeFromKey(key, Row(fields), &key_schema);
+        sorter.Add(key, RowId(i));
+      }
+      ASSERT_GT(sorter.GetNumRuns(), 1);
+      if (stop >= 0) {
+        sorter.Sort();
+        GenericKey *sorted_key;
+        RowId row_id;
+        for (int i = 0; i < stop; i++) {
+          ASSERT_TRUE(sorter.Next(&sorted_key, &row_id));
+          ASSERT_EQ(19999 - i, row_id.Get());
+        }
+      }
+    }
+    EXPECT_TRUE(engine.bpm_->CheckAllUnpinned());
+    // the pages after the last one allocated before the sort are free again
+    for (page_id_t i = page_id + 1; i < page_id + 200; i++) {
+      EXPECT_TRUE(engine.bpm_->IsPageFree(i));
+    }
+  }
+  free(key);
+}
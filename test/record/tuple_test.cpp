@@ -1,10 +1,15 @@
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
+#include <new>
 
+#include "common/arena.h"
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "page/table_page.h"
 #include "record/field.h"
 #include "record/row.h"
+#include "record/row_view.h"
 #include "record/schema.h"
 
 char *chars[] = {const_cast<char *>(""), const_cast<char *>("hello"), const_cast<char *>("world!"),
@@ -26,6 +31,53 @@ Field char_fields[] = {Field(TypeId::kTypeChar, chars[0], strlen(chars[0]), fals
                        Field(TypeId::kTypeChar, chars[3], 1, false)};
 Field null_fields[] = {Field(TypeId::kTypeInt), Field(TypeId::kTypeFloat), Field(TypeId::kTypeChar)};
 
+// heap allocations are only counted on a thread holding an AllocationCounter, so a test can assert that a code path
+// allocates nothing while the other tests linked into the same binary allocate as usual
+static thread_local bool count_allocations = false;
+static thread_local size_t allocation_count = 0;
+
+/** Count the allocations of the current thread while in scope */
+struct AllocationCounter {
+    AllocationCounter() { count_allocations = true; }
+    ~AllocationCounter() { count_allocations = false; }
+};
+
+void *operator new(size_t size) {
+    if (count_allocations) {
+        allocation_count++;
+    }
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+/**
+ * Serialize a row in the format used before fixed offset rows: | Field Nums | Null bitmap size | Null bitmap | Fields |
+ */
+static uint32_t SerializeLegacyRow(const Row &row, char *buf) {
+    uint32_t field_count = row.GetFieldCount();
+    uint32_t null_bitmap_size = field_count / 8 + (field_count % 8 == 0 ? 0 : 1);
+    MACH_WRITE_UINT32(buf, field_count);
+    MACH_WRITE_UINT32(buf + sizeof(uint32_t), null_bitmap_size);
+    char *null_bitmap = buf + 2 * sizeof(uint32_t);
+    memset(null_bitmap, 0, null_bitmap_size);
+    uint32_t offset = 2 * sizeof(uint32_t) + null_bitmap_size;
+    for (uint32_t i = 0; i < field_count; i++) {
+        if (row.GetField(i)->IsNull()) {
+            null_bitmap[i / 8] |= (1 << (i % 8));
+        } else {
+            offset += row.GetField(i)->SerializeTo(buf + offset);
+        }
+    }
+    return offset;
+}
+
 TEST(TupleTest, FieldSerializeDeserializeTest) {
     char buffer[PAGE_SIZE];
     memset(buffer, 0, sizeof(buffer));
@@ -213,11 +265,322 @@ TEST(TupleTest, RowTest) {
     ASSERT_EQ(row.GetRowId(), first_tuple_rid);
     Row row2(row.GetRowId());
     ASSERT_TRUE(table_page.GetTuple(&row2, schema.get(), nullptr, nullptr));
-    std::vector<Field *> &row2_fields = row2.GetFields();
+    Row::FieldList &row2_fields = row2.GetFields();
     ASSERT_EQ(3, row2_fields.size());
     for (size_t i = 0; i < row2_fields.size(); i++) {
-        ASSERT_EQ(CmpBool::kTrue, row2_fields[i]->CompareEquals(fields[i]));
+        ASSERT_EQ(CmpBool::kTrue, row2_fields[i].CompareEquals(fields[i]));
     }
     ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
     table_page.ApplyDelete(row.GetRowId(), nullptr, nullptr);
-}
\ No newline at end of file
+}
+
+TEST(TupleTest, RowViewTest) {
+    TablePage table_page;
+    std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                     new Column("nick", TypeId::kTypeChar, 16, 1, true, false),
+                                     new Column("name", TypeId::kTypeChar, 64, 2, true, false),
+                                     new Column("account", TypeId::kTypeFloat, 3, true, false)};
+    std::vector<Field> fields = {Field(TypeId::kTypeInt, 188), Field(TypeId::kTypeChar),
+                                 Field(TypeId::kTypeChar, const_cast<char *>("minisql"), strlen("minisql"), false),
+                                 Field(TypeId::kTypeFloat, 19.99f)};
+    auto schema = std::make_shared<Schema>(columns);
+    Row row(fields);
+    table_page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+    ASSERT_TRUE(table_page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+    RowView view;
+    ASSERT_TRUE(table_page.GetTupleView(row.GetRowId(), schema.get(), &view));
+    ASSERT_TRUE(view.IsValid());
+    ASSERT_EQ(4, view.GetFieldCount());
+    for (uint32_t i = 0; i < view.GetFieldCount(); i++) {
+        ASSERT_EQ(fields[i].IsNull(), view.IsNull(i));
+        Field field = view.GetField(i);
+        if (!field.IsNull()) {
+            ASSERT_EQ(CmpBool::kTrue, field.CompareEquals(fields[i]));
+        }
+    }
+    // the char field is read in place
+    Field name = view.GetField(2);
+    ASSERT_GE(name.GetData(), table_page.GetData());
+    ASSERT_LT(name.GetData(), table_page.GetData() + PAGE_SIZE);
+    Field other_name(TypeId::kTypeChar, const_cast<char *>("minisqm"), strlen("minisqm"), false);
+    ASSERT_EQ(CmpBool::kTrue, name.CompareLessThan(other_name));
+    ASSERT_EQ(CmpBool::kTrue, view.GetField(0).CompareGreaterThan(Field(TypeId::kTypeInt, 100)));
+    // materialized rows own their data
+    Row full_row(row.GetRowId());
+    view.Materialize(&full_row);
+    ASSERT_EQ(4, full_row.GetFieldCount());
+    ASSERT_EQ(row.GetRowId(), full_row.GetRowId());
+    ASSERT_TRUE(full_row.GetField(1)->IsNull());
+    ASSERT_EQ(CmpBool::kTrue, full_row.GetField(2)->CompareEquals(fields[2]));
+    ASSERT_NE(full_row.GetField(2)->GetData(), name.GetData());
+    Row projected_row;
+    view.Materialize({3, 1, 0}, &projected_row);
+    ASSERT_EQ(3, projected_row.GetFieldCount());
+    ASSERT_EQ(CmpBool::kTrue, projected_row.GetField(0)->CompareEquals(fields[3]));
+    ASSERT_TRUE(projected_row.GetField(1)->IsNull());
+    ASSERT_EQ(CmpBool::kTrue, projected_row.GetField(2)->CompareEquals(fields[0]));
+    ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
+    ASSERT_FALSE(table_page.GetTupleView(row.GetRowId(), schema.get(), &view));
+}
+
+TEST(TupleTest, LegacyRowFormatTest) {
+    std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                     new Column("nick", TypeId::kTypeChar, 16, 1, true, false),
+                                     new Column("name", TypeId::kTypeChar, 64, 2, true, false),
+                                     new Column("account", TypeId::kTypeFloat, 3, true, false)};
+    std::vector<Field> fields = {Field(TypeId::kTypeInt, 188), Field(TypeId::kTypeChar),
+                                 Field(TypeId::kTypeChar, const_cast<char *>("minisql"), strlen("minisql"), false),
+                                 Field(TypeId::kTypeFloat, 19.99f)};
+    auto schema = std::make_shared<Schema>(columns);
+    Row row(fields);
+    char buffer[PAGE_SIZE];
+    uint32_t size = SerializeLegacyRow(row, buffer);
+    // old rows deserialize as before
+    Row legacy_row;
+    ASSERT_EQ(size, legacy_row.DeserializeFrom(buffer, schema.get()));
+    ASSERT_EQ(4, legacy_row.GetFieldCount());
+    for (uint32_t i = 0; i < fields.size(); i++) {
+        ASSERT_EQ(fields[i].IsNull(), legacy_row.GetField(i)->IsNull());
+        if (!fields[i].IsNull()) {
+            ASSERT_EQ(CmpBool::kTrue, legacy_row.GetField(i)->CompareEquals(fields[i]));
+        }
+    }
+    RowView legacy_view(buffer, schema.get());
+    ASSERT_EQ(size, legacy_view.GetSerializedSize());
+    ASSERT_EQ(CmpBool::kTrue, legacy_view.GetField(3).CompareEquals(fields[3]));
+    ASSERT_EQ(CmpBool::kTrue, legacy_view.GetField(2).CompareEquals(fields[2]));
+    // rewriting a row stores it in the fixed offset format, each field sits where the schema says
+    uint32_t new_size = legacy_row.SerializeTo(buffer, schema.get());
+    ASSERT_EQ(new_size, legacy_row.GetSerializedSize(schema.get()));
+    ASSERT_TRUE(MACH_READ_UINT32(buffer) & Row::FIXED_OFFSET_FORMAT);
+    ASSERT_EQ(188, MACH_READ_INT32(buffer + schema->GetFieldOffset(0)));
+    RowView view(buffer, schema.get());
+    ASSERT_EQ(new_size, view.GetSerializedSize());
+    ASSERT_TRUE(view.IsNull(1));
+    ASSERT_EQ(CmpBool::kTrue, view.GetField(2).CompareEquals(fields[2]));
+    ASSERT_EQ(CmpBool::kTrue, view.GetField(3).CompareEquals(fields[3]));
+}
+
+TEST(TupleTest, DISABLED_ProjectionBenchmark) {
+    // a wide table of CHAR, INT and FLOAT columns, the query only needs the last one
+    const uint32_t column_count = 30;
+    const uint32_t row_count = 20000;
+    std::vector<Column *> columns;
+    for (uint32_t i = 0; i < column_count; i++) {
+        std::string name = "c" + std::to_string(i);
+        if (i % 3 == 0) {
+            columns.push_back(new Column(name, TypeId::kTypeChar, 16, i, true, false));
+        } else {
+            columns.push_back(new Column(name, i % 3 == 1 ? TypeId::kTypeInt : TypeId::kTypeFloat, i, true, false));
+        }
+    }
+    auto schema = std::make_shared<Schema>(columns);
+    std::vector<char> legacy_rows(row_count * PAGE_SIZE / 16);
+    std::vector<char> fixed_rows(legacy_rows.size());
+    std::vector<uint32_t> legacy_offsets, fixed_offsets;
+    uint32_t legacy_end = 0, fixed_end = 0;
+    char chars[16];
+    for (uint32_t i = 0; i < row_count; i++) {
+        std::vector<Field> fields;
+        for (uint32_t j = 0; j < column_count; j++) {
+            if (j % 3 == 0) {
+                memset(chars, 'a' + (i + j) % 26, sizeof(chars));
+                fields.emplace_back(TypeId::kTypeChar, chars, 1 + (i + j) % 16, true);
+            } else if (j % 3 == 1) {
+                fields.emplace_back(TypeId::kTypeInt, static_cast<int32_t>(i * j));
+            } else {
+                fields.emplace_back(TypeId::kTypeFloat, static_cast<float>(i) / (j + 1));
+            }
+        }
+        Row row(fields);
+        legacy_offsets.push_back(legacy_end);
+        legacy_end += SerializeLegacyRow(row, legacy_rows.data() + legacy_end);
+        fixed_offsets.push_back(fixed_end);
+        fixed_end += row.SerializeTo(fixed_rows.data() + fixed_end, schema.get());
+        ASSERT_LE(fixed_end, fixed_rows.size());
+    }
+    Field bound(TypeId::kTypeFloat, static_cast<float>(row_count) / (2 * column_count));
+    auto scan = [&](const std::vector<char> &rows, const std::vector<uint32_t> &offsets, bool deserialize) {
+        uint32_t count = 0;
+        for (auto offset : offsets) {
+            if (deserialize) {
+                Row row;
+                row.DeserializeFrom(const_cast<char *>(rows.data() + offset), schema.get());
+                count += row.GetField(column_count - 1)->CompareLessThan(bound) == CmpBool::kTrue;
+            } else {
+                RowView view(rows.data() + offset, schema.get());
+                count += view.GetField(column_count - 1).CompareLessThan(bound) == CmpBool::kTrue;
+            }
+        }
+        return count;
+    };
+    auto time = [&](const std::vector<char> &rows, const std::vector<uint32_t> &offsets, bool deserialize,
+                    uint32_t *count) {
+        auto start = std::chrono::steady_clock::now();
+        *count = scan(rows, offsets, deserialize);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000;
+    };
+    uint32_t row_matches, legacy_matches, fixed_matches;
+    double row_ms = time(fixed_rows, fixed_offsets, true, &row_matches);
+    double legacy_ms = time(legacy_rows, legacy_offsets, false, &legacy_matches);
+    double fixed_ms = time(fixed_rows, fixed_offsets, false, &fixed_matches);
+    ASSERT_EQ(row_count / 2, row_matches);
+    ASSERT_EQ(row_matches, legacy_matches);
+    ASSERT_EQ(row_matches, fixed_matches);
+    std::cout << "projection of 1 of " << column_count << " columns over " << row_count << " rows: deserialized "
+              << row_ms << " ms, legacy view " << legacy_ms << " ms, fixed offset view " << fixed_ms << " ms"
+              << std::endl;
+    EXPECT_LT(fixed_ms, legacy_ms);
+}
+
+TEST(TupleTest, AllocationTest) {
+    // ten columns, CHAR values short enough to be kept inside the fields
+    std::vector<Column *> columns;
+    std::vector<Field> fields;
+    for (uint32_t i = 0; i < 10; i++) {
+        std::string name = "c" + std::to_string(i);
+        if (i % 2 == 0) {
+            columns.push_back(new Column(name, TypeId::kTypeInt, i, true, false));
+            fields.emplace_back(TypeId::kTypeInt, static_cast<int32_t>(i));
+        } else {
+            columns.push_back(new Column(name, TypeId::kTypeChar, 16, i, true, false));
+            fields.emplace_back(TypeId::kTypeChar, const_cast<char *>("minisql"), strlen("minisql"), true);
+        }
+    }
+    auto schema = std::make_shared<Schema>(columns);
+    std::vector<Column *> key_columns = {new Column("c3", TypeId::kTypeChar, 16, 0, true, false),
+                                         new Column("c4", TypeId::kTypeInt, 1, true, false)};
+    auto key_schema = std::make_shared<Schema>(key_columns);
+    TablePage table_page;
+    table_page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+    Row row(fields);
+    const uint32_t row_count = 20;
+    for (uint32_t i = 0; i < row_count; i++) {
+        ASSERT_TRUE(table_page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+    }
+    std::vector<Row> result;
+    result.reserve(row_count);
+    Row scanned;
+    Row key;
+
+    // scan the page as the executors do: deserialize, project, copy and move rows
+    AllocationCounter counter;
+    size_t before = allocation_count;
+    RowId rid;
+    for (bool found = table_page.GetFirstTupleRid(&rid); found; found = table_page.GetNextTupleRid(rid, &rid)) {
+        scanned.SetRowId(rid);
+        ASSERT_TRUE(table_page.GetTuple(&scanned, schema.get(), nullptr, nullptr));
+        RowView view;
+        ASSERT_TRUE(table_page.GetTupleView(rid, schema.get(), &view));
+        view.Materialize(&scanned);
+        scanned.GetKeyFromRow(schema.get(), key_schema.get(), key);
+        Row copy(scanned);
+        copy = key;
+        result.push_back(std::move(scanned));
+    }
+    EXPECT_EQ(before, allocation_count);
+    ASSERT_EQ(row_count, result.size());
+    ASSERT_EQ(2, key.GetFieldCount());
+    ASSERT_EQ(CmpBool::kTrue, key.GetField(0)->CompareEquals(fields[3]));
+    ASSERT_EQ(CmpBool::kTrue, key.GetField(1)->CompareEquals(fields[4]));
+    for (auto &result_row : result) {
+        ASSERT_EQ(10, result_row.GetFieldCount());
+        ASSERT_EQ(CmpBool::kTrue, result_row.GetField(9)->CompareEquals(fields[9]));
+    }
+
+    // a long CHAR value needs one buffer per copy, a move takes it over
+    char long_chars[FIELD_INLINE_LEN * 2];
+    memset(long_chars, 'x', sizeof(long_chars));
+    Field long_field(TypeId::kTypeChar, long_chars, sizeof(long_chars), true);
+    before = allocation_count;
+    Field long_copy(long_field);
+    EXPECT_EQ(before + 1, allocation_count);
+    Field long_moved(std::move(long_copy));
+    EXPECT_EQ(before + 1, allocation_count);
+    ASSERT_EQ(CmpBool::kTrue, long_moved.CompareEquals(long_field));
+    ASSERT_TRUE(long_copy.IsNull());
+    // expressions hand out borrowed fields, a deep copy owns its data again
+    before = allocation_count;
+    Field borrowed = long_field.Borrow();
+    EXPECT_EQ(before, allocation_count);
+    ASSERT_EQ(long_field.GetData(), borrowed.GetData());
+    Field owned = borrowed.DeepCopy();
+    EXPECT_EQ(before + 1, allocation_count);
+    ASSERT_NE(long_field.GetData(), owned.GetData());
+    ASSERT_EQ(CmpBool::kTrue, owned.CompareEquals(long_field));
+    // so does a row: a copy keeps sharing the borrowed data, a deep copy does not
+    std::vector<Field> borrowed_fields{long_field.Borrow()};
+    Row borrowed_row(borrowed_fields);
+    Row shared_row(borrowed_row);
+    ASSERT_EQ(long_field.GetData(), shared_row.GetField(0)->GetData());
+    Row owned_row = borrowed_row.DeepCopy();
+    ASSERT_NE(long_field.GetData(), owned_row.GetField(0)->GetData());
+    ASSERT_EQ(CmpBool::kTrue, owned_row.GetField(0)->CompareEquals(long_field));
+}
+
+TEST(TupleTest, ArenaTest) {
+    Arena arena(1024);
+    char *small = arena.Allocate(3, 1);
+    auto aligned = arena.Allocate(sizeof(int64_t), alignof(int64_t));
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % alignof(int64_t));
+    ASSERT_GE(aligned, small + 3);
+    ASSERT_EQ(1, arena.GetBlockCount());
+    arena.Allocate(600);
+    ASSERT_EQ(1, arena.GetBlockCount());
+    arena.Allocate(700);  // too large for the rest of the block, it gets a block of its own
+    ASSERT_EQ(2, arena.GetBlockCount());
+    arena.Allocate(100);  // still fits in the first block
+    ASSERT_EQ(2, arena.GetBlockCount());
+    arena.Reset();
+    ASSERT_EQ(0, arena.GetAllocatedBytes());
+
+    // long CHAR values of deserialized rows go to the arena instead of one heap buffer per field
+    std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                     new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                     new Column("note", TypeId::kTypeChar, 64, 2, true, false)};
+    auto schema = std::make_shared<Schema>(columns);
+    char chars[64];
+    memset(chars, 'm', sizeof(chars));
+    std::vector<Field> fields = {Field(TypeId::kTypeInt, 1), Field(TypeId::kTypeChar, chars, 64, true),
+                                 Field(TypeId::kTypeChar, chars, 40, true)};
+    Row row(fields);
+    char buffer[PAGE_SIZE];
+    row.SerializeTo(buffer, schema.get());
+    const uint32_t row_count = 10;
+    std::vector<Row> rows(row_count);
+    AllocationCounter counter;
+    size_t before = allocation_count;
+    for (auto &deserialized : rows) {
+        deserialized.DeserializeFrom(buffer, schema.get());
+    }
+    EXPECT_EQ(before + 2 * row_count, allocation_count);
+    // the allocations of arena rows and of their copies do not grow with the number of rows
+    auto arena_allocations = [&](uint32_t count, Arena *row_arena, std::vector<Row> *arena_rows,
+                                 std::vector<Row> *copies) {
+        arena_rows->resize(count);
+        copies->reserve(count);
+        size_t start = allocation_count;
+        for (auto &deserialized : *arena_rows) {
+            deserialized.DeserializeFrom(buffer, schema.get(), row_arena);
+        }
+        for (auto &deserialized : *arena_rows) {
+            copies->emplace_back(deserialized);
+        }
+        return allocation_count - start;
+    };
+    Arena small_arena;
+    std::vector<Row> small_rows;
+    std::vector<Row> small_copies;
+    size_t small_allocations = arena_allocations(row_count, &small_arena, &small_rows, &small_copies);
+    Arena row_arena;
+    std::vector<Row> arena_rows;
+    std::vector<Row> copies;
+    EXPECT_EQ(small_allocations, arena_allocations(2 * row_count, &row_arena, &arena_rows, &copies));
+    // copies share the arena data
+    for (uint32_t i = 0; i < 2 * row_count; i++) {
+        for (uint32_t j = 0; j < fields.size(); j++) {
+            ASSERT_EQ(CmpBool::kTrue, arena_rows[i].GetField(j)->CompareEquals(fields[j]));
+        }
+        ASSERT_EQ(copies[i].GetField(1)->GetData(), arena_rows[i].GetField(1)->GetData());
+    }
+}
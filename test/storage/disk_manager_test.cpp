@@ -1,6 +1,17 @@
 #include "storage/disk_manager.h"
 
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -56,4 +67,358 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
   remove(db_name.c_str());
-}
\ No newline at end of file
+}
+
+TEST(DiskManagerTest, PageReservationTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  DiskManager *disk_mgr = new DiskManager(db_name);
+  // two owners growing in turn, with plain allocations in between
+  std::vector<page_id_t> a{disk_mgr->AllocatePage()};
+  std::vector<page_id_t> b{disk_mgr->AllocatePage()};
+  std::vector<page_id_t> plain;
+  for (int i = 0; i < 3 * PAGE_RESERVATION_SIZE; i++) {
+    a.push_back(disk_mgr->AllocatePage(a.back()));
+    b.push_back(disk_mgr->AllocatePage(b.back()));
+    if (i % 8 == 0) {
+      plain.push_back(disk_mgr->AllocatePage());
+    }
+  }
+  // apart from its first page, each owner only leaves its run at the end of a reservation
+  for (auto pages : {a, b}) {
+    size_t breaks = 0;
+    for (size_t i = 2; i < pages.size(); i++) {
+      if (pages[i] != pages[i - 1] + 1) {
+        breaks++;
+        EXPECT_EQ(0, pages[i] % PAGE_RESERVATION_SIZE);
+      }
+    }
+    EXPECT_LE(breaks, 3);
+  }
+  // plain allocations stay out of the reserved ranges
+  std::unordered_set<page_id_t> reserved;
+  for (auto pages : {a, b}) {
+    for (size_t i = 1; i < pages.size(); i++) {
+      reserved.insert(pages[i] / PAGE_RESERVATION_SIZE);
+    }
+  }
+  for (auto page_id : plain) {
+    EXPECT_EQ(0, reserved.count(page_id / PAGE_RESERVATION_SIZE));
+  }
+  // an emptied reservation is handed out again
+  page_id_t range_begin = a[1] / PAGE_RESERVATION_SIZE * PAGE_RESERVATION_SIZE;
+  for (auto page_id : a) {
+    if (page_id / PAGE_RESERVATION_SIZE == range_begin / PAGE_RESERVATION_SIZE) {
+      disk_mgr->DeAllocatePage(page_id);
+    }
+  }
+  std::vector<page_id_t> reused;
+  for (int i = 0; i < 3 * PAGE_RESERVATION_SIZE; i++) {
+    reused.push_back(disk_mgr->AllocatePage());
+  }
+  EXPECT_TRUE(std::find(reused.begin(), reused.end(), range_begin) != reused.end());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, ReleaseFreeSpaceTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  auto file_stat = [&]() {
+    struct stat stat_buf;
+    EXPECT_EQ(0, stat(db_name.c_str(), &stat_buf));
+    return stat_buf;
+  };
+  auto write_page = [](DiskManager *disk_mgr, page_id_t page_id) {
+    char data[PAGE_SIZE];
+    memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page %d", page_id);
+    disk_mgr->WritePage(page_id, data);
+  };
+  auto check_page = [](DiskManager *disk_mgr, page_id_t page_id) {
+    char data[PAGE_SIZE];
+    disk_mgr->ReadPage(page_id, data);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(data));
+  };
+  const page_id_t page_count = 10 * PAGE_RESERVATION_SIZE;
+  DiskManager *disk_mgr = new DiskManager(db_name);
+  for (page_id_t i = 0; i < page_count; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+    write_page(disk_mgr, i);
+  }
+  disk_mgr->FlushMetadata();
+  auto before = file_stat();
+
+  // free two ranges inside the file and the three ranges at its end
+  for (page_id_t i = 2 * PAGE_RESERVATION_SIZE; i < 4 * PAGE_RESERVATION_SIZE; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  for (page_id_t i = 7 * PAGE_RESERVATION_SIZE; i < page_count; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  disk_mgr->FlushMetadata();
+  auto after = file_stat();
+  // meta page, bitmap page, then the pages up to the last allocated one
+  EXPECT_EQ((7 * PAGE_RESERVATION_SIZE + 2) * PAGE_SIZE, after.st_size);
+  EXPECT_GE(before.st_blocks - after.st_blocks, 5 * PAGE_RESERVATION_SIZE * PAGE_SIZE / 512);
+  for (page_id_t i = 0; i < 7 * PAGE_RESERVATION_SIZE; i++) {
+    if (!disk_mgr->IsPageFree(i)) {
+      check_page(disk_mgr, i);
+    }
+  }
+  char data[PAGE_SIZE];
+  disk_mgr->ReadPage(2 * PAGE_RESERVATION_SIZE, data);
+  EXPECT_EQ(0, data[0]);
+  delete disk_mgr;
+
+  // the freed pages are reused after a restart
+  disk_mgr = new DiskManager(db_name);
+  for (int i = 0; i < 5 * PAGE_RESERVATION_SIZE; i++) {
+    page_id_t page_id = disk_mgr->AllocatePage();
+    ASSERT_TRUE((page_id >= 2 * PAGE_RESERVATION_SIZE && page_id < 4 * PAGE_RESERVATION_SIZE) ||
+                page_id >= 7 * PAGE_RESERVATION_SIZE);
+    write_page(disk_mgr, page_id);
+  }
+  for (page_id_t i = 0; i < page_count; i++) {
+    check_page(disk_mgr, i);
+  }
+  // with every page freed only the meta page is left
+  for (page_id_t i = 0; i < page_count; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  disk_mgr->FlushMetadata();
+  EXPECT_EQ(PAGE_SIZE, file_stat().st_size);
+  EXPECT_EQ(0, reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData())->GetExtentNums());
+  ASSERT_EQ(0, disk_mgr->AllocatePage());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, AllocationPersistenceTest) {
+  std::string db_name = "disk_test.db";
+  const int page_nums = 1000;
+  for (bool direct_io : {false, true}) {
+    remove(db_name.c_str());
+    DiskManager *disk_mgr = new DiskManager(db_name, false, direct_io);
+    for (int i = 0; i < page_nums; i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+    }
+    for (int i = 0; i < page_nums; i += 2) {
+      disk_mgr->DeAllocatePage(i);
+    }
+    delete disk_mgr;
+
+    // the cached allocation state is written back on close
+    disk_mgr = new DiskManager(db_name, false, direct_io);
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+    EXPECT_EQ(page_nums / 2, meta_page->GetAllocatedPages());
+    for (int i = 0; i < page_nums; i++) {
+      ASSERT_EQ(i % 2 == 0, disk_mgr->IsPageFree(i));
+    }
+    ASSERT_EQ(0, disk_mgr->AllocatePage());
+    delete disk_mgr;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, DISABLED_AllocationBenchmark) {
+  std::string db_name = "disk_test.db";
+  const int page_nums = 10000;
+  for (bool direct_io : {false, true}) {
+    remove(db_name.c_str());
+    DiskManager *disk_mgr = new DiskManager(db_name, false, direct_io);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < page_nums; i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+    }
+    double allocate_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < page_nums; i += 2) {
+      disk_mgr->DeAllocatePage(i);
+    }
+    double deallocate_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "direct_io=" << direct_io << ": " << page_nums << " allocations " << allocate_seconds * 1000
+              << " ms, " << page_nums / 2 << " deallocations " << deallocate_seconds * 1000 << " ms" << std::endl;
+    delete disk_mgr;
+
+    // the allocation state is written back on close
+    disk_mgr = new DiskManager(db_name, false, direct_io);
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+    EXPECT_EQ(page_nums / 2, meta_page->GetAllocatedPages());
+    for (int i = 0; i < page_nums; i++) {
+      ASSERT_EQ(i % 2 == 0, disk_mgr->IsPageFree(i));
+    }
+    ASSERT_EQ(0, disk_mgr->AllocatePage());
+    delete disk_mgr;
+  }
+  remove(db_name.c_str());
+}
+
+/**
+ * Random page reads the way the fstream based DiskManager did them: stat() the file, then seek and read on one
+ * shared stream under a lock. Kept as the baseline of the benchmark below.
+ */
+class FstreamPageReader {
+ public:
+  explicit FstreamPageReader(const std::string &file_name) : file_name_(file_name) {
+    db_io_.open(file_name, std::ios::binary | std::ios::in | std::ios::out);
+  }
+
+  void ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    struct stat stat_buf;
+    stat(file_name_.c_str(), &stat_buf);
+    size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
+    if (offset >= static_cast<size_t>(stat_buf.st_size)) {
+      memset(page_data, 0, PAGE_SIZE);
+      return;
+    }
+    db_io_.seekp(offset);
+    db_io_.read(page_data, PAGE_SIZE);
+  }
+
+ private:
+  std::fstream db_io_;
+  std::string file_name_;
+  std::mutex latch_;
+};
+
+TEST(DiskManagerTest, DISABLED_RandomReadBenchmark) {
+  std::string db_name = "disk_bench.db";
+  remove(db_name.c_str());
+  const int num_pages = 4096;
+  const int num_reads = 50000;
+  const int num_threads = 4;
+  auto *disk_mgr = new DiskManager(db_name);
+  char data[PAGE_SIZE];
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+    memset(data, 0, PAGE_SIZE);
+    *reinterpret_cast<page_id_t *>(data) = i;
+    disk_mgr->WritePage(i, data);
+  }
+
+  // one thread per reader, the same random page sequence for both backends
+  auto run = [&](const std::function<void(page_id_t, char *)> &read_page) {
+    std::atomic<int> errors{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t]() {
+        std::mt19937 rng(t);
+        std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+        char buf[PAGE_SIZE];
+        for (int i = 0; i < num_reads / num_threads; i++) {
+          page_id_t page_id = dist(rng);
+          read_page(page_id, buf);
+          if (*reinterpret_cast<page_id_t *>(buf) != page_id) {
+            errors++;
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(0, errors.load());
+    return num_reads / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  double pread_iops = run([&](page_id_t page_id, char *buf) { disk_mgr->ReadPage(page_id, buf); });
+  disk_mgr->Close();
+  FstreamPageReader fstream_reader(db_name);
+  double fstream_iops = run([&](page_id_t page_id, char *buf) {
+    // logical page ids of the first extent are shifted by the meta page and the bitmap page
+    fstream_reader.ReadPhysicalPage(page_id + 2, buf);
+  });
+  std::cout << "random 4K reads, " << num_threads << " threads: fstream IOPS=" << static_cast<uint64_t>(fstream_iops)
+            << " pread IOPS=" << static_cast<uint64_t>(pread_iops) << std::endl;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, AsyncIOTest) {
+  std::string db_name = "disk_async.db";
+  remove(db_name.c_str());
+  const int num_pages = 256;
+  for (bool use_io_uring : {true, false}) {
+    auto *disk_mgr = new DiskManager(db_name, use_io_uring);
+    if (!use_io_uring) {
+      ASSERT_FALSE(disk_mgr->IsAsyncIOEnabled());
+    }
+    std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+    std::vector<IOHandle> handles;
+    for (page_id_t i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+      memset(pages[i].data(), 'a' + i % 26, PAGE_SIZE);
+      *reinterpret_cast<page_id_t *>(pages[i].data()) = i;
+      handles.push_back(disk_mgr->WritePageAsync(i, pages[i].data()));
+    }
+    disk_mgr->SubmitAsync();
+    for (auto &handle : handles) {
+      ASSERT_TRUE(handle.Wait());
+      ASSERT_TRUE(handle.IsDone());
+    }
+    // read back asynchronously in reverse order, and synchronously
+    std::vector<std::vector<char>> read_back(num_pages, std::vector<char>(PAGE_SIZE));
+    handles.clear();
+    for (page_id_t i = num_pages - 1; i >= 0; i--) {
+      handles.push_back(disk_mgr->ReadPageAsync(i, read_back[i].data()));
+    }
+    for (auto &handle : handles) {
+      ASSERT_TRUE(handle.Wait());
+    }
+    char buf[PAGE_SIZE];
+    for (page_id_t i = 0; i < num_pages; i++) {
+      ASSERT_EQ(0, memcmp(pages[i].data(), read_back[i].data(), PAGE_SIZE));
+      disk_mgr->ReadPage(i, buf);
+      ASSERT_EQ(0, memcmp(pages[i].data(), buf, PAGE_SIZE));
+    }
+    // a page past the end of the file reads as zeros
+    memset(buf, 1, PAGE_SIZE);
+    ASSERT_TRUE(disk_mgr->ReadPageAsync(num_pages + 100, buf).Wait());
+    for (char c : buf) {
+      ASSERT_EQ(0, c);
+    }
+    delete disk_mgr;
+    remove(db_name.c_str());
+  }
+}
+
+TEST(DiskManagerTest, DISABLED_BatchedWriteBenchmark) {
+  std::string db_name = "disk_batch.db";
+  const int num_pages = 4096;
+  const int batch_size = 64;
+  const int rounds = 8;
+  std::vector<char> data(static_cast<size_t>(num_pages) * PAGE_SIZE, 'x');
+  auto run = [&](bool use_io_uring) {
+    remove(db_name.c_str());
+    auto *disk_mgr = new DiskManager(db_name, use_io_uring);
+    for (page_id_t i = 0; i < num_pages; i++) {
+      disk_mgr->AllocatePage();
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+      for (page_id_t i = 0; i < num_pages; i += batch_size) {
+        std::vector<IOHandle> handles;
+        for (page_id_t j = i; j < i + batch_size; j++) {
+          handles.push_back(disk_mgr->WritePageAsync(j, data.data() + static_cast<size_t>(j) * PAGE_SIZE));
+        }
+        disk_mgr->SubmitAsync();
+        for (auto &handle : handles) {
+          EXPECT_TRUE(handle.Wait());
+        }
+      }
+    }
+    double iops = num_pages * rounds / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool enabled = disk_mgr->IsAsyncIOEnabled();
+    delete disk_mgr;
+    remove(db_name.c_str());
+    return std::make_pair(iops, enabled);
+  };
+  auto sync = run(false);
+  auto async = run(true);
+  std::cout << "4K writes in batches of " << batch_size << ": pwrite IOPS=" << static_cast<uint64_t>(sync.first)
+            << " io_uring IOPS=" << static_cast<uint64_t>(async.first)
+            << (async.second ? "" : " (io_uring unavailable, fell back to pwrite)") << std::endl;
+}
@@ -1,5 +1,11 @@
 #include "storage/table_heap.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -7,6 +13,7 @@
 #include "gtest/gtest.h"
 #include "record/field.h"
 #include "record/schema.h"
+#include "storage/fragmentation_report.h"
 #include "utils/utils.h"
 
 static string db_file_name = "table_heap_test.db";
@@ -63,3 +70,766 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   delete bpm_;
   delete disk_mgr_;
 }
+
+TEST(TableHeapTest, BufferRingScanTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(64, disk_mgr_);
+  const int row_nums = 8000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+
+  // a plain scan goes through the replacer and evicts most of the pool
+  bpm_->ResetStats();
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); it++) {
+    ASSERT_EQ(kTrue, it->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  auto plain_stats = bpm_->GetStats();
+
+  // a ring scan recycles its own frames
+  bpm_->ResetStats();
+  count = 0;
+  for (auto it = table_heap->Begin(nullptr, DEFAULT_BUFFER_RING_SIZE); it != table_heap->End(); it++) {
+    ASSERT_EQ(kTrue, it->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  auto ring_stats = bpm_->GetStats();
+  std::cout << "plain scan: evictions=" << plain_stats.evictions_ << " ring scan: evictions=" << ring_stats.evictions_
+            << " ring hits=" << ring_stats.ring_hits_ << " ring misses=" << ring_stats.ring_misses_ << std::endl;
+  EXPECT_GT(ring_stats.ring_misses_, 0);
+  EXPECT_LE(ring_stats.evictions_, DEFAULT_BUFFER_RING_SIZE);
+  EXPECT_GT(plain_stats.evictions_, ring_stats.evictions_);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, ReadAheadScanTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 1000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 200, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[200];
+  memset(characters, 'a', sizeof(characters));
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 200, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+  delete table_heap;
+  delete bpm_;
+
+  // a fresh pool makes every page a miss, the scan reads the pages ahead of itself
+  bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id);
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr, 0, DEFAULT_READ_AHEAD_PAGES); it != table_heap->End(); it++) {
+    ASSERT_EQ(kTrue, it->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  EXPECT_GT(bpm_->GetStats().prefetches_, 0);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, DISABLED_ReadAheadScanBenchmark) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  // about 1 GB of heap pages, far more than the pool and the ring hold
+  const int row_nums = (1 << 30) / 200;
+  const int batch_size = 10000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 200, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[200];
+  memset(characters, 'a', sizeof(characters));
+  for (int i = 0; i < row_nums; i += batch_size) {
+    std::vector<Row> rows;
+    for (int j = i; j < std::min(i + batch_size, row_nums); j++) {
+      Fields fields{Field(TypeId::kTypeInt, j), Field(TypeId::kTypeChar, characters, 200, true)};
+      rows.emplace_back(fields);
+    }
+    ASSERT_TRUE(table_heap->InsertTuples(rows, nullptr));
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+
+  for (size_t read_ahead : {0, DEFAULT_READ_AHEAD_PAGES}) {
+    // a fresh pool makes every page a miss, and the OS cache is dropped in case the file system does not do O_DIRECT
+    int fd = open(db_file_name.c_str(), O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    disk_mgr_ = new DiskManager(db_file_name);
+    bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+    TableHeap *cold_heap =
+        TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id);
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (auto it = cold_heap->Begin(nullptr, 0, read_ahead); it != cold_heap->End(); it++) {
+      ASSERT_EQ(kTrue, it->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+      count++;
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_EQ(row_nums, count);
+    auto stats = bpm_->GetStats();
+    std::cout << "read_ahead=" << read_ahead << " cold scan " << elapsed * 1000 << " ms, misses=" << stats.misses_
+              << " prefetched=" << stats.prefetches_ << std::endl;
+    if (read_ahead > 0) {
+      EXPECT_GT(stats.prefetches_, 0);
+    }
+    EXPECT_TRUE(bpm_->CheckAllUnpinned());
+    delete cold_heap;
+    delete bpm_;
+    delete disk_mgr_;
+  }
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 200, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[200];
+  memset(characters, 'a', sizeof(characters));
+  std::vector<RowId> rids;
+  for (int i = 0; i < 2000; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 200, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  // free a whole page in the middle of the heap
+  page_id_t hole = rids[1000].GetPageId();
+  for (auto &rid : rids) {
+    if (rid.GetPageId() == hole) {
+      ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+      table_heap->ApplyDelete(rid, nullptr);
+    }
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+  delete table_heap;
+  delete bpm_;
+
+  // the map survives reopening: the rows fit in the hole and in the last page, no page is appended
+  std::set<page_id_t> pages;
+  for (auto &rid : rids) {
+    pages.insert(rid.GetPageId());
+  }
+  bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id);
+  Fields fields{Field(TypeId::kTypeInt, -1), Field(TypeId::kTypeChar, characters, 200, true)};
+  bool hole_used = false;
+  for (int i = 0; i < 20; i++) {
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    ASSERT_TRUE(pages.count(row.GetRowId().GetPageId()) > 0);
+    hole_used |= row.GetRowId().GetPageId() == hole;
+  }
+  ASSERT_TRUE(hole_used);
+  // a heap opened without its map rebuilds it, and still finds room without appending
+  auto rebuilt_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr);
+  ASSERT_NE(free_space_map_page_id, rebuilt_heap->GetFreeSpaceMapPageId());
+  Row row(fields);
+  ASSERT_TRUE(rebuilt_heap->InsertTuple(row, nullptr));
+  ASSERT_TRUE(pages.count(row.GetRowId().GetPageId()) > 0);
+  delete rebuilt_heap;
+  table_heap->DeleteTable();
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, FreeSpaceMapHoleTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  auto map_entry_count = [&](page_id_t map_page_id) {
+    auto page = bpm_->FetchPage(map_page_id);
+    uint32_t count = reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->GetCount();
+    bpm_->UnpinPage(map_page_id, false);
+    return count;
+  };
+  // the map only stores heap page ids, it never reads the heap pages
+  auto free_space_map = std::make_unique<FreeSpaceMap>(bpm_);
+  page_id_t map_page_id = free_space_map->GetFirstPageId();
+  for (page_id_t heap_page_id = 1000; heap_page_id < 1010; heap_page_id++) {
+    free_space_map->Update(heap_page_id, PAGE_SIZE / 2);
+  }
+  free_space_map->Remove(1003);
+  free_space_map->Remove(1007);
+  free_space_map->Update(1010, PAGE_SIZE / 2);
+  ASSERT_EQ(10, map_entry_count(map_page_id));
+  // the other hole is found again when the map is reopened
+  free_space_map = std::make_unique<FreeSpaceMap>(bpm_, map_page_id);
+  free_space_map->Update(1011, PAGE_SIZE / 2);
+  ASSERT_EQ(10, map_entry_count(map_page_id));
+  free_space_map->Update(1012, PAGE_SIZE / 2);
+  ASSERT_EQ(11, map_entry_count(map_page_id));
+  free_space_map = std::make_unique<FreeSpaceMap>(bpm_, map_page_id);
+  ASSERT_EQ(11, free_space_map->GetPageCount());
+  ASSERT_FALSE(free_space_map->Contains(1003));
+  ASSERT_TRUE(free_space_map->Contains(1011));
+  free_space_map->Destroy();
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, OversizedRowTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const uint32_t length = TablePage::SIZE_MAX_ROW / 2;
+  std::vector<Column *> columns = {new Column("first", TypeId::kTypeChar, length, 0, true, false),
+                                   new Column("second", TypeId::kTypeChar, length, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<char> characters(length, 'a');
+  // the row is smaller than a page but larger than the room of an empty one
+  Fields fields{Field(TypeId::kTypeChar, characters.data(), length, true),
+                Field(TypeId::kTypeChar, characters.data(), length, true)};
+  Row row(fields);
+  ASSERT_GT(row.GetSerializedSize(schema.get()), TablePage::SIZE_MAX_ROW);
+  ASSERT_LT(row.GetSerializedSize(schema.get()), PAGE_SIZE);
+  ASSERT_FALSE(table_heap->InsertTuple(row, nullptr));
+  std::vector<Row> rows{row};
+  ASSERT_FALSE(table_heap->InsertTuples(rows, nullptr));
+  // no page was appended for it
+  Fields small_fields{Field(TypeId::kTypeChar, characters.data(), 10, true),
+                      Field(TypeId::kTypeChar, characters.data(), 10, true)};
+  Row small_row(small_fields);
+  ASSERT_TRUE(table_heap->InsertTuple(small_row, nullptr));
+  ASSERT_EQ(table_heap->GetFirstPageId(), small_row.GetRowId().GetPageId());
+  auto first_page = reinterpret_cast<TablePage *>(bpm_->FetchPage(table_heap->GetFirstPageId()));
+  ASSERT_EQ(INVALID_PAGE_ID, first_page->GetNextPageId());
+  bpm_->UnpinPage(table_heap->GetFirstPageId(), false);
+  table_heap->DeleteTable();
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+/**
+ * Insert the way TableHeap did before the free space map: try every page from the first one, then append.
+ */
+static void ChainWalkInsert(BufferPoolManager *bpm, page_id_t first_page_id, Row &row, Schema *schema) {
+  page_id_t page_id = first_page_id;
+  for (;;) {
+    auto page = reinterpret_cast<TablePage *>(bpm->FetchPage(page_id));
+    if (page->InsertTuple(row, schema, nullptr, nullptr, nullptr)) {
+      bpm->UnpinPage(page_id, true);
+      return;
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    if (next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    page_id = next_page_id;
+  }
+  page_id_t new_page_id;
+  auto new_page = reinterpret_cast<TablePage *>(bpm->NewPage(new_page_id));
+  new_page->Init(new_page_id, page_id, nullptr, nullptr);
+  new_page->InsertTuple(row, schema, nullptr, nullptr, nullptr);
+  bpm->UnpinPage(new_page_id, true);
+  auto old_page = reinterpret_cast<TablePage *>(bpm->FetchPage(page_id));
+  old_page->SetNextPageId(new_page_id);
+  bpm->UnpinPage(page_id, true);
+}
+
+TEST(TableHeapTest, DISABLED_InsertThroughputBenchmark) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 200, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[200];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  TableHeap *walk_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  int size = 0;
+  // rows/s of the inserts growing the table to each size
+  for (int target : {1000, 4000, 16000}) {
+    double fsm_rate = 0;
+    double walk_rate = 0;
+    for (bool use_fsm : {true, false}) {
+      auto start = std::chrono::steady_clock::now();
+      for (int i = size; i < target; i++) {
+        Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 200, true)};
+        Row row(fields);
+        if (use_fsm) {
+          ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+        } else {
+          ChainWalkInsert(bpm_, walk_heap->GetFirstPageId(), row, schema.get());
+        }
+      }
+      (use_fsm ? fsm_rate : walk_rate) =
+          (target - size) / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::cout << "table size " << target << ": free space map " << static_cast<uint64_t>(fsm_rate)
+              << " rows/s, page chain walk " << static_cast<uint64_t>(walk_rate) << " rows/s" << std::endl;
+    size = target;
+  }
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); it++) {
+    count++;
+  }
+  ASSERT_EQ(size, count);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete walk_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, DISABLED_ScanLayoutBenchmark) {
+  const int row_nums = 20000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 200, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[200];
+  memset(characters, 'a', sizeof(characters));
+  for (bool reserve_pages : {false, true}) {
+    // two tables loaded in turn, as concurrent inserts would do
+    remove(db_file_name.c_str());
+    auto disk_mgr_ = new DiskManager(db_file_name);
+    disk_mgr_->SetPageReservation(reserve_pages);
+    auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+    TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+    TableHeap *other_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+    for (int i = 0; i < row_nums; i++) {
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 200, true)};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      Row other_row(fields);
+      ASSERT_TRUE(other_heap->InsertTuple(other_row, nullptr));
+    }
+    auto report =
+        FragmentationReport::FromPageIds(FragmentationReport::TableHeapPageIds(bpm_, table_heap->GetFirstPageId()));
+    if (reserve_pages) {
+      EXPECT_LT(report.runs_, report.pages_ / (PAGE_RESERVATION_SIZE / 2));
+    }
+    page_id_t first_page_id = table_heap->GetFirstPageId();
+    page_id_t free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+    delete table_heap;
+    delete other_heap;
+    delete bpm_;
+    delete disk_mgr_;
+
+    // drop the file from the OS cache, so the scan reads from the device
+    int fd = open(db_file_name.c_str(), O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    disk_mgr_ = new DiskManager(db_file_name);
+    bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+    table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id);
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); it++) {
+      count++;
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_EQ(row_nums, count);
+    std::cout << "reservations " << (reserve_pages ? "on: " : "off: ") << report << ", cold scan " << elapsed * 1000
+              << " ms" << std::endl;
+    delete table_heap;
+    delete bpm_;
+    delete disk_mgr_;
+  }
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, DISABLED_RowViewScanBenchmark) {
+  const int row_nums = 50000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true),
+                  Field(TypeId::kTypeFloat, static_cast<float>(i % 100))};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  // account < 1, one row out of a hundred is emitted
+  Field bound(TypeId::kTypeFloat, 1.0f);
+  auto start = std::chrono::steady_clock::now();
+  int row_count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    if (it->GetField(2)->CompareLessThan(bound) == CmpBool::kTrue) {
+      Row row(*it);
+      row_count++;
+    }
+  }
+  auto row_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  int view_count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    LatchedRowView view = it.GetView();
+    if (view->GetField(2).CompareLessThan(bound) == CmpBool::kTrue) {
+      Row row(it.GetRowId());
+      view->Materialize(&row);
+      view.Release();
+      ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(*it->GetField(0)));
+      view_count++;
+    }
+  }
+  auto view_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  ASSERT_EQ(row_nums / 100, row_count);
+  ASSERT_EQ(row_count, view_count);
+  std::cout << "filtered scan over rows: " << row_elapsed * 1000 << " ms, over views: " << view_elapsed * 1000 << " ms"
+            << std::endl;
+  EXPECT_LT(view_elapsed, row_elapsed);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, DISABLED_VacuumBenchmark) {
+  const int row_nums = 20000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 200, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[200];
+  memset(characters, 'a', sizeof(characters));
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::unordered_map<int64_t, int32_t> row_ids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 200, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    // delete every other row, so every page is left half empty
+    if (i % 2 == 0) {
+      ASSERT_TRUE(table_heap->MarkDelete(row.GetRowId(), nullptr));
+    } else {
+      row_ids[row.GetRowId().Get()] = i;
+    }
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+
+  // reopen the heap with a cold OS cache and scan it
+  auto cold_scan = [&]() {
+    delete table_heap;
+    delete bpm_;
+    delete disk_mgr_;
+    int fd = open(db_file_name.c_str(), O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    disk_mgr_ = new DiskManager(db_file_name);
+    bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+    table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id);
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    // scan the way SeqScanExecutor does
+    for (auto it = table_heap->Begin(nullptr, DEFAULT_BUFFER_RING_SIZE, DEFAULT_READ_AHEAD_PAGES);
+         it != table_heap->End(); it++) {
+      count++;
+    }
+    EXPECT_EQ(row_nums / 2, count);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+  double before = cold_scan();
+  size_t pages_before = FragmentationReport::TableHeapPageIds(bpm_, first_page_id).size();
+
+  std::vector<std::pair<RowId, RowId>> moved;
+  VacuumStats stats = table_heap->Vacuum(&moved, nullptr);
+  ASSERT_EQ(pages_before, stats.pages_before_);
+  ASSERT_EQ(stats.rows_moved_, moved.size());
+  // two half empty pages fit in one
+  ASSERT_LE(stats.pages_after_, (stats.pages_before_ + 1) / 2 + 1);
+  // the rows of the pages cut off the chain moved into the front pages
+  std::unordered_map<int64_t, int32_t> moved_ids;
+  for (auto &[old_rid, new_rid] : moved) {
+    auto it = row_ids.find(old_rid.Get());
+    ASSERT_TRUE(it != row_ids.end());
+    moved_ids[new_rid.Get()] = it->second;
+    row_ids.erase(it);
+  }
+  row_ids.merge(moved_ids);
+  ASSERT_TRUE(moved_ids.empty());
+  ASSERT_EQ(row_nums / 2, row_ids.size());
+  for (auto &[rid, id] : row_ids) {
+    Row row(RowId{rid});
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, id)));
+  }
+  ASSERT_EQ(stats.pages_after_, FragmentationReport::TableHeapPageIds(bpm_, first_page_id).size());
+
+  double after = cold_scan();
+  // removed pages are gone from the reopened free space map, and the freed pages are reused
+  ASSERT_EQ(stats.pages_after_, FreeSpaceMap(bpm_, free_space_map_page_id).GetPageCount());
+  for (int i = 0; i < 100; i++) {
+    Fields fields{Field(TypeId::kTypeInt, row_nums + i), Field(TypeId::kTypeChar, characters, 200, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  std::cout << "pages " << stats.pages_before_ << " -> " << stats.pages_after_ << ", " << stats.rows_moved_
+            << " rows moved, cold scan " << before * 1000 << " -> " << after * 1000 << " ms" << std::endl;
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, VacuumPinnedPageTest) {
+  const int row_nums = 2000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 200, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[200];
+  memset(characters, 'a', sizeof(characters));
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 200, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    if (i % 2 == 0) {
+      ASSERT_TRUE(table_heap->MarkDelete(row.GetRowId(), nullptr));
+    }
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  auto page_ids = FragmentationReport::TableHeapPageIds(bpm_, first_page_id);
+  // a scan still holds the last page when it is cut off the chain
+  page_id_t last_page_id = page_ids.back();
+  ASSERT_NE(nullptr, bpm_->FetchPage(last_page_id));
+  std::vector<std::pair<RowId, RowId>> moved;
+  VacuumStats stats = table_heap->Vacuum(&moved, nullptr);
+  ASSERT_EQ(page_ids.size(), stats.pages_before_);
+  size_t chain_pages = FragmentationReport::TableHeapPageIds(bpm_, first_page_id).size();
+  ASSERT_LT(chain_pages, page_ids.size());
+  // the pinned page is not freed yet and still counts
+  ASSERT_EQ(chain_pages + 1, stats.pages_after_);
+  ASSERT_TRUE(bpm_->IsPagePinned(last_page_id));
+
+  // once unpinned, the next vacuum frees it
+  ASSERT_TRUE(bpm_->UnpinPage(last_page_id, false));
+  moved.clear();
+  stats = table_heap->Vacuum(&moved, nullptr);
+  ASSERT_EQ(chain_pages + 1, stats.pages_before_);
+  ASSERT_EQ(chain_pages, stats.pages_after_);
+  ASSERT_TRUE(moved.empty());
+  ASSERT_TRUE(disk_mgr_->IsPageFree(last_page_id));
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, VacuumKeepsSlotsTest) {
+  const int row_nums = 2000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 200, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[200];
+  memset(characters, 'a', sizeof(characters));
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::unordered_map<int64_t, int32_t> row_ids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 200, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    if (i % 2 == 0) {
+      ASSERT_TRUE(table_heap->MarkDelete(row.GetRowId(), nullptr));
+    } else {
+      row_ids[row.GetRowId().Get()] = i;
+    }
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  std::vector<std::pair<RowId, RowId>> moved;
+  table_heap->Vacuum(&moved, nullptr);
+  auto page_ids = FragmentationReport::TableHeapPageIds(bpm_, first_page_id);
+  std::set<page_id_t> chain(page_ids.begin(), page_ids.end());
+  // only the tuples of the pages cut off the chain moved, into the slots of the deleted ones
+  ASSERT_FALSE(moved.empty());
+  for (auto &[old_rid, new_rid] : moved) {
+    ASSERT_EQ(0, chain.count(old_rid.GetPageId()));
+    ASSERT_EQ(1, chain.count(new_rid.GetPageId()));
+    ASSERT_EQ(0, row_ids.count(new_rid.Get()));
+    row_ids[new_rid.Get()] = row_ids[old_rid.Get()];
+    row_ids.erase(old_rid.Get());
+  }
+  for (auto &[rid, id] : row_ids) {
+    Row row(RowId{rid});
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, id)));
+  }
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, VacuumConcurrentInsertTest) {
+  const int row_nums = 4000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 200, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[200];
+  memset(characters, 'a', sizeof(characters));
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::set<int32_t> ids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 200, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    if (i % 2 == 0) {
+      ASSERT_TRUE(table_heap->MarkDelete(row.GetRowId(), nullptr));
+    } else {
+      ids.insert(i);
+    }
+  }
+  // the rows inserted while the vacuum runs either land in a page that stays or are moved with the others
+  std::thread inserter([&]() {
+    for (int i = row_nums; i < 2 * row_nums; i++) {
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 200, true)};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      ids.insert(i);
+    }
+  });
+  std::vector<std::pair<RowId, RowId>> moved;
+  table_heap->Vacuum(&moved, nullptr);
+  inserter.join();
+  // no row is lost or read twice
+  std::set<int32_t> scanned;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    int32_t id = std::stoi(it->GetField(0)->toString());
+    ASSERT_TRUE(scanned.insert(id).second);
+  }
+  ASSERT_EQ(ids, scanned);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, ZoneMapTest) {
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("score", TypeId::kTypeFloat, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  // ids grow with the insert order, every tenth score is null
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i),
+                  i % 10 == 0 ? Field(TypeId::kTypeFloat) : Field(TypeId::kTypeFloat, static_cast<float>(i))};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  auto pages = FragmentationReport::TableHeapPageIds(bpm_, table_heap->GetFirstPageId());
+  ASSERT_GT(pages.size(), 4);
+  ZoneMap *zone_map = table_heap->GetZoneMap();
+  ASSERT_EQ(pages.size(), zone_map->GetPageCount());
+  // the pages matching a range of ids, checked against the rows they hold
+  auto matching_pages = [&](const std::string &comp_type, int id) {
+    Field value(TypeId::kTypeInt, id);
+    size_t count = 0;
+    for (auto page_id : pages) {
+      count += zone_map->MayMatch(page_id, 0, comp_type, value);
+    }
+    for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); it++) {
+      if (!zone_map->MayMatch(it->GetRowId().GetPageId(), 0, comp_type, value)) {
+        EXPECT_NE(CmpBool::kTrue, comp_type == "<" ? it->GetField(0)->CompareLessThan(value)
+                                                   : it->GetField(0)->CompareGreaterThanEquals(value));
+      }
+    }
+    return count;
+  };
+  EXPECT_EQ(1, matching_pages(">=", row_nums - 1));
+  EXPECT_EQ(1, matching_pages("<", 1));
+  EXPECT_EQ(0, matching_pages(">=", row_nums));
+  EXPECT_TRUE(zone_map->MayMatch(pages[0], 1, "is", Field(TypeId::kTypeFloat)));
+  EXPECT_TRUE(zone_map->MayMatch(pages[0], 1, "not", Field(TypeId::kTypeFloat)));
+
+  // a reopened heap has no zones until they are rebuilt
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id);
+  zone_map = table_heap->GetZoneMap();
+  ASSERT_EQ(0, zone_map->GetPageCount());
+  ASSERT_EQ(pages.size(), matching_pages(">=", row_nums));
+  ASSERT_EQ(pages.size(), table_heap->RebuildZoneMap());
+  ASSERT_EQ(pages.size(), zone_map->GetPageCount());
+  EXPECT_EQ(1, matching_pages(">=", row_nums - 1));
+  // an in place update widens the zone of its page
+  Fields fields{Field(TypeId::kTypeInt, 2 * row_nums), Field(TypeId::kTypeFloat, 0.0f)};
+  Row row(fields);
+  ASSERT_TRUE(table_heap->UpdateTuple(row, table_heap->Begin(nullptr)->GetRowId(), nullptr));
+  EXPECT_TRUE(zone_map->MayMatch(pages[0], 0, "=", Field(TypeId::kTypeInt, 2 * row_nums)));
+  EXPECT_EQ(1, matching_pages(">=", row_nums));
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}